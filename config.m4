@@ -142,6 +142,39 @@ AC_DEFUN([AC_SWOOLE_HAVE_REUSEPORT],
     ])
 ])
 
+AC_DEFUN([AC_SWOOLE_HAVE_IO_URING],
+[
+    AC_MSG_CHECKING([for io_uring])
+    AC_COMPILE_IFELSE([AC_LANG_PROGRAM([[
+        #include <linux/io_uring.h>
+        #include <sys/syscall.h>
+        #include <unistd.h>
+    ]], [[
+        struct io_uring_params p;
+        struct io_uring_getevents_arg arg;
+        int flags = IORING_ENTER_EXT_ARG | IORING_FEAT_EXT_ARG;
+        syscall(__NR_io_uring_setup, 64, &p);
+    ]])],[
+        AC_DEFINE([HAVE_IO_URING], 1, [have io_uring?])
+        AC_MSG_RESULT([yes])
+    ],[
+        AC_MSG_RESULT([no])
+    ])
+    AC_MSG_CHECKING([for io_uring provided buffer ring])
+    AC_COMPILE_IFELSE([AC_LANG_PROGRAM([[
+        #include <linux/io_uring.h>
+    ]], [[
+        struct io_uring_buf_reg reg;
+        struct io_uring_buf_ring *br;
+        int opcode = IORING_REGISTER_PBUF_RING;
+    ]])],[
+        AC_DEFINE([HAVE_IO_URING_PBUF_RING], 1, [have io_uring provided buffer ring?])
+        AC_MSG_RESULT([yes])
+    ],[
+        AC_MSG_RESULT([no])
+    ])
+])
+
 AC_DEFUN([AC_SWOOLE_HAVE_FUTEX],
 [
     AC_MSG_CHECKING([for futex])
@@ -289,6 +322,7 @@ if test "$PHP_SWOOLE" != "no"; then
 
     AC_SWOOLE_CPU_AFFINITY
     AC_SWOOLE_HAVE_REUSEPORT
+    AC_SWOOLE_HAVE_IO_URING
     AC_SWOOLE_HAVE_FUTEX
     AC_SWOOLE_HAVE_UCONTEXT
     AC_SWOOLE_HAVE_BOOST_CONTEXT
@@ -377,6 +411,8 @@ if test "$PHP_SWOOLE" != "no"; then
     fi
 
     AC_CHECK_LIB(c, accept4, AC_DEFINE(HAVE_ACCEPT4, 1, [have accept4]))
+    AC_CHECK_LIB(c, recvmmsg, AC_DEFINE(HAVE_RECVMMSG, 1, [have recvmmsg]))
+    AC_CHECK_LIB(c, sendmmsg, AC_DEFINE(HAVE_SENDMMSG, 1, [have sendmmsg]))
     AC_CHECK_LIB(c, signalfd, AC_DEFINE(HAVE_SIGNALFD, 1, [have signalfd]))
     AC_CHECK_LIB(c, eventfd, AC_DEFINE(HAVE_EVENTFD, 1, [have eventfd]))
     AC_CHECK_LIB(c, epoll_create, AC_DEFINE(HAVE_EPOLL, 1, [have epoll]))
@@ -459,6 +495,7 @@ if test "$PHP_SWOOLE" != "no"; then
         src/core/socket.c \
         src/core/list.c \
         src/core/heap.c \
+        src/core/histogram.c \
         src/core/error.cc \
         src/coroutine/base.cc \
         src/coroutine/boost.cc \
@@ -470,6 +507,7 @@ if test "$PHP_SWOOLE" != "no"; then
         src/memory/global_memory.c \
         src/memory/ring_buffer.c \
         src/memory/fixed_pool.c \
+        src/memory/slab_pool.c \
         src/memory/malloc.c \
         src/memory/table.c \
         src/memory/buffer.c \
@@ -480,10 +518,12 @@ if test "$PHP_SWOOLE" != "no"; then
         src/reactor/select.c \
         src/reactor/poll.c \
         src/reactor/epoll.c \
+        src/reactor/io_uring.c \
         src/reactor/kqueue.c \
         src/pipe/base.c \
         src/pipe/eventfd.c \
         src/pipe/unix_socket.c \
+        src/pipe/shm_ring.c \
         src/lock/semaphore.c \
         src/lock/mutex.c \
         src/lock/rw_lock.c \
@@ -504,6 +544,7 @@ if test "$PHP_SWOOLE" != "no"; then
         src/network/port.c \
         src/network/dns.c \
         src/network/time_wheel.c \
+        src/network/timer_wheel.c \
         src/network/stream.c \
         src/os/base.c \
         src/os/msg_queue.c \
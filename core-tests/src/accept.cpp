@@ -0,0 +1,125 @@
+#include "tests.h"
+#include <vector>
+
+#define ACCEPT_TEST_CLIENTS    5
+#define ACCEPT_TEST_BATCH      3
+#define ACCEPT_TEST_MAX_CONN   4096
+
+static int accept_test_connect(int port)
+{
+    struct sockaddr_in addr;
+    bzero(&addr, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * the budget of a listening port stops the accept loop, the rest of the backlog waits for the next wakeup
+ */
+TEST(accept, batch_budget)
+{
+    swServer serv;
+    swServerStats stats;
+    swServerGS gs;
+    swReactorThread thread;
+    swListenPort ls;
+    std::vector<int> clients;
+    int i;
+
+    bzero(&serv, sizeof(serv));
+    bzero(&stats, sizeof(stats));
+    bzero(&gs, sizeof(gs));
+    bzero(&thread, sizeof(thread));
+    bzero(&ls, sizeof(ls));
+    serv.stats = &stats;
+    serv.gs = &gs;
+    serv.factory_mode = SW_MODE_SINGLE;
+    serv.reactor_num = 1;
+    serv.reactor_threads = &thread;
+    serv.max_connection = ACCEPT_TEST_MAX_CONN;
+    serv.connection_list = (swConnection *) sw_calloc(ACCEPT_TEST_MAX_CONN, sizeof(swConnection));
+    serv.session_list = (swSession *) sw_calloc(SW_SESSION_LIST_SIZE, sizeof(swSession));
+    ASSERT_NE(serv.connection_list, nullptr);
+    ASSERT_NE(serv.session_list, nullptr);
+
+    ASSERT_EQ(swReactor_create(&thread.reactor, SW_REACTOR_MAXEVENTS), SW_OK);
+    thread.reactor.ptr = &serv;
+
+    //listening socket on a random port
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    bzero(&addr, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(sock, 0);
+    ASSERT_EQ(bind(sock, (struct sockaddr *) &addr, sizeof(addr)), 0);
+    ASSERT_EQ(listen(sock, 128), 0);
+    ASSERT_EQ(getsockname(sock, (struct sockaddr *) &addr, &len), 0);
+    swSetNonBlock(sock);
+
+    ls.sock = sock;
+    ls.type = SW_SOCK_TCP;
+    ls.accept_batch = ACCEPT_TEST_BATCH;
+    serv.connection_list[sock].object = &ls;
+
+    for (i = 0; i < ACCEPT_TEST_CLIENTS; i++)
+    {
+        int fd = accept_test_connect(ntohs(addr.sin_port));
+        ASSERT_GE(fd, 0);
+        clients.push_back(fd);
+    }
+
+    swEvent event;
+    bzero(&event, sizeof(event));
+    event.fd = sock;
+    event.type = SW_FD_LISTEN;
+
+    //one wakeup takes accept_batch connections at most
+    ASSERT_EQ(swServer_master_onAccept(&thread.reactor, &event), SW_OK);
+    ASSERT_EQ(ls.accept_count, ACCEPT_TEST_BATCH);
+    ASSERT_EQ(stats.accept_count, ACCEPT_TEST_BATCH);
+    ASSERT_EQ(ls.connection_num, ACCEPT_TEST_BATCH);
+
+    //the rest of the backlog, then EAGAIN
+    ASSERT_EQ(swServer_master_onAccept(&thread.reactor, &event), SW_OK);
+    ASSERT_EQ(ls.accept_count, ACCEPT_TEST_CLIENTS);
+    ASSERT_EQ(stats.accept_count, ACCEPT_TEST_CLIENTS);
+    ASSERT_EQ(ls.reject_count, 0);
+    ASSERT_EQ(ls.emfile_count, 0);
+
+    //too many connections
+    serv.max_connection = 1;
+    int fd = accept_test_connect(ntohs(addr.sin_port));
+    ASSERT_GE(fd, 0);
+    clients.push_back(fd);
+    ASSERT_EQ(swServer_master_onAccept(&thread.reactor, &event), SW_OK);
+    ASSERT_EQ(ls.reject_count, 1);
+    ASSERT_EQ(ls.accept_count, ACCEPT_TEST_CLIENTS);
+
+    for (i = 0; i < ACCEPT_TEST_MAX_CONN; i++)
+    {
+        if (serv.connection_list[i].active)
+        {
+            thread.reactor.del(&thread.reactor, i);
+            close(i);
+        }
+    }
+    for (i = 0; i < (int) clients.size(); i++)
+    {
+        close(clients[i]);
+    }
+    close(sock);
+    thread.reactor.free(&thread.reactor);
+    sw_free(serv.connection_list);
+    sw_free(serv.session_list);
+}
@@ -0,0 +1,52 @@
+#include "tests.h"
+#include <sys/syscall.h>
+
+TEST(affinity, cpu_set)
+{
+    swServer serv;
+    bzero(&serv, sizeof(serv));
+    int cpu_set[] = {2, 4, 6};
+
+    //not pinned
+    ASSERT_EQ(swServer_get_affinity_cpu(&serv, NULL, 0, 1), -1);
+
+    serv.open_cpu_affinity = 1;
+    ASSERT_EQ(swServer_get_affinity_cpu(&serv, NULL, 0, SW_CPU_NUM + 1), 1 % SW_CPU_NUM);
+
+    //the explicit set takes precedence
+    ASSERT_EQ(swServer_get_affinity_cpu(&serv, cpu_set, 3, 0), 2);
+    ASSERT_EQ(swServer_get_affinity_cpu(&serv, cpu_set, 3, 4), 4);
+    serv.open_cpu_affinity = 0;
+    ASSERT_EQ(swServer_get_affinity_cpu(&serv, cpu_set, 3, 5), 6);
+}
+
+TEST(affinity, numa_bind)
+{
+    int node = swoole_get_numa_node();
+    if (node < 0)
+    {
+        GTEST_SKIP() << "the NUMA node is unknown";
+    }
+    size_t size = 1024 * 1024;
+    char *mem = (char *) sw_shm_malloc(size);
+    ASSERT_NE(mem, nullptr);
+    //ENOSYS without NUMA support in the kernel
+    if (sw_shm_bind(mem, node) < 0)
+    {
+        ASSERT_EQ(errno, ENOSYS);
+    }
+    memset(mem, 1, size);
+    ASSERT_EQ(mem[size - 1], 1);
+    sw_shm_free(mem);
+}
+
+TEST(affinity, cpu_numa_node)
+{
+    unsigned cpu, node;
+    if (syscall(SYS_getcpu, &cpu, &node, NULL) < 0 || swoole_get_cpu_numa_node(cpu) < 0)
+    {
+        GTEST_SKIP() << "the NUMA node is unknown";
+    }
+    ASSERT_EQ(swoole_get_cpu_numa_node(cpu), (int) node);
+    ASSERT_EQ(swoole_get_cpu_numa_node(-1), -1);
+}
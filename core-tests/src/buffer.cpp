@@ -0,0 +1,215 @@
+#include "tests.h"
+#include <string>
+
+#define BUFFER_TEST_CHUNKS    200
+
+TEST(buffer, writev)
+{
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    swSetNonBlock(fds[0]);
+    int bufsize = 8192;
+    setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &bufsize, sizeof(bufsize));
+
+    swConnection conn;
+    bzero(&conn, sizeof(conn));
+    conn.fd = fds[0];
+    conn.out_buffer = swBuffer_new(SW_BUFFER_SIZE_STD);
+    ASSERT_NE(conn.out_buffer, nullptr);
+
+    //many small chunks, like pipelined replies
+    std::string expect;
+    int i;
+    for (i = 0; i < BUFFER_TEST_CHUNKS; i++)
+    {
+        std::string reply = "+OK " + std::to_string(i) + std::string(i % 7 * 100, 'x') + "\r\n";
+        swBuffer_chunk *chunk = swBuffer_new_chunk(conn.out_buffer, SW_CHUNK_DATA, reply.length());
+        memcpy(chunk->store.ptr, reply.c_str(), reply.length());
+        chunk->length = reply.length();
+        conn.out_buffer->length += reply.length();
+        expect += reply;
+    }
+
+    std::string result;
+    char buf[65536];
+    int syscalls = 0;
+    while (!swBuffer_empty(conn.out_buffer))
+    {
+        conn.send_wait = 0;
+        ASSERT_EQ(swConnection_buffer_send(&conn) == SW_ERR, conn.send_wait == 1);
+        ASSERT_EQ(conn.close_wait, 0);
+        syscalls++;
+        //the reader drains the socket, the next writev continues from the partially sent chunk
+        ssize_t n;
+        while ((n = recv(fds[1], buf, sizeof(buf), MSG_DONTWAIT)) > 0)
+        {
+            result.append(buf, n);
+        }
+    }
+    ASSERT_EQ(result, expect);
+    ASSERT_LT(syscalls, BUFFER_TEST_CHUNKS / 2);
+
+    swBuffer_free(conn.out_buffer);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST(buffer, dgram_pipe)
+{
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_DGRAM, 0, fds), 0);
+    swSetNonBlock(fds[0]);
+
+    swConnection conn;
+    bzero(&conn, sizeof(conn));
+    conn.fd = fds[0];
+    conn.fdtype = SW_FD_PIPE;
+    conn.out_buffer = swBuffer_new(SW_BUFFER_SIZE_STD);
+    ASSERT_NE(conn.out_buffer, nullptr);
+
+    const char *messages[] = {"msg-one", "msg-two", "msg-three"};
+    int i;
+    for (i = 0; i < 3; i++)
+    {
+        ASSERT_EQ(swBuffer_append(conn.out_buffer, (void *) messages[i], strlen(messages[i])), SW_OK);
+    }
+    while (!swBuffer_empty(conn.out_buffer))
+    {
+        ASSERT_EQ(swConnection_buffer_send(&conn), SW_OK);
+    }
+
+    //the message boundary is kept
+    char buf[256];
+    for (i = 0; i < 3; i++)
+    {
+        ssize_t n = recv(fds[1], buf, sizeof(buf), MSG_DONTWAIT);
+        ASSERT_EQ(std::string(buf, n > 0 ? n : 0), messages[i]);
+    }
+    ASSERT_LT(recv(fds[1], buf, sizeof(buf), MSG_DONTWAIT), 0);
+
+    swBuffer_free(conn.out_buffer);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+#if defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY)
+static int tcp_socketpair(int fds[2])
+{
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    bzero(&addr, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    int lfd = socket(AF_INET, SOCK_STREAM, 0);
+    if (bind(lfd, (struct sockaddr *) &addr, len) < 0 || listen(lfd, 1) < 0
+            || getsockname(lfd, (struct sockaddr *) &addr, &len) < 0)
+    {
+        close(lfd);
+        return SW_ERR;
+    }
+    fds[1] = socket(AF_INET, SOCK_STREAM, 0);
+    if (connect(fds[1], (struct sockaddr *) &addr, len) < 0)
+    {
+        close(lfd);
+        return SW_ERR;
+    }
+    fds[0] = accept(lfd, NULL, NULL);
+    close(lfd);
+    return fds[0] < 0 ? SW_ERR : SW_OK;
+}
+
+TEST(buffer, zerocopy)
+{
+    int fds[2];
+    ASSERT_EQ(tcp_socketpair(fds), SW_OK);
+    swSetNonBlock(fds[0]);
+
+    swConnection conn;
+    bzero(&conn, sizeof(conn));
+    conn.fd = fds[0];
+    int sockopt = 1;
+    if (setsockopt(conn.fd, SOL_SOCKET, SO_ZEROCOPY, &sockopt, sizeof(sockopt)) < 0)
+    {
+        close(fds[0]);
+        close(fds[1]);
+        GTEST_SKIP() << "SO_ZEROCOPY is not supported";
+    }
+    conn.out_buffer = swBuffer_new(SW_BUFFER_SIZE_STD);
+
+    std::string expect;
+    int i;
+    for (i = 0; i < 8; i++)
+    {
+        uint32_t size = 256 * 1024 + i;
+        swBuffer_chunk *chunk = swBuffer_new_chunk(conn.out_buffer, SW_CHUNK_DATA, size);
+        memset(chunk->store.ptr, 'a' + i, size);
+        chunk->length = size;
+        conn.out_buffer->length += size;
+        expect.append(size, 'a' + i);
+    }
+
+    std::string result;
+    char buf[65536];
+    while (!swBuffer_empty(conn.out_buffer) || !swBuffer_empty(conn.zerocopy_buffer))
+    {
+        if (!swBuffer_empty(conn.out_buffer))
+        {
+            conn.send_wait = 0;
+            swConnection_buffer_send_zerocopy(&conn);
+            ASSERT_EQ(conn.close_wait, 0);
+        }
+        ssize_t n;
+        while ((n = recv(fds[1], buf, sizeof(buf), MSG_DONTWAIT)) > 0)
+        {
+            result.append(buf, n);
+        }
+        swConnection_zerocopy_reap(&conn);
+    }
+    ASSERT_EQ(result, expect);
+    ASSERT_GT(conn.zerocopy_seq, 0);
+    ASSERT_EQ(conn.zerocopy_done, conn.zerocopy_seq);
+
+    swBuffer_free(conn.out_buffer);
+    swBuffer_free(conn.zerocopy_buffer);
+    close(fds[0]);
+    close(fds[1]);
+}
+#endif
+
+TEST(buffer, counter)
+{
+    swBuffer_counter counter1, counter2;
+    sw_atomic_long_t total = 0;
+    bzero(&counter1, sizeof(counter1));
+    bzero(&counter2, sizeof(counter2));
+    counter1.total = &total;
+    counter2.total = &total;
+
+    swBuffer *buffer = swBuffer_new(0);
+    swBuffer *other = swBuffer_new(0);
+    char data[1024] = {0};
+    ASSERT_EQ(swBuffer_append(buffer, data, 100), SW_OK);
+
+    //counted from now on
+    swBuffer_set_counter(buffer, &counter1);
+    ASSERT_EQ(counter1.memory, 100);
+    ASSERT_EQ(swBuffer_append(buffer, data, 1000), SW_OK);
+    swBuffer_new_chunk(buffer, SW_CHUNK_CLOSE, 0);
+    ASSERT_EQ(counter1.memory, 1100);
+    ASSERT_EQ(total, 1100);
+
+    //moved to another group
+    other->counter = &counter2;
+    swBuffer_move_chunk(buffer, other);
+    ASSERT_EQ(counter1.memory, 1000);
+    ASSERT_EQ(counter2.memory, 100);
+    ASSERT_EQ(total, 1100);
+
+    swBuffer_pop_chunk(buffer, swBuffer_get_chunk(buffer));
+    ASSERT_EQ(counter1.memory, 0);
+    swBuffer_free(buffer);
+    swBuffer_free(other);
+    ASSERT_EQ(counter2.memory, 0);
+    ASSERT_EQ(total, 0);
+}
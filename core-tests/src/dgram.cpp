@@ -0,0 +1,64 @@
+#include "tests.h"
+
+#ifdef HAVE_SENDMMSG
+static int dgram_test_bind(struct sockaddr_in *addr)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    socklen_t len = sizeof(*addr);
+    bzero(addr, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd, (struct sockaddr *) addr, len);
+    getsockname(fd, (struct sockaddr *) addr, &len);
+    return fd;
+}
+
+/**
+ * every datagram is received alone, whether it is sent with GSO or not
+ */
+TEST(dgram, batch)
+{
+    struct sockaddr_in addr1, addr2;
+    int fd1 = dgram_test_bind(&addr1);
+    int fd2 = dgram_test_bind(&addr2);
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GT(sock, 0);
+
+    swDgramBatch *batch = (swDgramBatch *) sw_malloc(sizeof(swDgramBatch));
+    bzero(batch, offsetof(swDgramBatch, items));
+
+    //4 of the same size and a shorter one to fd1, then one to fd2
+    char data[1000];
+    int i;
+    for (i = 0; i < 5; i++)
+    {
+        memset(data, 'a' + i, sizeof(data));
+        ASSERT_EQ(swDgramBatch_push(batch, sock, data, i == 4 ? 300 : 1000, (struct sockaddr *) &addr1, sizeof(addr1)), SW_OK);
+    }
+    ASSERT_EQ(swDgramBatch_push(batch, sock, (void *) "hello", 5, (struct sockaddr *) &addr2, sizeof(addr2)), SW_OK);
+    ASSERT_EQ(batch->num, 6);
+    swDgramBatch_flush(batch);
+    ASSERT_EQ(batch->num, 0);
+    ASSERT_EQ(batch->length, 0);
+
+    char buf[65536];
+    for (i = 0; i < 5; i++)
+    {
+        ASSERT_EQ(recv(fd1, buf, sizeof(buf), 0), i == 4 ? 300 : 1000);
+        ASSERT_EQ(buf[0], 'a' + i);
+    }
+    ASSERT_EQ(recv(fd2, buf, sizeof(buf), 0), 5);
+    ASSERT_EQ(memcmp(buf, "hello", 5), 0);
+
+    //too large to queue, the queued ones are sent first
+    ASSERT_EQ(swDgramBatch_push(batch, sock, data, 10, (struct sockaddr *) &addr1, sizeof(addr1)), SW_OK);
+    ASSERT_EQ(swDgramBatch_push(batch, sock, buf, sizeof(batch->buffer) + 1, (struct sockaddr *) &addr1, sizeof(addr1)), SW_ERR);
+    ASSERT_EQ(batch->num, 0);
+    ASSERT_EQ(recv(fd1, buf, sizeof(buf), MSG_DONTWAIT), 10);
+
+    sw_free(batch);
+    close(sock);
+    close(fd1);
+    close(fd2);
+}
+#endif
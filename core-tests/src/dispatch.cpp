@@ -0,0 +1,242 @@
+#include "tests.h"
+#include <vector>
+
+#define DISPATCH_TEST_WORKERS    8
+#define DISPATCH_TEST_ROUNDS     100000
+#define DISPATCH_TEST_KEYS       20000
+
+static void dispatch_test_init(swServer *serv, std::vector<swWorker> &workers, int dispatch_mode)
+{
+    bzero(serv, sizeof(*serv));
+    bzero(workers.data(), sizeof(swWorker) * workers.size());
+    serv->worker_num = workers.size();
+    serv->workers = workers.data();
+    serv->dispatch_mode = dispatch_mode;
+}
+
+TEST(dispatch, p2c)
+{
+    swServer serv;
+    std::vector<swWorker> workers(DISPATCH_TEST_WORKERS);
+    dispatch_test_init(&serv, workers, SW_DISPATCH_P2C);
+
+    //the most loaded worker always loses the comparison
+    workers[3].dispatch_count = 100;
+    workers[5].dispatch_count = 10;
+    workers[5].finish_count = 5;
+
+    std::vector<int> count(DISPATCH_TEST_WORKERS);
+    int i;
+    for (i = 0; i < DISPATCH_TEST_ROUNDS; i++)
+    {
+        int worker_id = swServer_worker_schedule(&serv, i, NULL);
+        ASSERT_GE(worker_id, 0);
+        ASSERT_LT(worker_id, DISPATCH_TEST_WORKERS);
+        count[worker_id]++;
+    }
+    ASSERT_EQ(count[3], 0);
+    //worker#5 only wins against worker#3
+    ASSERT_LT(count[5], count[0]);
+    for (i = 0; i < DISPATCH_TEST_WORKERS; i++)
+    {
+        if (i != 3 && i != 5)
+        {
+            ASSERT_GT(count[i], DISPATCH_TEST_ROUNDS / DISPATCH_TEST_WORKERS);
+        }
+    }
+
+    //finished before counted
+    workers[3].finish_count = 101;
+    ASSERT_EQ(swServer_worker_load(&serv, &workers[3]), 0);
+}
+
+TEST(dispatch, ewma)
+{
+    swServer serv;
+    std::vector<swWorker> workers(DISPATCH_TEST_WORKERS);
+    dispatch_test_init(&serv, workers, SW_DISPATCH_EWMA);
+
+    //a slow worker with the same number of messages in flight
+    int i;
+    for (i = 0; i < DISPATCH_TEST_WORKERS; i++)
+    {
+        workers[i].dispatch_count = 2;
+        workers[i].process_usec = 100;
+    }
+    workers[6].process_usec = 5000;
+
+    //an idle worker is cheaper than a busy one, even if it is slower
+    workers[1].dispatch_count = 0;
+    workers[1].process_usec = 200;
+    ASSERT_LT(swServer_worker_load(&serv, &workers[1]), swServer_worker_load(&serv, &workers[0]));
+
+    for (i = 0; i < DISPATCH_TEST_ROUNDS; i++)
+    {
+        ASSERT_NE(swServer_worker_schedule(&serv, i, NULL), 6);
+    }
+}
+
+TEST(dispatch, single_worker)
+{
+    swServer serv;
+    std::vector<swWorker> workers(1);
+    dispatch_test_init(&serv, workers, SW_DISPATCH_P2C);
+    ASSERT_EQ(swServer_worker_schedule(&serv, 1, NULL), 0);
+}
+
+TEST(dispatch, chash)
+{
+    swServer serv;
+    swServerGS gs;
+    std::vector<swWorker> workers(DISPATCH_TEST_WORKERS + 1);
+    std::vector<int> home(DISPATCH_TEST_KEYS);
+    int i;
+
+    //8 workers
+    dispatch_test_init(&serv, workers, SW_DISPATCH_CHASH);
+    //counts the messages in flight, but onConnect/onClose are kept
+    ASSERT_TRUE(swServer_dispatch_count_enable(&serv));
+    ASSERT_FALSE(swServer_dispatch_unbound(&serv));
+    bzero(&gs, sizeof(gs));
+    serv.gs = &gs;
+    serv.worker_num = DISPATCH_TEST_WORKERS;
+    ASSERT_EQ(swServer_create_hash_ring(&serv), SW_OK);
+    std::vector<int> count(DISPATCH_TEST_WORKERS);
+    for (i = 0; i < DISPATCH_TEST_KEYS; i++)
+    {
+        home[i] = swServer_worker_schedule_chash(&serv, i + 1);
+        count[home[i]]++;
+    }
+    for (i = 0; i < DISPATCH_TEST_WORKERS; i++)
+    {
+        ASSERT_GT(count[i], DISPATCH_TEST_KEYS / DISPATCH_TEST_WORKERS / 2);
+    }
+    sw_free(serv.hash_ring);
+
+    //9 workers, a key either stays or moves to the new worker
+    serv.worker_num = DISPATCH_TEST_WORKERS + 1;
+    ASSERT_EQ(swServer_create_hash_ring(&serv), SW_OK);
+    int moved = 0;
+    for (i = 0; i < DISPATCH_TEST_KEYS; i++)
+    {
+        int worker_id = swServer_worker_schedule_chash(&serv, i + 1);
+        if (worker_id != home[i])
+        {
+            ASSERT_EQ(worker_id, DISPATCH_TEST_WORKERS);
+            moved++;
+        }
+    }
+    ASSERT_GT(moved, 0);
+    ASSERT_LT(moved, DISPATCH_TEST_KEYS / 4);
+
+    //a hot worker is skipped, the others keep their keys
+    workers[2].dispatch_count = 1000;
+    gs.dispatch_count = 1000;
+    for (i = 0; i < DISPATCH_TEST_KEYS; i++)
+    {
+        int worker_id = swServer_worker_schedule_chash(&serv, i + 1);
+        ASSERT_NE(worker_id, 2);
+        if (home[i] != 2 && worker_id != DISPATCH_TEST_WORKERS)
+        {
+            ASSERT_EQ(worker_id, home[i]);
+        }
+    }
+    sw_free(serv.hash_ring);
+}
+
+TEST(dispatch, connection_route)
+{
+    swServer serv;
+    swConnection conn;
+    bzero(&serv, sizeof(serv));
+    bzero(&conn, sizeof(conn));
+    conn.from_id = 1;
+
+    //disabled, always the owner of the connection
+    ASSERT_EQ(swServer_connection_route_acquire(&serv, &conn), 1);
+    ASSERT_EQ(conn.route, 0);
+
+    serv.enable_reactor_steal = 1;
+    conn.route = 1 << SW_CONNECTION_ROUTE_SHIFT;
+    ASSERT_EQ(swServer_connection_route_acquire(&serv, &conn), 1);
+    ASSERT_EQ(swServer_connection_route_acquire(&serv, &conn), 1);
+    ASSERT_EQ(conn.route & SW_CONNECTION_ROUTE_MASK, 2);
+
+    //moved with the messages in flight
+    swServer_connection_route_set(&conn, 3);
+    ASSERT_EQ(swServer_connection_route_acquire(&serv, &conn), 3);
+    ASSERT_EQ(conn.route & SW_CONNECTION_ROUTE_MASK, 3);
+
+    swServer_connection_route_release(&serv, &conn);
+    swServer_connection_route_release(&serv, &conn);
+    swServer_connection_route_release(&serv, &conn);
+    ASSERT_EQ(conn.route, 3 << SW_CONNECTION_ROUTE_SHIFT);
+    //never below zero
+    swServer_connection_route_release(&serv, &conn);
+    ASSERT_EQ(conn.route, 3 << SW_CONNECTION_ROUTE_SHIFT);
+
+    //a locked route is only taken when nothing is in flight
+    ASSERT_FALSE(sw_atomic_cmp_set(&conn.route, 0 << SW_CONNECTION_ROUTE_SHIFT, SW_CONNECTION_ROUTE_LOCKED << SW_CONNECTION_ROUTE_SHIFT));
+    ASSERT_TRUE(sw_atomic_cmp_set(&conn.route, 3 << SW_CONNECTION_ROUTE_SHIFT, SW_CONNECTION_ROUTE_LOCKED << SW_CONNECTION_ROUTE_SHIFT));
+    swServer_connection_route_set(&conn, 0);
+    ASSERT_EQ(swServer_connection_route_acquire(&serv, &conn), 0);
+}
+
+TEST(dispatch, autoscale)
+{
+    swServer serv;
+    swServerGS gs;
+    std::vector<swWorker> workers(DISPATCH_TEST_WORKERS);
+    dispatch_test_init(&serv, workers, SW_DISPATCH_P2C);
+    bzero(&gs, sizeof(gs));
+    serv.gs = &gs;
+    serv.min_worker_num = 2;
+    gs.event_workers.run_worker_num = 3;
+
+    //the stopped workers are never chosen
+    int i;
+    for (i = 0; i < DISPATCH_TEST_ROUNDS; i++)
+    {
+        ASSERT_LT(swServer_worker_schedule(&serv, i, NULL), 3);
+    }
+
+    swAutoscale as;
+    bzero(&as, sizeof(as));
+    as.min_num = 2;
+    as.max_num = DISPATCH_TEST_WORKERS;
+
+    //all busy with messages waiting
+    swAutoscaleSample busy = {3, 0, 6, 1000};
+    for (i = 1; i < SW_AUTOSCALE_UP_TICKS; i++)
+    {
+        ASSERT_EQ(swAutoscale_target(&as, &busy), 3);
+    }
+    ASSERT_EQ(swAutoscale_target(&as, &busy), 4);
+    busy.run_num = 6;
+    for (i = 1; i < SW_AUTOSCALE_UP_TICKS; i++)
+    {
+        swAutoscale_target(&as, &busy);
+    }
+    //never above the max
+    ASSERT_EQ(swAutoscale_target(&as, &busy), DISPATCH_TEST_WORKERS);
+
+    //the idle samples must be in a row
+    swAutoscaleSample idle = {DISPATCH_TEST_WORKERS, DISPATCH_TEST_WORKERS, 0, 1000};
+    for (i = 1; i < SW_AUTOSCALE_DOWN_TICKS; i++)
+    {
+        ASSERT_EQ(swAutoscale_target(&as, &idle), DISPATCH_TEST_WORKERS);
+    }
+    ASSERT_EQ(swAutoscale_target(&as, &busy), 6);
+    for (i = 1; i < SW_AUTOSCALE_DOWN_TICKS; i++)
+    {
+        ASSERT_EQ(swAutoscale_target(&as, &idle), DISPATCH_TEST_WORKERS);
+    }
+    ASSERT_EQ(swAutoscale_target(&as, &idle), DISPATCH_TEST_WORKERS - 1);
+
+    //never below the min
+    idle.run_num = idle.idle_num = 2;
+    for (i = 0; i < SW_AUTOSCALE_DOWN_TICKS * 2; i++)
+    {
+        ASSERT_EQ(swAutoscale_target(&as, &idle), 2);
+    }
+}
@@ -0,0 +1,45 @@
+#include "swoole.h"
+#include "histogram.h"
+#include <gtest/gtest.h>
+
+TEST(histogram, bucket)
+{
+    uint64_t values[] = { 0, 1, 7, 8, 9, 15, 16, 100, 1000, 123456789, UINT64_MAX };
+    size_t i;
+    for (i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+    {
+        uint32_t index = swHistogram_bucket_index(values[i]);
+        ASSERT_LT(index, SW_HISTOGRAM_BUCKET_NUM);
+        uint64_t upper = swHistogram_bucket_value(index);
+        ASSERT_GE(upper, values[i]);
+        //relative error
+        ASSERT_LE(upper - values[i], values[i] / SW_HISTOGRAM_SUB_COUNT);
+    }
+}
+
+TEST(histogram, percentile)
+{
+    swHistogram *hist = swHistogram_new();
+    ASSERT_NE(hist, nullptr);
+    ASSERT_EQ(swHistogram_percentile(hist, 99), 0);
+
+    int i;
+    for (i = 1; i <= 1000; i++)
+    {
+        swHistogram_record(hist, i);
+    }
+    ASSERT_EQ(hist->count, 1000);
+    ASSERT_EQ(hist->max, 1000);
+
+    uint64_t p50 = swHistogram_percentile(hist, 50);
+    ASSERT_GE(p50, 500);
+    ASSERT_LE(p50, 500 + 500 / SW_HISTOGRAM_SUB_COUNT);
+    uint64_t p99 = swHistogram_percentile(hist, 99);
+    ASSERT_GE(p99, 990);
+    ASSERT_LE(p99, 1000);
+    ASSERT_EQ(swHistogram_percentile(hist, 100), 1000);
+
+    swHistogram_reset(hist);
+    ASSERT_EQ(hist->count, 0);
+    swHistogram_free(hist);
+}
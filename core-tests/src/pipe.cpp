@@ -47,3 +47,122 @@ TEST(pipe, base)
     ASSERT_GT(ret, 0);
     ASSERT_EQ(strcmp("hello world\n你好中国。\n", data), 0);
 }
+
+TEST(pipe, shm_ring)
+{
+    swShmRing *ring = swShmRing_new(1024);
+    ASSERT_NE(ring, nullptr);
+    char buf[512], data[512];
+    int i, j, n = 0, m = 0;
+    for (i = 0; i < (int) sizeof(data); i++)
+    {
+        data[i] = i;
+    }
+    ASSERT_EQ(swShmRing_pop(ring, buf, sizeof(buf)), 0);
+    ASSERT_EQ(swShmRing_push(ring, data, 600), SW_ERR);
+
+    //wrap around many times with the variable lengths
+    for (i = 0; i < 1000; i++)
+    {
+        while (swShmRing_push(ring, data + (n % 100), 1 + n % 300) == SW_OK)
+        {
+            n++;
+        }
+        for (j = 0; j < 1 + i % 5; j++)
+        {
+            int len = swShmRing_pop(ring, buf, sizeof(buf));
+            if (len == 0)
+            {
+                break;
+            }
+            ASSERT_EQ(len, 1 + m % 300);
+            ASSERT_EQ(memcmp(buf, data + (m % 100), len), 0);
+            m++;
+        }
+    }
+    while (swShmRing_pop(ring, buf, sizeof(buf)) > 0)
+    {
+        m++;
+    }
+    ASSERT_EQ(n, m);
+    ASSERT_TRUE(swShmRing_empty(ring));
+    swShmRing_free(ring);
+}
+
+#define SHM_RING_TEST_NUM    200000
+#define SHM_RING_TEST_BURST  100
+
+static swShmRing *shm_ring_test_ring;
+static swDoorbell shm_ring_test_bell;
+
+static void* shm_ring_test_producer(void *arg)
+{
+    int i;
+    for (i = 0; i < SHM_RING_TEST_NUM; i++)
+    {
+        while (swShmRing_push(shm_ring_test_ring, &i, sizeof(i)) < 0)
+        {
+            swYield();
+        }
+        swDoorbell_ring(&shm_ring_test_bell);
+    }
+    return NULL;
+}
+
+/**
+ * the consumer sleeps on the eventfd, no lost wakeup and much fewer syscalls than messages
+ */
+TEST(pipe, shm_ring_doorbell)
+{
+    shm_ring_test_ring = swShmRing_new(4096);
+    ASSERT_NE(shm_ring_test_ring, nullptr);
+    ASSERT_EQ(swDoorbell_create(&shm_ring_test_bell), SW_OK);
+
+    pthread_t producer;
+    ASSERT_EQ(pthread_create(&producer, NULL, shm_ring_test_producer, NULL), 0);
+
+    int expect = 0, wakeups = 0, value;
+    while (expect < SHM_RING_TEST_NUM)
+    {
+        ASSERT_EQ(swSocket_wait(swDoorbell_getFd(&shm_ring_test_bell), 5000, SW_EVENT_READ), SW_OK);
+        swDoorbell_clear(&shm_ring_test_bell);
+        wakeups++;
+        while (1)
+        {
+            while (swShmRing_pop(shm_ring_test_ring, &value, sizeof(value)) > 0)
+            {
+                ASSERT_EQ(value, expect);
+                expect++;
+            }
+            swDoorbell_sleep(&shm_ring_test_bell);
+            if (swShmRing_empty(shm_ring_test_ring) || !swDoorbell_wakeup(&shm_ring_test_bell))
+            {
+                break;
+            }
+        }
+    }
+    pthread_join(producer, NULL);
+    ASSERT_LT(wakeups, SHM_RING_TEST_NUM);
+
+    //a burst to the sleeping consumer is one write
+    uint64_t flag;
+    while (shm_ring_test_bell.pipe.read(&shm_ring_test_bell.pipe, &flag, sizeof(flag)) > 0);
+    swDoorbell_sleep(&shm_ring_test_bell);
+    for (value = 0; value < SHM_RING_TEST_BURST; value++)
+    {
+        ASSERT_EQ(swShmRing_push(shm_ring_test_ring, &value, sizeof(value)), SW_OK);
+        swDoorbell_ring(&shm_ring_test_bell);
+    }
+    ASSERT_EQ(shm_ring_test_bell.pipe.read(&shm_ring_test_bell.pipe, &flag, sizeof(flag)), sizeof(flag));
+    ASSERT_EQ(flag, 1);
+    ASSERT_LT(shm_ring_test_bell.pipe.read(&shm_ring_test_bell.pipe, &flag, sizeof(flag)), 0);
+    //and nothing while it is awake
+    for (value = 0; value < SHM_RING_TEST_BURST; value++)
+    {
+        swDoorbell_ring(&shm_ring_test_bell);
+    }
+    ASSERT_LT(shm_ring_test_bell.pipe.read(&shm_ring_test_bell.pipe, &flag, sizeof(flag)), 0);
+
+    swDoorbell_free(&shm_ring_test_bell);
+    swShmRing_free(shm_ring_test_ring);
+}
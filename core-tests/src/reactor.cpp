@@ -0,0 +1,354 @@
+#include "tests.h"
+
+static int busy_poll_test_onRead(swReactor *reactor, swEvent *ev)
+{
+    char buf[128];
+    swPipe *p = (swPipe *) reactor->ptr;
+    EXPECT_GT(p->read(p, buf, sizeof(buf)), 0);
+    reactor->del(reactor, ev->fd);
+    reactor->running = 0;
+    return SW_OK;
+}
+
+TEST(reactor, busy_poll)
+{
+    swReactor reactor;
+    swPipe p;
+
+    ASSERT_EQ(swReactor_create(&reactor, SW_REACTOR_MAXEVENTS), SW_OK);
+    reactor.busy_poll_usec = reactor.busy_poll_budget = 1000;
+
+    ASSERT_EQ(swPipeBase_create(&p, 1), SW_OK);
+    reactor.ptr = &p;
+    reactor.setHandle(&reactor, SW_FD_USER, busy_poll_test_onRead);
+    ASSERT_EQ(reactor.add(&reactor, p.getFd(&p, 0), SW_FD_USER | SW_EVENT_READ), SW_OK);
+    ASSERT_GT(p.write(&p, (void *) SW_STRL("hello world") - 1), 0);
+
+    struct timeval timeo = {1, 0};
+    reactor.wait(&reactor, &timeo);
+
+    ASSERT_EQ(reactor.spin_hit_count, 1);
+    ASSERT_EQ(reactor.spin_miss_count, 0);
+    ASSERT_EQ(reactor.block_time, 0);
+    reactor.free(&reactor);
+    p.close(&p);
+}
+
+static void busy_poll_test_onTimeout(swReactor *reactor)
+{
+    reactor->running = 0;
+}
+
+TEST(reactor, busy_poll_timeout)
+{
+    swReactor reactor;
+
+    ASSERT_EQ(swReactor_create(&reactor, SW_REACTOR_MAXEVENTS), SW_OK);
+    //the spin counts against the timeout
+    reactor.busy_poll_usec = reactor.busy_poll_budget = 100 * 1000;
+    reactor.onTimeout = busy_poll_test_onTimeout;
+
+    struct timeval timeo = {0, 200 * 1000};
+    uint64_t begin = swoole_monotonic_usec();
+    reactor.wait(&reactor, &timeo);
+    uint64_t usec = swoole_monotonic_usec() - begin;
+
+    ASSERT_EQ(reactor.spin_miss_count, 1);
+    ASSERT_GE(usec, 190 * 1000);
+    ASSERT_LT(usec, 250 * 1000);
+    reactor.free(&reactor);
+}
+
+static int cached_time_test_onRead(swReactor *reactor, swEvent *ev)
+{
+    //refreshed after the wait returns
+    EXPECT_LE(labs(swReactor_now(reactor) - time(NULL)), 1);
+    EXPECT_LE(labs(swReactor_now_msec(reactor) - (int64_t) (swoole_monotonic_usec() / 1000)), 20);
+    reactor->del(reactor, ev->fd);
+    reactor->running = 0;
+    return SW_OK;
+}
+
+TEST(reactor, cached_time)
+{
+    swReactor reactor;
+    swPipe p;
+
+    ASSERT_EQ(swReactor_create(&reactor, SW_REACTOR_MAXEVENTS), SW_OK);
+    ASSERT_EQ(reactor.now, 0);
+    ASSERT_EQ(swPipeBase_create(&p, 1), SW_OK);
+    reactor.setHandle(&reactor, SW_FD_USER, cached_time_test_onRead);
+    ASSERT_EQ(reactor.add(&reactor, p.getFd(&p, 0), SW_FD_USER | SW_EVENT_READ), SW_OK);
+    ASSERT_GT(p.write(&p, (void *) SW_STRL("hello world") - 1), 0);
+
+    struct timeval timeo = {1, 0};
+    reactor.wait(&reactor, &timeo);
+    ASSERT_GT(reactor.now, 0);
+    ASSERT_GT(reactor.now_msec, 0);
+    reactor.free(&reactor);
+    p.close(&p);
+}
+
+#define DISPATCH_BENCH_PIPES   64
+#define DISPATCH_BENCH_EVENTS  1000000
+
+static int dispatch_bench_count = 0;
+static int dispatch_bench_type_count[SW_MAX_FDTYPE];
+
+static int dispatch_bench_onRead(swReactor *reactor, swEvent *ev)
+{
+    //never read, the level-triggered pipes stay readable
+    dispatch_bench_type_count[ev->type]++;
+    if (++dispatch_bench_count >= DISPATCH_BENCH_EVENTS)
+    {
+        reactor->running = 0;
+    }
+    return SW_OK;
+}
+
+/**
+ * dispatch overhead per event: epoll_wait is amortized over DISPATCH_BENCH_PIPES events
+ */
+static void dispatch_bench_run(const int *fdtypes, int *ns_per_event)
+{
+    swReactor reactor;
+    swPipe pipes[DISPATCH_BENCH_PIPES];
+    int i;
+
+    dispatch_bench_count = 0;
+    bzero(dispatch_bench_type_count, sizeof(dispatch_bench_type_count));
+
+    ASSERT_EQ(swReactor_create(&reactor, SW_REACTOR_MAXEVENTS), SW_OK);
+    for (i = 0; i < 3; i++)
+    {
+        reactor.setHandle(&reactor, fdtypes[i], dispatch_bench_onRead);
+    }
+    for (i = 0; i < DISPATCH_BENCH_PIPES; i++)
+    {
+        ASSERT_EQ(swPipeBase_create(&pipes[i], 1), SW_OK);
+        ASSERT_EQ(reactor.add(&reactor, pipes[i].getFd(&pipes[i], 0), fdtypes[i % 3] | SW_EVENT_READ), SW_OK);
+        ASSERT_GT(pipes[i].write(&pipes[i], (void *) "x", 1), 0);
+    }
+
+    struct timeval timeo = {1, 0};
+    uint64_t begin = swoole_monotonic_usec();
+    reactor.wait(&reactor, &timeo);
+    uint64_t usec = swoole_monotonic_usec() - begin;
+
+    ASSERT_GE(dispatch_bench_count, DISPATCH_BENCH_EVENTS);
+    for (i = 0; i < 3; i++)
+    {
+        //21 or 22 of the pipes each
+        ASSERT_GE(dispatch_bench_type_count[fdtypes[i]], DISPATCH_BENCH_EVENTS / 4);
+    }
+    *ns_per_event = (int) (usec * 1000 / dispatch_bench_count);
+
+    for (i = 0; i < DISPATCH_BENCH_PIPES; i++)
+    {
+        reactor.del(&reactor, pipes[i].getFd(&pipes[i], 0));
+        pipes[i].close(&pipes[i]);
+    }
+    reactor.free(&reactor);
+}
+
+TEST(reactor, dispatch_hot_handle)
+{
+    swReactor reactor;
+    ASSERT_EQ(swReactor_create(&reactor, SW_REACTOR_MAXEVENTS), SW_OK);
+    reactor.setHandle(&reactor, SW_FD_TCP | SW_EVENT_READ, dispatch_bench_onRead);
+    reactor.setHandle(&reactor, SW_FD_PIPE, dispatch_bench_onRead);
+    reactor.setHandle(&reactor, SW_FD_LISTEN, dispatch_bench_onRead);
+    //the write handlers are not cached
+    reactor.setHandle(&reactor, SW_FD_TCP | SW_EVENT_WRITE, NULL);
+#ifdef SW_REACTOR_FAST_DISPATCH
+    ASSERT_EQ(reactor.tcp_read_handle, dispatch_bench_onRead);
+    ASSERT_EQ(reactor.pipe_read_handle, dispatch_bench_onRead);
+    ASSERT_EQ(reactor.listen_read_handle, dispatch_bench_onRead);
+#endif
+    reactor.free(&reactor);
+}
+
+/**
+ * SW_FD_TCP/SW_FD_PIPE/SW_FD_LISTEN take the hot path, SW_FD_USER+n the handle[] table
+ */
+TEST(reactor, dispatch_benchmark)
+{
+    const int hot_fdtypes[3] = {SW_FD_TCP, SW_FD_PIPE, SW_FD_LISTEN};
+    const int table_fdtypes[3] = {SW_FD_USER, SW_FD_USER + 1, SW_FD_USER + 2};
+    int hot_ns, table_ns;
+
+    dispatch_bench_run(hot_fdtypes, &hot_ns);
+    ASSERT_FALSE(HasFatalFailure());
+    dispatch_bench_run(table_fdtypes, &table_ns);
+    ASSERT_FALSE(HasFatalFailure());
+
+    RecordProperty("hot_ns_per_event", hot_ns);
+    RecordProperty("table_ns_per_event", table_ns);
+}
+
+#ifdef HAVE_IO_URING
+static int io_uring_test_read_count = 0;
+
+static int io_uring_test_onRead(swReactor *reactor, swEvent *ev)
+{
+    char buf[128];
+    swPipe *p = (swPipe *) reactor->ptr;
+    int n = p->read(p, buf, sizeof(buf));
+    EXPECT_GT(n, 0);
+    io_uring_test_read_count++;
+    if (io_uring_test_read_count < 3)
+    {
+        p->write(p, (void *) SW_STRL("hello world") - 1);
+    }
+    else
+    {
+        reactor->del(reactor, ev->fd);
+        reactor->running = 0;
+    }
+    return SW_OK;
+}
+
+TEST(reactor, io_uring)
+{
+    swReactor reactor;
+    swPipe p;
+
+    SwooleG.enable_io_uring = 1;
+    ASSERT_EQ(swReactor_create(&reactor, SW_REACTOR_MAXEVENTS), SW_OK);
+    SwooleG.enable_io_uring = 0;
+
+    ASSERT_EQ(swPipeBase_create(&p, 1), SW_OK);
+    reactor.ptr = &p;
+    reactor.setHandle(&reactor, SW_FD_USER, io_uring_test_onRead);
+    ASSERT_EQ(reactor.add(&reactor, p.getFd(&p, 0), SW_FD_USER | SW_EVENT_READ), SW_OK);
+    ASSERT_GT(p.write(&p, (void *) SW_STRL("hello world") - 1), 0);
+
+    struct timeval timeo = {1, 0};
+    reactor.wait(&reactor, &timeo);
+
+    ASSERT_EQ(io_uring_test_read_count, 3);
+    ASSERT_EQ(reactor.event_num, 0);
+    reactor.free(&reactor);
+    p.close(&p);
+}
+
+static int io_uring_test_onTimeout_count = 0;
+
+static void io_uring_test_onTimeout(swReactor *reactor)
+{
+    io_uring_test_onTimeout_count++;
+    reactor->running = 0;
+}
+
+TEST(reactor, io_uring_timeout)
+{
+    swReactor reactor;
+    swPipe p;
+
+    SwooleG.enable_io_uring = 1;
+    ASSERT_EQ(swReactor_create(&reactor, SW_REACTOR_MAXEVENTS), SW_OK);
+    SwooleG.enable_io_uring = 0;
+
+    //the cancelled poll completes right away, it must not end the wait
+    ASSERT_EQ(swPipeBase_create(&p, 1), SW_OK);
+    reactor.setHandle(&reactor, SW_FD_USER, io_uring_test_onRead);
+    ASSERT_EQ(reactor.add(&reactor, p.getFd(&p, 0), SW_FD_USER | SW_EVENT_READ), SW_OK);
+    ASSERT_EQ(reactor.del(&reactor, p.getFd(&p, 0)), SW_OK);
+    reactor.onTimeout = io_uring_test_onTimeout;
+
+    struct timeval timeo = {0, 300 * 1000};
+    uint64_t begin = swoole_monotonic_usec();
+    reactor.wait(&reactor, &timeo);
+    uint64_t usec = swoole_monotonic_usec() - begin;
+
+    ASSERT_EQ(io_uring_test_onTimeout_count, 1);
+    ASSERT_GE(usec, 250 * 1000);
+    reactor.free(&reactor);
+    p.close(&p);
+}
+
+static int io_uring_test_recv_bytes = 0;
+
+static int io_uring_test_onReceive(swReactor *reactor, swEvent *ev)
+{
+    char buf[4];
+    int n = swConnection_recv(ev->socket, buf, sizeof(buf), 0);
+    if (n < 0)
+    {
+        EXPECT_EQ(errno, EAGAIN);
+        return SW_OK;
+    }
+    EXPECT_GT(n, 0);
+    io_uring_test_recv_bytes += n;
+    if (io_uring_test_recv_bytes == 11)
+    {
+        reactor->del(reactor, ev->fd);
+        reactor->running = 0;
+    }
+    return SW_OK;
+}
+
+TEST(reactor, io_uring_completion)
+{
+    swReactor reactor;
+    int sv[2];
+
+    SwooleG.enable_io_uring = 1;
+    ASSERT_EQ(swReactor_create(&reactor, SW_REACTOR_MAXEVENTS), SW_OK);
+    SwooleG.enable_io_uring = 0;
+    if (swReactorIOUring_enable_completion(&reactor, 8, 1024) < 0)
+    {
+        reactor.free(&reactor);
+        GTEST_SKIP() << "io_uring completion mode is not supported";
+    }
+
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+    swSetNonBlock(sv[0]);
+    reactor.setHandle(&reactor, SW_FD_TCP, io_uring_test_onReceive);
+    ASSERT_EQ(reactor.add(&reactor, sv[0], SW_FD_TCP | SW_EVENT_READ), SW_OK);
+    swReactor_get(&reactor, sv[0])->fd = sv[0];
+    ASSERT_EQ(write(sv[1], SW_STRL("hello world") - 1), 11);
+
+    struct timeval timeo = {1, 0};
+    reactor.wait(&reactor, &timeo);
+
+    ASSERT_EQ(io_uring_test_recv_bytes, 11);
+    reactor.free(&reactor);
+    close(sv[0]);
+    close(sv[1]);
+}
+#endif
+
+static int defer_test_count = 0;
+
+static void defer_test_callback(void *data)
+{
+    swReactor *reactor = (swReactor *) data;
+    //the tasks added by a callback run in the next batch of the same drain
+    if (++defer_test_count == 1)
+    {
+        reactor->defer(reactor, defer_test_callback, reactor);
+    }
+}
+
+TEST(reactor, defer)
+{
+    swReactor reactor;
+    ASSERT_EQ(swReactor_create(&reactor, SW_REACTOR_MAXEVENTS), SW_OK);
+    reactor.start = 1;
+
+    int i, n = SW_REACTOR_DEFER_SIZE * 2 + 1;
+    for (i = 0; i < n; i++)
+    {
+        ASSERT_EQ(reactor.defer(&reactor, defer_test_callback, &reactor), SW_OK);
+    }
+    ASSERT_EQ(reactor.defer_count, n);
+    ASSERT_EQ(reactor.defer_size, SW_REACTOR_DEFER_SIZE * 4);
+
+    reactor.onFinish(&reactor);
+    ASSERT_EQ(defer_test_count, n + 1);
+    ASSERT_EQ(reactor.defer_count, 0);
+    ASSERT_EQ(reactor.defer_max_count, n);
+    ASSERT_EQ(reactor.defer_total, n + 1);
+    reactor.free(&reactor);
+}
@@ -0,0 +1,141 @@
+#include "tests.h"
+#include <vector>
+#include <sys/wait.h>
+
+#define SLAB_POOL_TEST_PAGE    4096
+
+TEST(slab_pool, alloc)
+{
+    swMemoryPool *pool = swSlabPool_new(SLAB_POOL_TEST_PAGE * 64, SLAB_POOL_TEST_PAGE);
+    ASSERT_NE(pool, nullptr);
+
+    //too large
+    ASSERT_EQ(pool->alloc(pool, SLAB_POOL_TEST_PAGE * 64), nullptr);
+
+    std::vector<char *> ptrs;
+    char *ptr;
+    //3 pages each, 21 fit
+    while ((ptr = (char *) pool->alloc(pool, SLAB_POOL_TEST_PAGE * 2 + 1)))
+    {
+        memset(ptr, ptrs.size(), SLAB_POOL_TEST_PAGE * 2 + 1);
+        ptrs.push_back(ptr);
+    }
+    ASSERT_EQ(ptrs.size(), 21);
+
+    //free in the middle, a 2 pages hole can not take 3 pages
+    pool->free(pool, ptrs[5]);
+    ASSERT_EQ(pool->alloc(pool, SLAB_POOL_TEST_PAGE * 3), nullptr);
+    pool->free(pool, ptrs[6]);
+    ptr = (char *) pool->alloc(pool, SLAB_POOL_TEST_PAGE * 5);
+    ASSERT_EQ(ptr, ptrs[5]);
+
+    size_t i;
+    for (i = 0; i < ptrs.size(); i++)
+    {
+        if (i == 5 || i == 6)
+        {
+            continue;
+        }
+        ASSERT_EQ(ptrs[i][0], (char) i);
+        ASSERT_EQ(ptrs[i][SLAB_POOL_TEST_PAGE * 2], (char) i);
+        pool->free(pool, ptrs[i]);
+    }
+    pool->free(pool, ptr);
+
+    //everything is released
+    ptr = (char *) pool->alloc(pool, SLAB_POOL_TEST_PAGE * 63);
+    ASSERT_NE(ptr, nullptr);
+    pool->free(pool, ptr);
+    pool->destroy(pool);
+}
+
+/**
+ * allocated by the parent, released by the child
+ */
+TEST(slab_pool, fork)
+{
+    swMemoryPool *pool = swSlabPool_new(SLAB_POOL_TEST_PAGE * 16, SLAB_POOL_TEST_PAGE);
+    ASSERT_NE(pool, nullptr);
+
+    void *ptrs[4];
+    int i;
+    for (i = 0; i < 4; i++)
+    {
+        ptrs[i] = pool->alloc(pool, SLAB_POOL_TEST_PAGE * 3);
+        ASSERT_NE(ptrs[i], nullptr);
+    }
+    ASSERT_EQ(pool->alloc(pool, SLAB_POOL_TEST_PAGE * 4), nullptr);
+
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        for (i = 0; i < 4; i++)
+        {
+            pool->free(pool, ptrs[i]);
+        }
+        _exit(0);
+    }
+    int status;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+
+    void *ptr = pool->alloc(pool, SLAB_POOL_TEST_PAGE * 15);
+    ASSERT_NE(ptr, nullptr);
+    pool->free(pool, ptr);
+    pool->destroy(pool);
+}
+
+/**
+ * the large task payloads go through serv->task_pool, the tmpfile is only used when it is full
+ */
+TEST(slab_pool, task)
+{
+    swServer serv;
+    swServerGS gs;
+    bzero(&serv, sizeof(serv));
+    bzero(&gs, sizeof(gs));
+    serv.gs = &gs;
+    serv.task_pool = swSlabPool_new(SLAB_POOL_TEST_PAGE * 128, SLAB_POOL_TEST_PAGE);
+    ASSERT_NE(serv.task_pool, nullptr);
+    swServer *_serv = SwooleG.serv;
+    SwooleG.serv = &serv;
+
+    std::vector<char> data(SLAB_POOL_TEST_PAGE * 100);
+    size_t i;
+    for (i = 0; i < data.size(); i++)
+    {
+        data[i] = i % 251;
+    }
+
+    swEventData task1, task2;
+    swPackage_task pkg;
+    swTask_type(&task1) = 0;
+    ASSERT_EQ(swTaskWorker_large_pack(&task1, data.data(), data.size()), SW_OK);
+    ASSERT_TRUE(swTask_type(&task1) & SW_TASK_TMPFILE);
+    memcpy(&pkg, task1.data, sizeof(pkg));
+    ASSERT_NE(pkg.data, nullptr);
+
+    //the pool is full
+    swTask_type(&task2) = 0;
+    ASSERT_EQ(swTaskWorker_large_pack(&task2, data.data(), data.size()), SW_OK);
+    memcpy(&pkg, task2.data, sizeof(pkg));
+    ASSERT_EQ(pkg.data, nullptr);
+    ASSERT_EQ(access(pkg.tmpfile, F_OK), 0);
+
+    swString *result = swTaskWorker_large_unpack(&task1);
+    ASSERT_NE(result, nullptr);
+    ASSERT_EQ(result->length, data.size());
+    ASSERT_EQ(memcmp(result->str, data.data(), data.size()), 0);
+
+    result = swTaskWorker_large_unpack(&task2);
+    ASSERT_NE(result, nullptr);
+    ASSERT_EQ(memcmp(result->str, data.data(), data.size()), 0);
+    ASSERT_NE(access(pkg.tmpfile, F_OK), 0);
+
+    //released by unpack
+    void *ptr = serv.task_pool->alloc(serv.task_pool, SLAB_POOL_TEST_PAGE * 127);
+    ASSERT_NE(ptr, nullptr);
+    serv.task_pool->free(serv.task_pool, ptr);
+
+    SwooleG.serv = _serv;
+    serv.task_pool->destroy(serv.task_pool);
+}
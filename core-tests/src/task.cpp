@@ -0,0 +1,248 @@
+#include "tests.h"
+#include <vector>
+
+static std::vector<int> task_batch_ids;
+
+static int task_batch_callback(swServer *serv, swEventData *task)
+{
+    task_batch_ids.push_back(task->info.fd);
+    EXPECT_EQ(task->info.len, (uint32_t) task->info.fd * 100);
+    EXPECT_EQ(task->data[task->info.len - 1], (char) task->info.fd);
+    return SW_OK;
+}
+
+TEST(task, batch)
+{
+    swEventData batch, task;
+    bzero(&batch.info, sizeof(batch.info));
+    swTask_type(&batch) = SW_TASK_BATCH;
+
+    //packed until the message is full
+    int i;
+    for (i = 1; ; i++)
+    {
+        bzero(&task.info, sizeof(task.info));
+        task.info.fd = i;
+        task.info.len = i * 100;
+        memset(task.data, i, task.info.len);
+        if (swTaskWorker_batch_append(&batch, &task) < 0)
+        {
+            break;
+        }
+    }
+    ASSERT_GT(i, 10);
+    ASSERT_GT(batch.info.len + sizeof(task.info) + task.info.len, sizeof(batch.data));
+
+    task_batch_ids.clear();
+    ASSERT_EQ(swTaskWorker_batch_foreach(NULL, &batch, task_batch_callback), SW_OK);
+    ASSERT_EQ(task_batch_ids.size(), i - 1);
+    ASSERT_EQ(task_batch_ids.back(), i - 1);
+
+    //truncated
+    batch.info.len -= 1;
+    ASSERT_EQ(swTaskWorker_batch_foreach(NULL, &batch, task_batch_callback), SW_ERR);
+}
+
+static int task_concurrency_onTask(swServer *serv, swEventData *task)
+{
+    //a bad payload
+    return task->info.len > 0 ? SW_ERR : SW_OK;
+}
+
+TEST(task, concurrency)
+{
+    swServer serv;
+    swServerStats stats;
+    swProcessPool pool;
+    swWorker worker;
+    swReactor reactor;
+    swPipe p;
+
+    bzero(&serv, sizeof(serv));
+    bzero(&stats, sizeof(stats));
+    bzero(&pool, sizeof(pool));
+    bzero(&worker, sizeof(worker));
+    serv.stats = &stats;
+    serv.task_enable_coroutine = 1;
+    serv.task_max_concurrency = 2;
+    serv.onTask = task_concurrency_onTask;
+    pool.ptr = &serv;
+
+    ASSERT_EQ(swReactor_create(&reactor, SW_REACTOR_MAXEVENTS), SW_OK);
+    ASSERT_EQ(swPipeBase_create(&p, 0), SW_OK);
+    worker.pipe_worker = p.getFd(&p, 0);
+    ASSERT_EQ(reactor.add(&reactor, worker.pipe_worker, SW_FD_PIPE | SW_EVENT_READ), SW_OK);
+
+    swReactor *main_reactor = SwooleG.main_reactor;
+    swWorker *current_worker = SwooleWG.worker;
+    SwooleG.main_reactor = &reactor;
+    SwooleWG.worker = &worker;
+
+    swEventData task;
+    bzero(&task.info, sizeof(task.info));
+    task.info.type = SW_EVENT_TASK;
+
+    //stop reading at the limit
+    swTaskWorker_onTask(&pool, &task);
+    ASSERT_EQ(reactor.event_num, 1);
+    swTaskWorker_onTask(&pool, &task);
+    ASSERT_EQ(stats.task_running_num, 2);
+    ASSERT_EQ(reactor.event_num, 0);
+    ASSERT_EQ(worker.status, SW_WORKER_BUSY);
+
+    //read again once one of them is done
+    swTaskWorker_done(&serv);
+    ASSERT_EQ(stats.task_running_num, 1);
+    ASSERT_EQ(reactor.event_num, 1);
+    ASSERT_EQ(worker.status, SW_WORKER_IDLE);
+
+    //never below zero
+    swTaskWorker_done(&serv);
+    swTaskWorker_done(&serv);
+    ASSERT_EQ(stats.task_running_num, 0);
+    ASSERT_EQ(reactor.event_num, 1);
+
+    //the tasks which fail to start never hold a slot
+    swTaskWorker_onTask(&pool, &task);
+    task.info.len = 1;
+    swTaskWorker_onTask(&pool, &task);
+    swTaskWorker_onTask(&pool, &task);
+    ASSERT_EQ(stats.task_running_num, 1);
+    ASSERT_EQ(reactor.event_num, 1);
+    swTaskWorker_done(&serv);
+
+    SwooleG.main_reactor = main_reactor;
+    SwooleWG.worker = current_worker;
+    reactor.free(&reactor);
+    p.close(&p);
+}
+
+TEST(task, deadline)
+{
+    swEventData task;
+    bzero(&task.info, sizeof(task.info));
+    task.info.len = 5;
+    memcpy(task.data, "hello", 5);
+
+    swTask_set_deadline(&task, 1234567890123LL);
+    ASSERT_EQ(task.info.len, 5 + sizeof(int64_t));
+    ASSERT_TRUE(swTask_type(&task) & SW_TASK_DEADLINE);
+    ASSERT_EQ(swTask_get_deadline(&task), 1234567890123LL);
+    //the data is restored for onTask
+    ASSERT_EQ(task.info.len, 5);
+    ASSERT_EQ(memcmp(task.data, "hello", 5), 0);
+}
+
+static int task_expired_onTask_count;
+
+static int task_expired_onTask(swServer *serv, swEventData *task)
+{
+    task_expired_onTask_count++;
+    return SW_OK;
+}
+
+TEST(task, expired)
+{
+    swServer serv;
+    swServerGS gs;
+    swServerStats stats;
+    swProcessPool pool;
+    swWorker worker;
+    int fds[2];
+
+    bzero(&serv, sizeof(serv));
+    bzero(&gs, sizeof(gs));
+    bzero(&stats, sizeof(stats));
+    bzero(&pool, sizeof(pool));
+    bzero(&worker, sizeof(worker));
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_DGRAM, 0, fds), 0);
+    worker.pipe_master = fds[0];
+    worker.pool = &pool;
+    gs.event_workers.workers = &worker;
+    serv.gs = &gs;
+    serv.stats = &stats;
+    serv.worker_num = 1;
+    serv.task_worker_num = 1;
+    serv.onTask = task_expired_onTask;
+    pool.ptr = &serv;
+
+    swEventData task;
+    bzero(&task.info, sizeof(task.info));
+    task.info.type = SW_EVENT_TASK;
+    task.info.fd = 99;
+    task.info.len = 1;
+    task.data[0] = 'x';
+
+    //still in time
+    stats.tasking_num = 2;
+    swTask_type(&task) = SW_TASK_NONBLOCK;
+    swTask_set_deadline(&task, swoole_monotonic_usec() + 1000000);
+    swTaskWorker_onTask(&pool, &task);
+    ASSERT_EQ(task_expired_onTask_count, 1);
+    ASSERT_EQ(stats.task_expired_count, 0);
+
+    //dropped, the callback of the caller is released by an empty result
+    swTask_type(&task) = SW_TASK_NONBLOCK | SW_TASK_CALLBACK;
+    task.info.len = 1;
+    swTask_set_deadline(&task, swoole_monotonic_usec() - 1);
+    swTaskWorker_onTask(&pool, &task);
+    ASSERT_EQ(task_expired_onTask_count, 1);
+    ASSERT_EQ(stats.task_expired_count, 1);
+    ASSERT_EQ(stats.tasking_num, 1);
+
+    swEventData result;
+    ASSERT_EQ(recv(fds[1], &result, sizeof(result), MSG_DONTWAIT), sizeof(result.info));
+    ASSERT_EQ(result.info.type, SW_EVENT_FINISH);
+    ASSERT_EQ(result.info.fd, 99);
+    ASSERT_TRUE(swTask_type(&result) & SW_TASK_EXPIRED);
+    ASSERT_TRUE(swTask_type(&result) & SW_TASK_CALLBACK);
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST(task, priority)
+{
+    swProcessPool pool;
+    swWorker worker;
+    swMsgQueue queue;
+
+    if (swMsgQueue_create(&queue, 0, IPC_PRIVATE, 0) < 0)
+    {
+        GTEST_SKIP() << "System V message queue is not supported";
+    }
+    bzero(&pool, sizeof(pool));
+    bzero(&worker, sizeof(worker));
+    pool.use_msgqueue = 1;
+    pool.queue = &queue;
+    pool.dispatch_mode = SW_DISPATCH_QUEUE;
+    pool.type = SW_PROCESS_TASKWORKER;
+    worker.pool = &pool;
+
+    int priorities[] = {1, 7, 0, 3, 7};
+    swEventData task;
+    int i;
+    for (i = 0; i < 5; i++)
+    {
+        bzero(&task.info, sizeof(task.info));
+        task.info.fd = i;
+        swTask_type(&task) = SW_TASK_NONBLOCK | (priorities[i] << SW_TASK_PRIORITY_SHIFT);
+        ASSERT_GE(swWorker_send2worker(&worker, &task, sizeof(task.info), SW_PIPE_MASTER), 0);
+    }
+
+    //the larger priority first, in order within the same priority
+    int expect[] = {1, 4, 3, 0, 2};
+    struct
+    {
+        long mtype;
+        swEventData buf;
+    } out;
+    for (i = 0; i < 5; i++)
+    {
+        out.mtype = -LONG_MAX;
+        ASSERT_EQ(swMsgQueue_pop(&queue, (swQueue_data *) &out, sizeof(out.buf)), sizeof(out.buf.info));
+        ASSERT_EQ(out.buf.info.fd, expect[i]);
+        ASSERT_EQ(out.mtype, SW_TASK_PRIORITY_NUM - priorities[expect[i]]);
+    }
+    swMsgQueue_free(&queue);
+}
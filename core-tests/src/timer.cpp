@@ -0,0 +1,182 @@
+#include "tests.h"
+#include <vector>
+
+#define TIMER_WHEEL_TEST_NODES   20000
+
+TEST(timer, wheel)
+{
+    swTimerWheel *wheel = swTimerWheel_new(0);
+    ASSERT_NE(wheel, nullptr);
+
+    std::vector<swTimer_node> nodes(TIMER_WHEEL_TEST_NODES);
+    int i;
+    for (i = 0; i < TIMER_WHEEL_TEST_NODES; i++)
+    {
+        //from 1ms to ~70min, covers all the levels
+        nodes[i].exec_msec = 1 + (swoole_system_random(0, 1 << 22) >> swoole_system_random(0, 22));
+        nodes[i].remove = 0;
+        swTimerWheel_add(wheel, &nodes[i]);
+    }
+    //cancel every third node
+    int removed = 0;
+    for (i = 0; i < TIMER_WHEEL_TEST_NODES; i += 3)
+    {
+        swTimerWheel_remove(wheel, &nodes[i]);
+        nodes[i].remove = 1;
+        removed++;
+    }
+
+    int64_t now = 0, last = -1;
+    int fired = 0;
+    while (fired + removed < TIMER_WHEEL_TEST_NODES)
+    {
+        int64_t next = swTimerWheel_next(wheel);
+        ASSERT_GT(next, last);
+        now = next + swoole_system_random(0, 100);
+        swTimer_node *tnode;
+        while ((tnode = swTimerWheel_pop(wheel, now)))
+        {
+            ASSERT_EQ(tnode->remove, 0);
+            //fires at the first poll after it expires
+            ASSERT_LE(tnode->exec_msec, now);
+            ASSERT_GT(tnode->exec_msec, last);
+            tnode->remove = 1;
+            fired++;
+        }
+        last = now;
+    }
+    ASSERT_EQ(swTimerWheel_next(wheel), -1);
+    swTimerWheel_free(wheel);
+}
+
+static void timer_test_callback(swTimer *timer, swTimer_node *tnode)
+{
+}
+
+static int timer_test_interval_count = 0;
+static int timer_test_once_count = 0;
+
+static void timer_test_interval(swTimer *timer, swTimer_node *tnode)
+{
+    if (++timer_test_interval_count == 3)
+    {
+        swTimer_del(timer, tnode);
+    }
+}
+
+static void timer_test_once(swTimer *timer, swTimer_node *tnode)
+{
+    //the 30ms timer fires after the first two runs of the 20ms interval timer
+    ASSERT_EQ(timer_test_interval_count, 1);
+    timer_test_once_count++;
+}
+
+TEST(timer, wheel_reactor)
+{
+    swReactor reactor;
+    ASSERT_EQ(swReactor_create(&reactor, SW_REACTOR_MAXEVENTS), SW_OK);
+    swReactor *main_reactor = SwooleG.main_reactor;
+    SwooleG.main_reactor = &reactor;
+    SwooleG.enable_timer_wheel = 1;
+    ASSERT_EQ(swTimer_init(20), SW_OK);
+
+    ASSERT_NE(SwooleG.timer.add(&SwooleG.timer, 20, 1, NULL, timer_test_interval), nullptr);
+    ASSERT_NE(SwooleG.timer.add(&SwooleG.timer, 30, 0, NULL, timer_test_once), nullptr);
+    swTimer_node *cancelled = SwooleG.timer.add(&SwooleG.timer, 10, 0, NULL, timer_test_once);
+    ASSERT_EQ(swTimer_del(&SwooleG.timer, cancelled), SW_TRUE);
+
+    reactor.wait(&reactor, NULL);
+    ASSERT_EQ(timer_test_interval_count, 3);
+    ASSERT_EQ(timer_test_once_count, 1);
+    ASSERT_EQ(SwooleG.timer.num, 0);
+
+    swTimer_free(&SwooleG.timer);
+    swHashMap_free(SwooleG.timer.map);
+    bzero(&SwooleG.timer, sizeof(SwooleG.timer));
+    SwooleG.enable_timer_wheel = 0;
+    SwooleG.main_reactor = main_reactor;
+    reactor.free(&reactor);
+}
+
+/**
+ * add and cancel the timers like the coroutine socket timeouts, heap vs wheel
+ */
+TEST(timer, wheel_benchmark)
+{
+    swReactor reactor;
+    ASSERT_EQ(swReactor_create(&reactor, SW_REACTOR_MAXEVENTS), SW_OK);
+    swReactor *main_reactor = SwooleG.main_reactor;
+    SwooleG.main_reactor = &reactor;
+
+    const int n = 500000;
+    std::vector<swTimer_node *> nodes(n);
+    int i, use_wheel;
+    for (use_wheel = 0; use_wheel < 2; use_wheel++)
+    {
+        SwooleG.enable_timer_wheel = use_wheel;
+        ASSERT_EQ(swTimer_init(1000), SW_OK);
+        uint64_t begin = swoole_monotonic_usec();
+        for (i = 0; i < n; i++)
+        {
+            nodes[i] = SwooleG.timer.add(&SwooleG.timer, 1000 + (i % 30000), 0, NULL, timer_test_callback);
+            ASSERT_NE(nodes[i], nullptr);
+        }
+        for (i = 0; i < n; i++)
+        {
+            ASSERT_EQ(swTimer_del(&SwooleG.timer, nodes[i]), SW_TRUE);
+        }
+        uint64_t usec = swoole_monotonic_usec() - begin;
+        printf("%s: %d add+del, %.1f ns/op\n", use_wheel ? "wheel" : "heap", n, (double) usec * 1000 / n);
+        ASSERT_EQ(SwooleG.timer.num, 0);
+        swTimer_free(&SwooleG.timer);
+        swHashMap_free(SwooleG.timer.map);
+        bzero(&SwooleG.timer, sizeof(SwooleG.timer));
+    }
+
+    SwooleG.enable_timer_wheel = 0;
+    SwooleG.main_reactor = main_reactor;
+    reactor.free(&reactor);
+}
+
+/**
+ * the data structures alone, without the id map and the clock
+ */
+TEST(timer, wheel_benchmark_raw)
+{
+    const int n = 500000;
+    std::vector<swTimer_node> nodes(n);
+    int i;
+
+    swHeap *heap = swHeap_new(1024, SW_MIN_HEAP);
+    ASSERT_NE(heap, nullptr);
+    uint64_t begin = swoole_monotonic_usec();
+    for (i = 0; i < n; i++)
+    {
+        nodes[i].heap_node = swHeap_push(heap, 1000 + (i % 30000), &nodes[i]);
+    }
+    for (i = 0; i < n; i++)
+    {
+        swHeap_remove(heap, nodes[i].heap_node);
+        sw_free(nodes[i].heap_node);
+    }
+    uint64_t usec = swoole_monotonic_usec() - begin;
+    printf("heap: %d push+remove, %.1f ns/op\n", n, (double) usec * 1000 / n);
+    swHeap_free(heap);
+
+    swTimerWheel *wheel = swTimerWheel_new(0);
+    ASSERT_NE(wheel, nullptr);
+    begin = swoole_monotonic_usec();
+    for (i = 0; i < n; i++)
+    {
+        nodes[i].exec_msec = 1000 + (i % 30000);
+        swTimerWheel_add(wheel, &nodes[i]);
+    }
+    for (i = 0; i < n; i++)
+    {
+        swTimerWheel_remove(wheel, &nodes[i]);
+    }
+    usec = swoole_monotonic_usec() - begin;
+    printf("wheel: %d add+remove, %.1f ns/op\n", n, (double) usec * 1000 / n);
+    ASSERT_EQ(swTimerWheel_next(wheel), -1);
+    swTimerWheel_free(wheel);
+}
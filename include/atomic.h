@@ -25,6 +25,8 @@ typedef sw_atomic_uint32_t                sw_atomic_t;
 #define sw_atomic_memory_barrier()        __sync_synchronize()
 #define sw_atomic_add_fetch(value, add)   __sync_add_and_fetch(value, add)
 #define sw_atomic_sub_fetch(value, sub)   __sync_sub_and_fetch(value, sub)
+#define sw_atomic_load_acquire(ptr)       __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define sw_atomic_store_release(ptr, val) __atomic_store_n(ptr, val, __ATOMIC_RELEASE)
 
 #ifdef __arm__
 #define sw_atomic_cpu_pause()             __asm__ __volatile__ ("NOP");
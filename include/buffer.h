@@ -44,10 +44,23 @@ typedef struct _swBuffer_chunk
         } data;
     } store;
     uint32_t size;
+    /**
+     * MSG_ZEROCOPY: the number of sends which must be completed before the memory is released
+     */
+    uint32_t seq;
     void (*destroy)(struct _swBuffer_chunk *chunk);
     struct _swBuffer_chunk *next;
 } swBuffer_chunk;
 
+/**
+ * the memory of the data chunks of a group of buffers, and optionally of all the groups
+ */
+typedef struct _swBuffer_counter
+{
+    sw_atomic_long_t memory;
+    sw_atomic_long_t *total;
+} swBuffer_counter;
+
 typedef struct _swBuffer
 {
     int fd;
@@ -56,6 +69,7 @@ typedef struct _swBuffer
     uint32_t length;
     swBuffer_chunk *head;
     swBuffer_chunk *tail;
+    swBuffer_counter *counter;
 } swBuffer;
 
 #define swBuffer_get_chunk(buffer)   (buffer->head)
@@ -64,7 +78,9 @@ typedef struct _swBuffer
 swBuffer* swBuffer_new(int chunk_size);
 swBuffer_chunk *swBuffer_new_chunk(swBuffer *buffer, uint32_t type, uint32_t size);
 void swBuffer_pop_chunk(swBuffer *buffer, swBuffer_chunk *chunk);
+void swBuffer_move_chunk(swBuffer *from, swBuffer *to);
 int swBuffer_append(swBuffer *buffer, void *data, uint32_t size);
+void swBuffer_set_counter(swBuffer *buffer, swBuffer_counter *counter);
 
 void swBuffer_debug(swBuffer *buffer, int print_data);
 int swBuffer_free(swBuffer *buffer);
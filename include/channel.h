@@ -19,12 +19,6 @@ enum channel_op
 
 class Channel;
 
-struct notify_msg_t
-{
-    Channel *chan;
-    enum channel_op type;
-};
-
 struct timeout_msg_t
 {
     Channel *chan;
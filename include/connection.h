@@ -55,6 +55,9 @@ typedef struct _swSSL_option
 #endif
 
 int swConnection_buffer_send(swConnection *conn);
+int swConnection_buffer_writev(swConnection *conn);
+int swConnection_buffer_send_zerocopy(swConnection *conn);
+int swConnection_zerocopy_reap(swConnection *conn);
 
 swString* swConnection_get_string_buffer(swConnection *conn);
 void swConnection_clear_string_buffer(swConnection *conn);
@@ -134,12 +137,60 @@ ssize_t swSSL_send(swConnection *conn, void *__buf, size_t __n);
 int swSSL_sendfile(swConnection *conn, int fd, off_t *offset, size_t size);
 #endif
 
+#ifdef HAVE_IO_URING
+/**
+ * data of the completed recv request is consumed by the protocol
+ */
+static sw_inline void swConnection_completion_consume(swConnection *conn, int n)
+{
+    conn->completion_data += n;
+    conn->completion_length -= n;
+    if (conn->completion_length <= 0)
+    {
+        conn->completion = 0;
+        conn->completion_data = NULL;
+        conn->completion_length = 0;
+        if (conn->completion_stash)
+        {
+            sw_free(conn->completion_stash);
+            conn->completion_stash = NULL;
+        }
+    }
+}
+#endif
+
 /**
  * Receive data from connection
  */
 static sw_inline ssize_t swConnection_recv(swConnection *conn, void *__buf, size_t __n, int __flags)
 {
     ssize_t retval;
+#ifdef HAVE_IO_URING
+    if (conn->completion)
+    {
+        if (conn->completion_length <= 0)
+        {
+            if (conn->completion_length < 0)
+            {
+                errno = -conn->completion_length;
+                return SW_ERR;
+            }
+            return 0;
+        }
+        retval = conn->completion_length < (int) __n ? conn->completion_length : __n;
+        memcpy(__buf, conn->completion_data, retval);
+        swConnection_completion_consume(conn, retval);
+        goto _return;
+    }
+    /**
+     * the recv request in flight receives the data, keep the order
+     */
+    else if (conn->completion_recv)
+    {
+        errno = EAGAIN;
+        return SW_ERR;
+    }
+#endif
     _recv:
 #ifdef SW_USE_OPENSSL
     if (conn->ssl)
@@ -203,6 +254,14 @@ static sw_inline ssize_t swConnection_recv(swConnection *conn, void *__buf, size
  * Send data to connection
  */
 //发送数据到对端
+/**
+ * the bytes of the chunks can be merged, the pipes and the udp sockets keep the message boundary
+ */
+static sw_inline int swConnection_is_stream(swConnection *conn)
+{
+    return conn->fdtype == SW_FD_TCP || conn->fdtype == SW_FD_STREAM || conn->fdtype == SW_FD_STREAM_CLIENT;
+}
+
 static sw_inline ssize_t swConnection_send(swConnection *conn, void *__buf, size_t __n, int __flags)
 {
     ssize_t retval;
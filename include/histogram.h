@@ -0,0 +1,64 @@
+/*
+ +----------------------------------------------------------------------+
+ | Swoole                                                               |
+ +----------------------------------------------------------------------+
+ | This source file is subject to version 2.0 of the Apache license,    |
+ | that is bundled with this package in the file LICENSE, and is        |
+ | available through the world-wide-web at the following url:           |
+ | http://www.apache.org/licenses/LICENSE-2.0.html                      |
+ | If you did not receive a copy of the Apache2.0 license and are unable|
+ | to obtain it through the world-wide-web, please send a note to       |
+ | license@swoole.com so we can mail you a copy immediately.            |
+ +----------------------------------------------------------------------+
+ | Author: Tianfeng Han  <mikan.tenny@gmail.com>                        |
+ +----------------------------------------------------------------------+
+ */
+
+#ifndef SW_HISTOGRAM_H_
+#define SW_HISTOGRAM_H_
+
+/**
+ * log-linear histogram (HDR style): values below SW_HISTOGRAM_SUB_COUNT are exact,
+ * larger values are split into SW_HISTOGRAM_SUB_COUNT linear buckets per power of two,
+ * the relative error is 1/SW_HISTOGRAM_SUB_COUNT.
+ */
+#define SW_HISTOGRAM_SUB_BITS     3
+#define SW_HISTOGRAM_SUB_COUNT    (1 << SW_HISTOGRAM_SUB_BITS)
+#define SW_HISTOGRAM_BUCKET_NUM   ((64 - SW_HISTOGRAM_SUB_BITS + 1) * SW_HISTOGRAM_SUB_COUNT)
+
+typedef struct _swHistogram
+{
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+    uint64_t buckets[SW_HISTOGRAM_BUCKET_NUM];
+} swHistogram;
+
+swHistogram* swHistogram_new(void);
+void swHistogram_free(swHistogram *hist);
+void swHistogram_reset(swHistogram *hist);
+uint64_t swHistogram_percentile(swHistogram *hist, double percentile);
+uint64_t swHistogram_bucket_value(uint32_t index);
+
+static inline uint32_t swHistogram_bucket_index(uint64_t value)
+{
+    if (value < SW_HISTOGRAM_SUB_COUNT)
+    {
+        return (uint32_t) value;
+    }
+    uint32_t shift = 63 - __builtin_clzll(value) - SW_HISTOGRAM_SUB_BITS;
+    return ((shift + 1) << SW_HISTOGRAM_SUB_BITS) + ((value >> shift) & (SW_HISTOGRAM_SUB_COUNT - 1));
+}
+
+static inline void swHistogram_record(swHistogram *hist, uint64_t value)
+{
+    hist->buckets[swHistogram_bucket_index(value)]++;
+    hist->count++;
+    hist->sum += value;
+    if (value > hist->max)
+    {
+        hist->max = value;
+    }
+}
+
+#endif /* SW_HISTOGRAM_H_ */
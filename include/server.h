@@ -69,6 +69,24 @@ enum swEventType
     //buffer event
     SW_EVENT_BUFFER_FULL,
     SW_EVENT_BUFFER_EMPTY,
+    //enable_udp_batch, [swDataHead][data] of the datagrams, each record is 8 bytes aligned
+    SW_EVENT_UDP_BATCH,
+};
+
+enum swServer_accept_mode
+{
+    /**
+     * the main reactor accepts and dispatches the connections to the reactor threads
+     */
+    SW_ACCEPT_MASTER    = 1,
+    /**
+     * every reactor thread accepts on its own SO_REUSEPORT listening socket
+     */
+    SW_ACCEPT_REUSEPORT = 2,
+    /**
+     * every reactor thread accepts on the shared listening socket, woken up by EPOLLEXCLUSIVE
+     */
+    SW_ACCEPT_EXCLUSIVE = 3,
 };
 
 enum swIPCType
@@ -77,6 +95,10 @@ enum swIPCType
     SW_IPC_UNIXSOCK = 1,
     SW_IPC_MSGQUEUE = 2,
     SW_IPC_SOCKET   = 3,
+    /**
+     * shared memory rings between the reactor threads and the workers, see swServer->request_rings
+     */
+    SW_IPC_RING     = 4,
 };
 
 enum swTaskIPCMode
@@ -120,8 +142,16 @@ enum swTaskType
     SW_TASK_WAITALL    = 16, //for taskWaitAll
     SW_TASK_COROUTINE  = 32, //coroutine
     SW_TASK_PEEK       = 64, //peek
+    SW_TASK_BATCH      = 128, //packed tasks or results
+    SW_TASK_DEADLINE   = 256, //the data ends with the deadline
+    SW_TASK_EXPIRED    = 512, //the empty result of a task dropped after the deadline
 };
 
+/**
+ * the high 4 bits of swTask_type
+ */
+#define SW_TASK_PRIORITY_SHIFT             12
+
 typedef struct _swUdpFd
 {
     struct sockaddr addr;
@@ -139,6 +169,39 @@ typedef struct _swReactorThread
 #endif
     swLock lock;
     int notify_pipe;
+    swHistogram *latency;
+    /**
+     * SW_IPC_RING: requests waiting for the ring of each worker
+     */
+    swBuffer **ring_buffer;
+    /**
+     * the large packages are passed to the workers in this shared memory, see SW_EVENT_PACKAGE
+     */
+    swMemoryPool *package_pool;
+    /**
+     * enable_reactor_steal: read events of the current period, and the load of the last one for the other threads
+     */
+    uint32_t steal_events;
+    volatile uint32_t steal_load;
+    uint16_t steal_period;
+    int64_t steal_time;
+    /**
+     * zerocopy_threshold: the chunks of the closed connections, released after SW_ZEROCOPY_LINGER_TIME
+     */
+    swBuffer *zerocopy_linger;
+    /**
+     * enable_udp_batch: the buffers of recvmmsg
+     */
+    struct _swDgramRecvBatch *dgram_batch;
+    /**
+     * the memory of the output buffers of the connections, and the connections paused by output_memory_high_watermark
+     */
+    swBuffer_counter output_memory;
+    uint32_t recv_paused_num;
+    /**
+     * accept_mode: the thread stopped accepting because of too many open files, it accepts again after the time
+     */
+    time_t accept_resume_time;
 } swReactorThread;
 
 typedef struct _swListenPort
@@ -172,6 +235,10 @@ typedef struct _swListenPort
     uint8_t ssl;
     int port;
     int sock;
+    /**
+     * SO_REUSEPORT listening socket of each reactor thread
+     */
+    int *reactor_socks;
     pthread_t thread_id;
     char host[SW_HOST_MAXSIZE];
 
@@ -242,6 +309,17 @@ typedef struct _swListenPort
 
     sw_atomic_t connection_num;
 
+    /**
+     * max number of accept() on each wakeup
+     */
+    uint32_t accept_batch;
+    /**
+     * accept stats
+     */
+    sw_atomic_long_t accept_count;
+    sw_atomic_long_t reject_count;
+    sw_atomic_long_t emfile_count;
+
     swProtocol protocol;
     void *ptr;
     int (*onRead)(swReactor *reactor, struct _swListenPort *port, swEvent *event);
@@ -358,8 +436,26 @@ typedef struct
     sw_atomic_long_t accept_count;
     sw_atomic_long_t close_count;
     sw_atomic_long_t request_count;
+    /**
+     * the memory of the output buffers of all the connections
+     */
+    sw_atomic_long_t output_buffer_memory;
+    /**
+     * dropped by the task workers after the deadline
+     */
+    sw_atomic_long_t task_expired_count;
+    /**
+     * task_enable_coroutine, the tasks running in the coroutines of all the task workers
+     */
+    sw_atomic_t task_running_num;
 } swServerStats;
 
+typedef struct
+{
+    uint32_t hash;
+    uint32_t worker_id;
+} swHashRing_node;
+
 typedef struct
 {
     pid_t master_pid;
@@ -375,6 +471,17 @@ typedef struct
     swProcessPool task_workers;
     swProcessPool event_workers;
 
+    /**
+     * SW_DISPATCH_CHASH: messages in flight to all the workers
+     */
+    sw_atomic_t dispatch_count;
+    sw_atomic_t finish_count;
+
+    /**
+     * any process may alloc from serv->task_pool
+     */
+    sw_atomic_t task_pool_lock;
+
 } swServerGS;
 
 struct _swServer
@@ -387,6 +494,11 @@ struct _swServer
      * worker process num
      */
     uint16_t worker_num;
+    /**
+     * autoscaling, the manager runs min_worker_num to worker_num workers by their load, 0 to disable
+     */
+    uint16_t min_worker_num;
+    uint16_t task_min_worker_num;
     /**
      * The number of pipe per reactor maintenance
      */
@@ -394,6 +506,32 @@ struct _swServer
 
     uint8_t factory_mode;
 
+    /**
+     * reactor thread <-> worker ipc, SW_IPC_UNIXSOCK or SW_IPC_RING
+     */
+    uint8_t ipc_mode;
+    uint32_t ipc_ring_size;
+    /**
+     * shared memory per reactor thread for the packages larger than SW_BUFFER_SIZE, 0 to disable
+     */
+    uint32_t package_pool_size;
+    /**
+     * shared memory for the task payloads and results larger than SW_IPC_MAX_SIZE, 0 to use tmpfiles
+     */
+    uint32_t task_pool_size;
+    /**
+     * the responses larger than this are sent with MSG_ZEROCOPY, 0 to disable
+     */
+    uint32_t zerocopy_threshold;
+    /**
+     * SW_IPC_RING: one ring per reactor thread and worker in each direction,
+     * indexed by worker_id * reactor_num + reactor_id
+     */
+    swShmRing **request_rings;
+    swShmRing **response_rings;
+    swDoorbell *worker_doorbells;
+    swDoorbell *reactor_doorbells;
+
     uint8_t dgram_port_num;
 
     /**
@@ -401,6 +539,11 @@ struct _swServer
      */
     uint8_t dispatch_mode;
 
+    /**
+     * which thread accepts the new connections
+     */
+    uint8_t accept_mode;
+
     /**
      * No idle work process is available.
      */
@@ -427,6 +570,11 @@ struct _swServer
 
     uint32_t max_wait_time;
 
+    /**
+     * busy poll time of the reactor before blocking (microseconds)
+     */
+    uint32_t busy_poll_usec;
+
     /*----------------------------Reactor schedule--------------------------------*/
     uint16_t reactor_round_i;
     uint16_t reactor_next_i;
@@ -451,7 +599,8 @@ struct _swServer
      */
     uint32_t open_cpu_affinity :1;
     /**
-     * disable notice when use SW_DISPATCH_ROUND and SW_DISPATCH_QUEUE
+     * disable notice when use SW_DISPATCH_ROUND, SW_DISPATCH_QUEUE, SW_DISPATCH_P2C and SW_DISPATCH_EWMA,
+     * not SW_DISPATCH_CHASH
      */
     uint32_t disable_notify :1;
     /**
@@ -471,7 +620,7 @@ struct _swServer
      */
     uint32_t enable_static_handler :1;
     /**
-     * enable onConnect/onClose event when use dispatch_mode=1/3
+     * enable onConnect/onClose event when use dispatch_mode=1/3/8/9, see swServer_dispatch_unbound()
      */
     uint32_t enable_unsafe_event :1;
     /**
@@ -490,6 +639,18 @@ struct _swServer
      * yield coroutine when the output buffer is full
      */
     uint32_t send_yield :1;
+    /**
+     * io_uring reactor threads receive into the registered buffers and send from the output buffer
+     */
+    uint32_t io_uring_completion :1;
+    /**
+     * move the connections from the overloaded reactor threads to the idle ones
+     */
+    uint32_t enable_reactor_steal :1;
+    /**
+     * receive the datagrams with recvmmsg, and send the replies with sendmmsg
+     */
+    uint32_t enable_udp_batch :1;
 
     /**
      *  heartbeat check time
@@ -499,6 +660,16 @@ struct _swServer
 
     int *cpu_affinity_available;
     int cpu_affinity_available_num;
+    /**
+     * explicit cpus of the reactor threads, workers and task workers, takes precedence over open_cpu_affinity.
+     * the memory written by a pinned thread is placed on its NUMA node.
+     */
+    int *reactor_cpu_set;
+    int reactor_cpu_set_num;
+    int *worker_cpu_set;
+    int worker_cpu_set_num;
+    int *task_worker_cpu_set;
+    int task_worker_cpu_set_num;
     
     double send_timeout;
 
@@ -509,6 +680,11 @@ struct _swServer
     /* buffer output/input setting*/
     uint32_t buffer_output_size;
     uint32_t buffer_input_size;
+    /**
+     * the output buffers of all the connections, the heaviest ones stop reading above the high watermark
+     */
+    size_t output_memory_high_watermark;
+    size_t output_memory_low_watermark;
 
     void *ptr2;
     void *private_data_3;
@@ -524,8 +700,14 @@ struct _swServer
     uint16_t task_worker_num;
     uint8_t task_ipc_mode;
     uint16_t task_max_request;
+    /**
+     * run onTask in a coroutine, a task worker reads the next task while the others are waiting for io
+     */
+    uint8_t task_enable_coroutine;
+    uint32_t task_max_concurrency;
     swPipe *task_notify;
     swEventData *task_result;
+    swMemoryPool *task_pool;
 
     /**
      * user process
@@ -537,6 +719,11 @@ struct _swServer
 
     swReactorThread *reactor_threads;
     swWorker *workers;
+    /**
+     * SW_DISPATCH_CHASH: virtual nodes of the workers, sorted by hash
+     */
+    swHashRing_node *hash_ring;
+    uint32_t hash_ring_size;
 
     swChannel *message_box;
 
@@ -647,6 +834,10 @@ typedef struct _swPackage
 typedef struct
 {
     size_t length;
+    /**
+     * in serv->task_pool, NULL if the data is in the tmpfile
+     */
+    void *data;
     char tmpfile[SW_TASK_TMPDIR_SIZE + sizeof(SW_TASK_TMP_FILE)];
 } swPackage_task;
 
@@ -735,6 +926,14 @@ static sw_inline int swEventData_is_dgram(uint8_t type)
     }
 }
 
+/**
+ * SW_EVENT_UDP_BATCH, the space taken by a record
+ */
+static sw_inline uint32_t swEventData_batch_size(swDataHead *info)
+{
+    return (sizeof(swDataHead) + info->len + 7) & ~7;
+}
+
 static sw_inline int swEventData_is_stream(uint8_t type)
 {
     switch (type)
@@ -764,8 +963,26 @@ void swServer_store_listen_socket(swServer *serv);
 int swServer_get_manager_pid(swServer *serv);
 int swServer_get_socket(swServer *serv, int port);
 int swServer_worker_init(swServer *serv, swWorker *worker);
+int swServer_get_affinity_cpu(swServer *serv, int *cpu_set, int cpu_set_num, int id);
+int swServer_set_cpu_affinity(swServer *serv, int *cpu_set, int cpu_set_num, int id);
 swString** swServer_create_worker_buffer(swServer *serv);
 int swServer_create_task_worker(swServer *serv);
+int swServer_create_ipc_ring(swServer *serv);
+void swServer_free_ipc_ring(swServer *serv);
+int swServer_ring_push(swShmRing *ring, swBuffer **overflow, swDoorbell *consumer, void *data, uint32_t length);
+int swServer_ring_flush(swShmRing *ring, swBuffer *overflow, swDoorbell *consumer);
+
+/**
+ * the consumer has popped from the ring, wake up the producer if it is waiting for space
+ */
+static sw_inline void swServer_ring_release(swShmRing *ring, swDoorbell *producer)
+{
+    sw_atomic_memory_barrier();
+    if (ring->waiting && sw_atomic_cmp_set(&ring->waiting, 1, 0))
+    {
+        swDoorbell_notify(producer);
+    }
+}
 void swServer_close_listen_port(swServer *serv);
 void swServer_enable_accept(swReactor *reactor);
 void swServer_reopen_log_file(swServer *serv);
@@ -776,15 +993,56 @@ int swTaskWorker_onFinish(swReactor *reactor, swEvent *event);
 void swTaskWorker_onStart(swProcessPool *pool, int worker_id);
 void swTaskWorker_onStop(swProcessPool *pool, int worker_id);
 int swTaskWorker_large_pack(swEventData *task, void *data, int data_len);
+void swTaskWorker_large_free(swEventData *task);
 int swTaskWorker_finish(swServer *serv, char *data, int data_len, int flags);
+int swTaskWorker_finish_task(swServer *serv, swEventData *task, char *data, int data_len, int flags);
+void swTaskWorker_done(swServer *serv);
+int swTaskWorker_finish_dispatch(swServer *serv, swEventData *task);
+int swTaskWorker_batch_append(swEventData *batch, swEventData *task);
+int swTaskWorker_batch_foreach(swServer *serv, swEventData *batch, int (*callback)(swServer *, swEventData *));
 
 #define swTask_type(task)                  ((task)->info.from_fd)
+#define swTask_priority(task)              ((swTask_type(task) >> SW_TASK_PRIORITY_SHIFT) & 0xf)
+
+/**
+ * the deadline is the monotonic time in microseconds, there must be room for it in task->data
+ */
+static sw_inline void swTask_set_deadline(swEventData *task, int64_t deadline)
+{
+    memcpy(task->data + task->info.len, &deadline, sizeof(deadline));
+    task->info.len += sizeof(deadline);
+    swTask_type(task) |= SW_TASK_DEADLINE;
+}
+
+static sw_inline int64_t swTask_get_deadline(swEventData *task)
+{
+    int64_t deadline;
+    task->info.len -= sizeof(deadline);
+    memcpy(&deadline, task->data + task->info.len, sizeof(deadline));
+    swTask_type(task) &= ~SW_TASK_DEADLINE;
+    return deadline;
+}
 
 static sw_inline swString* swTaskWorker_large_unpack(swEventData *task_result)
 {
     swPackage_task _pkg;
     memcpy(&_pkg, task_result->data, sizeof(_pkg));
 
+    if (_pkg.data)
+    {
+        if (SwooleTG.buffer_stack->size < _pkg.length && swString_extend_align(SwooleTG.buffer_stack, _pkg.length) < 0)
+        {
+            return NULL;
+        }
+        memcpy(SwooleTG.buffer_stack->str, _pkg.data, _pkg.length);
+        if (!(swTask_type(task_result) & SW_TASK_PEEK))
+        {
+            SwooleG.serv->task_pool->free(SwooleG.serv->task_pool, _pkg.data);
+        }
+        SwooleTG.buffer_stack->length = _pkg.length;
+        return SwooleTG.buffer_stack;
+    }
+
     int tmp_file_fd = open(_pkg.tmpfile, O_RDONLY);
     if (tmp_file_fd < 0)
     {
@@ -810,8 +1068,10 @@ static sw_inline swString* swTaskWorker_large_unpack(swEventData *task_result)
     return SwooleTG.buffer_stack;
 }
 
-#define swPackage_data(task) ((task->info.type==SW_EVENT_PACKAGE_END)?SwooleWG.buffer_input[task->info.from_id]->str:task->data)
-#define swPackage_length(task) ((task->info.type==SW_EVENT_PACKAGE_END)?SwooleWG.buffer_input[task->info.from_id]->length:task->info.len)
+#define swPackage_data(task) ((task->info.type==SW_EVENT_PACKAGE_END)?SwooleWG.buffer_input[task->info.from_id]->str:\
+        (task->info.type==SW_EVENT_PACKAGE)?(char *)((swPackage *)task->data)->data:task->data)
+#define swPackage_length(task) ((task->info.type==SW_EVENT_PACKAGE_END)?SwooleWG.buffer_input[task->info.from_id]->length:\
+        (task->info.type==SW_EVENT_PACKAGE)?((swPackage *)task->data)->length:task->info.len)
 
 #define SW_SERVER_MAX_FD_INDEX          0 //max connection socket
 #define SW_SERVER_MIN_FD_INDEX          1 //min listen socket
@@ -825,6 +1085,8 @@ static sw_inline swString* swTaskWorker_large_unpack(swEventData *task_result)
 #define swServer_get_minfd(serv) (serv->connection_list[SW_SERVER_MIN_FD_INDEX].fd)
 
 #define swServer_get_thread(serv, reactor_id)    (&(serv->reactor_threads[reactor_id]))
+#define swServer_get_request_ring(serv, worker_id, reactor_id)    (serv->request_rings[(worker_id) * serv->reactor_num + (reactor_id)])
+#define swServer_get_response_ring(serv, worker_id, reactor_id)   (serv->response_rings[(worker_id) * serv->reactor_num + (reactor_id)])
 
 static sw_inline swConnection* swServer_connection_get(swServer *serv, int fd)
 {
@@ -873,6 +1135,86 @@ static sw_inline swWorker* swServer_get_worker(swServer *serv, uint16_t worker_i
     return NULL;
 }
 
+/**
+ * the workers at or above run_worker_num are stopped by the autoscaling, the messages to them are lost
+ */
+static sw_inline uint32_t swServer_run_worker_num(swServer *serv)
+{
+    return serv->min_worker_num > 0 ? serv->gs->event_workers.run_worker_num : serv->worker_num;
+}
+
+static sw_inline int swServer_worker_is_running(swServer *serv, uint16_t worker_id)
+{
+    if (worker_id < serv->worker_num)
+    {
+        return worker_id < swServer_run_worker_num(serv);
+    }
+    if (worker_id < serv->worker_num + serv->task_worker_num)
+    {
+        return serv->task_min_worker_num == 0 || worker_id - serv->worker_num < serv->gs->task_workers.run_worker_num;
+    }
+    return 1;
+}
+
+int swServer_create_hash_ring(swServer *serv);
+int swServer_worker_schedule_chash(swServer *serv, uint32_t key);
+
+/**
+ * SW_DISPATCH_P2C/SW_DISPATCH_EWMA/SW_DISPATCH_CHASH count the messages in flight
+ */
+#define swServer_dispatch_count_enable(serv)   ((serv)->dispatch_mode == SW_DISPATCH_P2C || (serv)->dispatch_mode == SW_DISPATCH_EWMA \
+        || (serv)->dispatch_mode == SW_DISPATCH_CHASH)
+/**
+ * the messages of a connection may go to any worker, onConnect/onClose are disabled.
+ * SW_DISPATCH_CHASH keeps a connection on its worker unless the worker is overloaded
+ */
+#define swServer_dispatch_unbound(serv)        ((serv)->dispatch_mode == SW_DISPATCH_ROUND || (serv)->dispatch_mode == SW_DISPATCH_QUEUE \
+        || (serv)->dispatch_mode == SW_DISPATCH_P2C || (serv)->dispatch_mode == SW_DISPATCH_EWMA)
+
+static sw_inline uint64_t swServer_worker_load(swServer *serv, swWorker *worker)
+{
+    int32_t n = (int32_t) (worker->dispatch_count - worker->finish_count);
+    //the worker may finish a message before the reactor thread counts it
+    uint64_t load = n > 0 ? n : 0;
+    if (serv->dispatch_mode == SW_DISPATCH_EWMA)
+    {
+        //the expected waiting time of a new message
+        load = (load + 1) * (worker->process_usec + 1);
+    }
+    return load;
+}
+
+/**
+ * power of two choices, compare two random workers and take the less loaded one
+ */
+static sw_inline int swServer_worker_schedule_p2c(swServer *serv)
+{
+    //the workers above it are stopped by the manager
+    uint32_t worker_num = swServer_run_worker_num(serv);
+    if (worker_num == 1)
+    {
+        return 0;
+    }
+    //xorshift32
+    uint32_t x = SwooleTG.dispatch_seed;
+    if (unlikely(x == 0))
+    {
+        x = (SwooleTG.id + 1) * 2654435761U;
+    }
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    SwooleTG.dispatch_seed = x;
+
+    uint32_t a = (x & 0xffff) % worker_num;
+    uint32_t b = (x >> 16) % (worker_num - 1);
+    if (b >= a)
+    {
+        b++;
+    }
+    return swServer_worker_load(serv, &serv->workers[b]) < swServer_worker_load(serv, &serv->workers[a]) ? b : a;
+}
+
 static sw_inline int swServer_worker_schedule(swServer *serv, int fd, swEventData *data)
 {
     uint32_t key;
@@ -928,6 +1270,17 @@ static sw_inline int swServer_worker_schedule(swServer *serv, int fd, swEventDat
     {
         return serv->dispatch_func(serv, swServer_connection_get(serv, fd), data);
     }
+    //consistent hash of the uid, or the fd if the connection is not bound
+    else if (serv->dispatch_mode == SW_DISPATCH_CHASH)
+    {
+        swConnection *conn = swServer_connection_get(serv, fd);
+        return swServer_worker_schedule_chash(serv, (conn == NULL || conn->uid == 0) ? fd : conn->uid);
+    }
+    //least loaded of two random workers
+    else if (serv->dispatch_mode == SW_DISPATCH_P2C || serv->dispatch_mode == SW_DISPATCH_EWMA)
+    {
+        return swServer_worker_schedule_p2c(serv);
+    }
     //Preemptive distribution
     else
     {
@@ -962,6 +1315,7 @@ void swServer_set_callback_onClose(swServer *serv, void (*callback)(swServer *,
 
 int swWorker_create(swWorker *worker);
 int swWorker_onTask(swFactory *factory, swEventData *task);
+int swWorker_onRingReceive(swReactor *reactor, swEvent *event);
 
 static sw_inline swConnection *swWorker_get_connection(swServer *serv, int session_id)
 {
@@ -1019,6 +1373,64 @@ static sw_inline swConnection *swServer_connection_verify(swServer *serv, int se
     return conn;
 }
 
+/**
+ * enable_reactor_steal: conn->route holds the reactor thread of the connection and the messages in flight between
+ * the reactor thread and the workers. A connection only moves while nothing is in flight,
+ * so the responses never go to the old thread, and the requests never overtake each other.
+ */
+#define SW_CONNECTION_ROUTE_SHIFT     22
+#define SW_CONNECTION_ROUTE_MASK      ((1 << SW_CONNECTION_ROUTE_SHIFT) - 1)
+#define SW_CONNECTION_ROUTE_LOCKED    1023
+
+/**
+ * count a message and get the reactor thread which handles it
+ */
+static sw_inline int swServer_connection_route_acquire(swServer *serv, swConnection *conn)
+{
+    if (!serv->enable_reactor_steal)
+    {
+        return conn->from_id;
+    }
+    while (1)
+    {
+        uint32_t reactor_id = sw_atomic_fetch_add(&conn->route, 1) >> SW_CONNECTION_ROUTE_SHIFT;
+        if (likely(reactor_id != SW_CONNECTION_ROUTE_LOCKED))
+        {
+            return reactor_id;
+        }
+        //moving to another reactor thread
+        sw_atomic_fetch_sub(&conn->route, 1);
+        swYield();
+    }
+}
+
+static sw_inline void swServer_connection_route_release(swServer *serv, swConnection *conn)
+{
+    if (!serv->enable_reactor_steal)
+    {
+        return;
+    }
+    uint32_t route;
+    do
+    {
+        route = conn->route;
+        //reset by a new connection
+        if ((route & SW_CONNECTION_ROUTE_MASK) == 0)
+        {
+            return;
+        }
+    } while (!sw_atomic_cmp_set(&conn->route, route, route - 1));
+}
+
+static sw_inline void swServer_connection_route_set(swConnection *conn, uint32_t reactor_id)
+{
+    uint32_t route;
+    do
+    {
+        route = conn->route;
+    } while (!sw_atomic_cmp_set(&conn->route, route, (reactor_id << SW_CONNECTION_ROUTE_SHIFT) | (route & SW_CONNECTION_ROUTE_MASK)));
+}
+
 void swPort_init(swListenPort *port);
 void swPort_free(swListenPort *port);
 void swPort_set_protocol(swListenPort *ls);
@@ -1055,18 +1467,68 @@ static sw_inline int swWorker_get_send_pipe(swServer *serv, int session_id, int
 
 int swReactorThread_create(swServer *serv);
 int swReactorThread_start(swServer *serv, swReactor *main_reactor_ptr);
+#ifdef HAVE_REUSEPORT
+int swReactorThread_reuse_port(swServer *serv, swListenPort *ls);
+#endif
 void swReactorThread_set_protocol(swServer *serv, swReactor *reactor);
 void swReactorThread_free(swServer *serv);
 int swReactorThread_close(swReactor *reactor, int fd);
 int swReactorThread_onClose(swReactor *reactor, swEvent *event);
+int swReactorThread_onRingReceive(swReactor *reactor, swEvent *ev);
 int swReactorThread_dispatch(swConnection *conn, char *data, uint32_t length);
 int swReactorThread_send(swSendData *_send);
 int swReactorThread_send2worker(void *data, int len, uint16_t target_worker_id);
 
+/**
+ * release the shared memory of SW_EVENT_PACKAGE
+ */
+static sw_inline void swReactorThread_free_package(swServer *serv, swEventData *task)
+{
+    swPackage package;
+    memcpy(&package, task->data, sizeof(package));
+    swReactorThread *thread = swServer_get_thread(serv, task->info.from_id);
+#ifdef SW_USE_RINGBUFFER
+    thread->buffer_input->free(thread->buffer_input, package.data);
+#else
+    thread->package_pool->free(thread->package_pool, package.data);
+#endif
+}
+
 int swReactorProcess_create(swServer *serv);
 int swReactorProcess_start(swServer *serv);
 int swReactorProcess_onClose(swReactor *reactor, swEvent *event);
 
+/**
+ * autoscaling of a worker pool, sampled by the manager
+ */
+typedef struct
+{
+    uint16_t min_num;
+    uint16_t max_num;
+    uint16_t busy_ticks;
+    uint16_t idle_ticks;
+    /**
+     * the workers which have been stopped, [0, max_num)
+     */
+    pid_t *stopped;
+} swAutoscale;
+
+typedef struct
+{
+    uint32_t run_num;
+    uint32_t idle_num;
+    /**
+     * messages waiting for a worker
+     */
+    uint32_t queue_num;
+    /**
+     * average time spent on a message, microseconds, 0 if unknown
+     */
+    uint32_t process_usec;
+} swAutoscaleSample;
+
+int swAutoscale_target(swAutoscale *as, swAutoscaleSample *sample);
+
 int swManager_start(swFactory *factory);
 pid_t swManager_spawn_user_worker(swServer *serv, swWorker* worker);
 int swManager_wait_user_worker(swProcessPool *pool, pid_t pid, int status);
@@ -159,6 +159,7 @@ typedef unsigned long ulong_t;
 #include "hashmap.h"
 #include "list.h"
 #include "heap.h"
+#include "histogram.h"
 #include "ring_queue.h"
 #include "array.h"
 #include "error.h"
@@ -253,6 +254,7 @@ enum swFd_type //描述符事件
     SW_FD_USER            = 15, //SW_FD_USER or SW_FD_USER+n: for custom event
     SW_FD_STREAM_CLIENT   = 16, //swClient stream
     SW_FD_DGRAM_CLIENT    = 17, //swClient dgram
+    SW_FD_IPC_RING        = 18, //doorbell of the shared memory rings
 };
 
 enum swBool_type
@@ -268,6 +270,7 @@ enum swEvent_type //事件类型
     SW_EVENT_WRITE = 1u << 10,//10000000000  写事件
     SW_EVENT_ERROR = 1u << 11,//100000000000  错误事件
     SW_EVENT_ONCE = 1u << 12, //1000000000000  只监听一次事件
+    SW_EVENT_EXCLUSIVE = 1u << 13, //多个 reactor 监听同一个 fd 时只唤醒其中一个 (EPOLLEXCLUSIVE)
 };
 
 enum swPipe_type
@@ -324,6 +327,9 @@ enum swFactory_dispatch_mode
     SW_DISPATCH_UIDMOD   = 5,
     SW_DISPATCH_USERFUNC = 6,
     SW_DISPATCH_STREAM   = 7,
+    SW_DISPATCH_P2C      = 8,
+    SW_DISPATCH_EWMA     = 9,
+    SW_DISPATCH_CHASH    = 10,
 };
 
 enum swWorker_status
@@ -525,6 +531,10 @@ typedef struct _swConnection
     uint8_t http_upgrade;
     uint8_t http2_stream;
     uint8_t skip_recv;
+    /**
+     * output_memory_high_watermark: the reads are paused until the output memory is below the low watermark
+     */
+    uint8_t recv_paused;
     //--------------------------------------------------------------
     /**
      * server is actively close the connection
@@ -601,6 +611,10 @@ typedef struct _swConnection
 
 #ifdef SW_USE_TIMEWHEEL
     uint16_t timewheel_index;
+    /**
+     * moved by enable_reactor_steal, added to the wheel of the new reactor thread on its first event
+     */
+    uint8_t timewheel_moved;
 #endif
 
     /**
@@ -630,6 +644,40 @@ typedef struct _swConnection
 #endif
     sw_atomic_t lock;
 
+    /**
+     * enable_reactor_steal: [reactor id:10][messages in flight:22], see swServer_connection_route_acquire()
+     */
+    sw_atomic_t route;
+    /**
+     * enable_reactor_steal: read events in the period of the reactor thread
+     */
+    uint16_t steal_period;
+    uint32_t steal_events;
+
+    /**
+     * zerocopy_threshold: the large chunks are sent with MSG_ZEROCOPY,
+     * they stay in zerocopy_buffer until the kernel has completed zerocopy_seq sends
+     */
+    uint8_t zerocopy;
+    uint8_t zerocopy_copied;
+    uint32_t zerocopy_seq;
+    uint32_t zerocopy_done;
+    struct _swBuffer *zerocopy_buffer;
+
+#ifdef HAVE_IO_URING
+    /**
+     * result of the completed recv request, length > 0: data, 0: closed, < 0: -errno
+     */
+    uint8_t completion;
+    uint8_t completion_recv;
+    int32_t completion_length;
+    char *completion_data;
+    /**
+     * copy of the data which is not consumed
+     */
+    char *completion_stash;
+#endif
+
 #ifdef SW_DEBUG
     size_t total_recv_bytes;
     size_t total_send_bytes;
@@ -849,6 +897,97 @@ static inline int swPipeNotify_auto(swPipe *p, int blocking, int semaphore)
 
 void swBreakPoint(void);
 
+//------------------Shared memory ring--------------------
+/**
+ * lock-free single-producer single-consumer ring in shared memory,
+ * variable length records, the producer owns tail and the consumer owns head.
+ */
+typedef struct _swShmRing
+{
+    sw_atomic_ulong_t head;
+    char _pad1[SW_CACHELINE_SIZE - sizeof(sw_atomic_ulong_t)];
+    sw_atomic_ulong_t tail;
+    char _pad2[SW_CACHELINE_SIZE - sizeof(sw_atomic_ulong_t)];
+    /**
+     * the producer found the ring full, the consumer must ring its doorbell after freeing space
+     */
+    sw_atomic_t waiting;
+    uint32_t size;
+    char data[0];
+} swShmRing;
+
+/**
+ * eventfd that is only written when the consumer is about to sleep
+ */
+typedef struct _swDoorbell
+{
+    swPipe pipe;
+    sw_atomic_t sleeping;
+} swDoorbell;
+
+swShmRing* swShmRing_new(uint32_t size);
+void swShmRing_free(swShmRing *ring);
+int swShmRing_push(swShmRing *ring, void *data, uint32_t length);
+int swShmRing_pop(swShmRing *ring, void *buf, uint32_t size);
+
+int swDoorbell_create(swDoorbell *bell);
+void swDoorbell_free(swDoorbell *bell);
+
+static sw_inline int swShmRing_empty(swShmRing *ring)
+{
+    return sw_atomic_load_acquire(&ring->tail) == ring->head;
+}
+
+static sw_inline int swDoorbell_getFd(swDoorbell *bell)
+{
+    return bell->pipe.getFd(&bell->pipe, 0);
+}
+
+/**
+ * unconditional wakeup
+ */
+static sw_inline void swDoorbell_notify(swDoorbell *bell)
+{
+    uint64_t flag = 1;
+    bell->pipe.write(&bell->pipe, &flag, sizeof(flag));
+}
+
+/**
+ * wake up the consumer after a push, no syscall unless it is sleeping
+ */
+static sw_inline void swDoorbell_ring(swDoorbell *bell)
+{
+    //order the tail store before the sleeping load, pairs with swDoorbell_sleep
+    sw_atomic_memory_barrier();
+    if (bell->sleeping && sw_atomic_cmp_set(&bell->sleeping, 1, 0))
+    {
+        swDoorbell_notify(bell);
+    }
+}
+
+/**
+ * the consumer has drained its rings, the caller must check them once more before it really sleeps
+ */
+static sw_inline void swDoorbell_sleep(swDoorbell *bell)
+{
+    bell->sleeping = 1;
+    sw_atomic_memory_barrier();
+}
+
+/**
+ * the rings were not empty after swDoorbell_sleep, SW_FALSE if a producer has already rung
+ */
+static sw_inline int swDoorbell_wakeup(swDoorbell *bell)
+{
+    return sw_atomic_cmp_set(&bell->sleeping, 1, 0);
+}
+
+static sw_inline void swDoorbell_clear(swDoorbell *bell)
+{
+    uint64_t flag;
+    bell->pipe.read(&bell->pipe, &flag, sizeof(flag));
+}
+
 //------------------Queue--------------------
 typedef struct _swQueue_Data
 {
@@ -1068,6 +1207,11 @@ swMemoryPool *swRingBuffer_new(uint32_t size, uint8_t shared);
  */
 swMemoryPool* swMemoryGlobal_new(uint32_t pagesize, uint8_t shared);
 
+/**
+ * SlabPool, shared memory pages, alloc by one thread and free by any process
+ */
+swMemoryPool* swSlabPool_new(uint32_t size, uint32_t page_size);
+
 void swFixedPool_debug(swMemoryPool *pool);
 
 /**
@@ -1077,6 +1221,7 @@ void* sw_shm_malloc(size_t size);
 void sw_shm_free(void *ptr);
 void* sw_shm_calloc(size_t num, size_t _size);
 int sw_shm_protect(void *addr, int flags);
+int sw_shm_bind(void *addr, int node);
 void* sw_shm_realloc(void *ptr, size_t new_size);
 #ifdef HAVE_RWLOCK
 int swRWLock_create(swLock *lock, int use_in_process);
@@ -1275,6 +1420,8 @@ void swoole_dump_ascii(char *data, int size);
 int swoole_sync_writefile(int fd, void *data, int len);
 int swoole_sync_readfile(int fd, void *buf, int len);
 int swoole_rand(int min, int max);
+int swoole_get_numa_node(void);
+int swoole_get_cpu_numa_node(int cpu);
 int swoole_system_random(int min, int max);
 long swoole_file_get_size(FILE *fp);
 int swoole_tmpfile(char *filename);
@@ -1325,6 +1472,16 @@ SW_API void* swoole_get_function(char *name, uint32_t length);
 SW_API int swoole_add_hook(enum swGlobal_hook_type type, swCallback func, int push_back);
 SW_API void swoole_call_hook(enum swGlobal_hook_type type, void *arg);
 
+/**
+ * monotonic time in microseconds, for measuring intervals
+ */
+static sw_inline uint64_t swoole_monotonic_usec(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
 static sw_inline uint64_t swoole_hton64(uint64_t host)
 {
     uint64_t ret = 0;
@@ -1362,6 +1519,30 @@ int swSocket_wait(int fd, int timeout_ms, int events);
 int swSocket_wait_multi(int *list_of_fd, int n_fd, int timeout_ms, int events);
 void swSocket_clean(int fd);
 int swSocket_sendto_blocking(int fd, void *__buf, size_t __n, int flag, struct sockaddr *__addr, socklen_t __addr_len);
+
+/**
+ * the datagrams are sent with sendmmsg,
+ * a run of the same size to the same address is sent as one UDP_SEGMENT (GSO) message
+ */
+typedef struct
+{
+    int fd;
+    uint32_t offset;
+    uint32_t length;
+    swSocketAddress addr;
+} swDgramBatch_item;
+
+typedef struct _swDgramBatch
+{
+    uint32_t num;
+    uint32_t length;
+    uint8_t gso_disabled;
+    swDgramBatch_item items[SW_UDP_SEND_BATCH_SIZE];
+    char buffer[SW_UDP_SEND_BATCH_BUFFER];
+} swDgramBatch;
+
+int swDgramBatch_push(swDgramBatch *batch, int fd, void *data, size_t length, struct sockaddr *addr, socklen_t addr_len);
+void swDgramBatch_flush(swDgramBatch *batch);
 int swSocket_set_buffer_size(int fd, int buffer_size);
 int swSocket_udp_sendto(int server_sock, char *dst_ip, int dst_port, char *data, uint32_t len);
 int swSocket_udp_sendto6(int server_sock, char *dst_ip, int dst_port, char *data, uint32_t len);
@@ -1470,6 +1651,29 @@ struct _swReactor //核心关键结构  为事件处理提供底层支持
 
     uint32_t max_socket;
 
+    /**
+     * busy poll: spin on the non-blocking wait before blocking (microseconds),
+     * busy_poll_budget adapts to the recent spin results.
+     */
+    uint32_t busy_poll_usec;
+    uint32_t busy_poll_budget;
+    uint64_t spin_time;
+    uint64_t block_time;
+    uint64_t spin_hit_count;
+    uint64_t spin_miss_count;
+
+    /**
+     * time spent in each event callback (microseconds), NULL if disabled
+     */
+    swHistogram *latency;
+    uint8_t latency_max_fdtype;
+
+    /**
+     * coarse clocks, refreshed once per loop iteration by swReactor_update_time()
+     */
+    time_t now;
+    int64_t now_msec;
+
 #ifdef SW_USE_MALLOC_TRIM
     time_t last_malloc_trim_time;
 #endif
@@ -1493,6 +1697,15 @@ struct _swReactor //核心关键结构  为事件处理提供底层支持
     swReactor_handle handle[SW_MAX_FDTYPE];        //默认事件  SW_MAX_FDTYPE = 32
     swReactor_handle write_handle[SW_MAX_FDTYPE];  //扩展事件1(一般为写事件)
     swReactor_handle error_handle[SW_MAX_FDTYPE];  //扩展事件2(一般为错误事件,如socket关闭)
+#ifdef SW_REACTOR_FAST_DISPATCH
+    /**
+     * the read handlers of the hottest fd types, kept by setHandle,
+     * the event loop calls each of them from its own call site
+     */
+    swReactor_handle tcp_read_handle;
+    swReactor_handle pipe_read_handle;
+    swReactor_handle listen_read_handle;
+#endif
     //给特定描述符事件追加，设置，删除监听
     int (*add)(swReactor *, int fd, int fdtype);
     int (*set)(swReactor *, int fd, int fdtype);
@@ -1501,7 +1714,15 @@ struct _swReactor //核心关键结构  为事件处理提供底层支持
     void (*free)(swReactor *);
     //设置事件回调函数
     int (*setHandle)(swReactor *, int fdtype, swReactor_handle); //这个实体函数执行后 会把回调函数放到 handle或write_handle中
+    /**
+     * defer tasks, a ring buffer drained in batches by onFinish/onTimeout
+     */
     swDefer_callback *defer_tasks;
+    uint32_t defer_size;
+    uint32_t defer_head;
+    uint32_t defer_count;
+    uint32_t defer_max_count;
+    uint64_t defer_total;
     swDefer_callback idle_task;
     swDefer_callback future_task;
 
@@ -1575,6 +1796,17 @@ struct _swWorker
 
     long request_count;
 
+    /**
+     * SW_DISPATCH_P2C/SW_DISPATCH_EWMA: messages sent by the reactor threads and messages handled by the worker,
+     * the difference is the number of messages in flight
+     */
+    sw_atomic_t dispatch_count;
+    sw_atomic_t finish_count;
+    /**
+     * SW_DISPATCH_EWMA and min_worker_num: moving average of the time spent on a message, microseconds
+     */
+    sw_atomic_t process_usec;
+
 	/**
 	 * worker id
 	 */
@@ -1704,7 +1936,7 @@ static sw_inline int swReactor_event_error(int fdtype)
 //取得 fd 类型
 static sw_inline int swReactor_fdtype(int fdtype)
 {
-    return fdtype & (~SW_EVENT_READ) & (~SW_EVENT_WRITE) & (~SW_EVENT_ERROR);
+    return fdtype & (~SW_EVENT_READ) & (~SW_EVENT_WRITE) & (~SW_EVENT_ERROR) & (~SW_EVENT_EXCLUSIVE);
 }
 
 static sw_inline int swReactor_events(int fdtype)
@@ -1726,6 +1958,10 @@ static sw_inline int swReactor_events(int fdtype)
     {
         events |= SW_EVENT_ONCE;
     }
+    if (fdtype & SW_EVENT_EXCLUSIVE)
+    {
+        events |= SW_EVENT_EXCLUSIVE;
+    }
     return events;
 }
 
@@ -1784,6 +2020,7 @@ int swReactor_close(swReactor *reactor, int fd);
 int swReactor_write(swReactor *reactor, int fd, void *buf, int n);
 int swReactor_wait_write_buffer(swReactor *reactor, int fd);
 void swReactor_activate_future_task(swReactor *reactor);
+void swReactor_free_defer_tasks(swReactor *reactor);
 
 static sw_inline int swReactor_add_event(swReactor *reactor, int fd, enum swEvent_type event_type)
 {
@@ -1832,7 +2069,71 @@ static sw_inline swReactor_handle swReactor_getHandle(swReactor *reactor, int ev
     return reactor->handle[fdtype];
 }
 
+#if defined(CLOCK_MONOTONIC_COARSE) && defined(CLOCK_REALTIME_COARSE)
+#define SW_CLOCK_MONOTONIC     CLOCK_MONOTONIC_COARSE
+#define SW_CLOCK_REALTIME      CLOCK_REALTIME_COARSE
+#else
+#define SW_CLOCK_MONOTONIC     CLOCK_MONOTONIC
+#define SW_CLOCK_REALTIME      CLOCK_REALTIME
+#endif
+
+static sw_inline void swReactor_update_time(swReactor *reactor)
+{
+    struct timespec ts;
+    clock_gettime(SW_CLOCK_MONOTONIC, &ts);
+    reactor->now_msec = (int64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+    clock_gettime(SW_CLOCK_REALTIME, &ts);
+    reactor->now = ts.tv_sec;
+}
+
+/**
+ * wall clock seconds of the current loop iteration
+ */
+static sw_inline time_t swReactor_now(swReactor *reactor)
+{
+    if (unlikely(reactor == NULL || reactor->now == 0))
+    {
+        return time(NULL);
+    }
+    return reactor->now;
+}
+
+/**
+ * monotonic milliseconds of the current loop iteration
+ */
+static sw_inline int64_t swReactor_now_msec(swReactor *reactor)
+{
+    if (unlikely(reactor == NULL || reactor->now_msec == 0))
+    {
+        struct timespec ts;
+        clock_gettime(SW_CLOCK_MONOTONIC, &ts);
+        return (int64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+    }
+    return reactor->now_msec;
+}
+
+static sw_inline int swReactor_call(swReactor *reactor, swReactor_handle handle, swEvent *event)
+{
+    if (likely(reactor->latency == NULL))
+    {
+        return handle(reactor, event);
+    }
+    uint64_t begin = swoole_monotonic_usec();
+    int ret = handle(reactor, event);
+    uint64_t usec = swoole_monotonic_usec() - begin;
+    if (usec > reactor->latency->max)
+    {
+        reactor->latency_max_fdtype = event->type;
+    }
+    swHistogram_record(reactor->latency, usec);
+    return ret;
+}
+
 int swReactorEpoll_create(swReactor *reactor, int max_event_num);
+#ifdef HAVE_IO_URING
+int swReactorIOUring_create(swReactor *reactor, int max_event_num);
+int swReactorIOUring_enable_completion(swReactor *reactor, uint32_t buffer_num, uint32_t buffer_size);
+#endif
 int swReactorPoll_create(swReactor *reactor, int max_event_num);
 int swReactorKqueue_create(swReactor *reactor, int max_event_num);
 int swReactorSelect_create(swReactor *reactor);
@@ -1969,11 +2270,23 @@ int swProtocol_recv_check_eof(swProtocol *protocol, swConnection *conn, swString
 typedef struct _swTimer swTimer;
 typedef struct _swTimer_node swTimer_node;
 
+typedef struct _swTimerWheel swTimerWheel;
+
 typedef void (*swTimerCallback)(swTimer *, swTimer_node *);
 
+typedef struct _swTimer_link
+{
+    struct _swTimer_link *prev, *next;
+} swTimer_link;
+
 struct _swTimer_node
 {
     swHeap_node *heap_node;
+    /**
+     * for the timer wheel, the slot list and the index of the slot
+     */
+    swTimer_link link;
+    uint32_t slot;
     void *data;
     swTimerCallback callback;
     int64_t exec_msec;
@@ -2005,6 +2318,19 @@ struct _swTimer
     swPipe pipe;
     /*-----------------for EventTimer-------------------*/
     struct timeval basetime;
+    /**
+     * delay between exec_msec and the actual firing (microseconds), NULL if disabled
+     */
+    swHistogram *lag;
+    /**
+     * hierarchical timer wheel, used instead of the heap if not NULL
+     */
+    swTimerWheel *wheel;
+    /**
+     * free nodes, chained through tnode->data
+     */
+    swTimer_node *node_pool;
+    uint32_t node_pool_num;
     /*--------------------------------------------------*/
     int (*set)(swTimer *timer, long exec_msec);
     swTimer_node* (*add)(swTimer *timer, int _msec, int persistent, void *data, swTimerCallback callback);
@@ -2021,6 +2347,13 @@ static sw_inline swTimer_node* swTimer_get(swTimer *timer, long id)
     return (swTimer_node*) swHashMap_find_int(timer->map, id);
 }
 
+swTimerWheel* swTimerWheel_new(int64_t now_msec);
+void swTimerWheel_free(swTimerWheel *wheel);
+void swTimerWheel_add(swTimerWheel *wheel, swTimer_node *tnode);
+void swTimerWheel_remove(swTimerWheel *wheel, swTimer_node *tnode);
+swTimer_node* swTimerWheel_pop(swTimerWheel *wheel, int64_t now_msec);
+int64_t swTimerWheel_next(swTimerWheel *wheel);
+
 int swSystemTimer_init(int msec, int use_pipe);
 void swSystemTimer_signal_handler(int sig);
 int swSystemTimer_event_handler(swReactor *reactor, swEvent *event);
@@ -2071,6 +2404,14 @@ typedef struct
     swString **buffer_input;
     swString **buffer_output;
     swWorker *worker;
+    /**
+     * SW_IPC_RING: responses waiting for the ring of each reactor thread
+     */
+    struct _swBuffer **ring_buffer;
+    /**
+     * SW_EVENT_UDP_BATCH: the replies are queued until the batch is finished
+     */
+    struct _swDgramBatch *dgram_batch;
 
 } swWorkerG;
 
@@ -2081,6 +2422,7 @@ typedef struct
     uint8_t update_time;
     uint8_t factory_lock_target;
     int16_t factory_target_worker;
+    uint32_t dispatch_seed;
     swString **buffer_input;
     swString *buffer_stack;
     swReactor *reactor;
@@ -2116,6 +2458,21 @@ typedef struct
      */
     uint8_t use_timer_pipe :1;
 
+    /**
+     * use io_uring instead of epoll
+     */
+    uint8_t enable_io_uring :1;
+
+    /**
+     * record the reactor callback latency and the timer lag
+     */
+    uint8_t enable_latency_stats :1;
+
+    /**
+     * use the hierarchical timer wheel instead of the min-heap
+     */
+    uint8_t enable_timer_wheel :1;
+
     int error;
     int process_type;
     pid_t pid;
@@ -21,6 +21,10 @@
 #include <sys/stat.h>
 #include <sys/resource.h>
 #include <sys/ioctl.h>
+#include <dirent.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 
 #ifdef HAVE_EXECINFO
 #include <execinfo.h>
@@ -376,6 +380,54 @@ int swoole_rand(int min, int max)
     return _rand;
 }
 
+/**
+ * NUMA node of the cpu the calling thread is running on, -1 if unknown
+ */
+int swoole_get_numa_node(void)
+{
+#if defined(__linux__) && defined(SYS_getcpu)
+    unsigned cpu, node;
+    if (syscall(SYS_getcpu, &cpu, &node, NULL) < 0)
+    {
+        return SW_ERR;
+    }
+    return node;
+#else
+    return SW_ERR;
+#endif
+}
+
+/**
+ * NUMA node of the cpu, from sysfs, -1 if unknown
+ */
+int swoole_get_cpu_numa_node(int cpu)
+{
+#ifdef __linux__
+    char path[64];
+    struct dirent *entry;
+    int node = SW_ERR;
+
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+    DIR *dir = opendir(path);
+    if (dir == NULL)
+    {
+        return SW_ERR;
+    }
+    while ((entry = readdir(dir)) != NULL)
+    {
+        if (strncmp(entry->d_name, "node", 4) == 0 && isdigit((unsigned char) entry->d_name[4]))
+        {
+            node = atoi(entry->d_name + 4);
+            break;
+        }
+    }
+    closedir(dir);
+    return node;
+#else
+    return SW_ERR;
+#endif
+}
+
 int swoole_system_random(int min, int max)
 {
     static int dev_random_fd = -1;
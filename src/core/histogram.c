@@ -0,0 +1,88 @@
+/*
+ +----------------------------------------------------------------------+
+ | Swoole                                                               |
+ +----------------------------------------------------------------------+
+ | This source file is subject to version 2.0 of the Apache license,    |
+ | that is bundled with this package in the file LICENSE, and is        |
+ | available through the world-wide-web at the following url:           |
+ | http://www.apache.org/licenses/LICENSE-2.0.html                      |
+ | If you did not receive a copy of the Apache2.0 license and are unable|
+ | to obtain it through the world-wide-web, please send a note to       |
+ | license@swoole.com so we can mail you a copy immediately.            |
+ +----------------------------------------------------------------------+
+ | Author: Tianfeng Han  <mikan.tenny@gmail.com>                        |
+ +----------------------------------------------------------------------+
+ */
+
+#include "swoole.h"
+#include "histogram.h"
+
+swHistogram* swHistogram_new(void)
+{
+    swHistogram *hist = sw_calloc(1, sizeof(swHistogram));
+    if (hist == NULL)
+    {
+        swWarn("calloc(%ld) failed.", sizeof(swHistogram));
+        return NULL;
+    }
+    return hist;
+}
+
+void swHistogram_free(swHistogram *hist)
+{
+    sw_free(hist);
+}
+
+void swHistogram_reset(swHistogram *hist)
+{
+    bzero(hist, sizeof(swHistogram));
+}
+
+/**
+ * the largest value that falls into the bucket
+ */
+uint64_t swHistogram_bucket_value(uint32_t index)
+{
+    if (index < SW_HISTOGRAM_SUB_COUNT)
+    {
+        return index;
+    }
+    uint32_t shift = (index >> SW_HISTOGRAM_SUB_BITS) - 1;
+    uint64_t sub = index & (SW_HISTOGRAM_SUB_COUNT - 1);
+    uint64_t lower = (SW_HISTOGRAM_SUB_COUNT + sub) << shift;
+    return lower + ((1ULL << shift) - 1);
+}
+
+/**
+ * percentile in (0, 100], returns the upper bound of the matching bucket
+ */
+uint64_t swHistogram_percentile(swHistogram *hist, double percentile)
+{
+    uint64_t count = hist->count;
+    if (count == 0)
+    {
+        return 0;
+    }
+    uint64_t rank = (uint64_t) (percentile / 100 * count + 0.5);
+    if (rank < 1)
+    {
+        rank = 1;
+    }
+    else if (rank > count)
+    {
+        rank = count;
+    }
+
+    uint64_t n = 0;
+    uint32_t i;
+    for (i = 0; i < SW_HISTOGRAM_BUCKET_NUM; i++)
+    {
+        n += hist->buckets[i];
+        if (n >= rank)
+        {
+            uint64_t value = swHistogram_bucket_value(i);
+            return value > hist->max ? hist->max : value;
+        }
+    }
+    return hist->max;
+}
@@ -19,6 +19,7 @@
 
 #include <sys/stat.h>
 #include <poll.h>
+#include <netinet/udp.h>
 
 int swSocket_sendfile_sync(int sock, char *filename, off_t offset, size_t length, double timeout)
 {
@@ -262,7 +263,7 @@ int swSocket_unix_sendto(int server_sock, char *dst_path, char *data, uint32_t l
     return swSocket_sendto_blocking(server_sock, data, len, 0, (struct sockaddr *) &addr, sizeof(addr));
 }
 
-int swSocket_sendto_blocking(int fd, void *__buf, size_t __n, int flag, struct sockaddr *__addr, socklen_t __addr_len)
+static int swSocket_sendto_wait(int fd, void *__buf, size_t __n, int flag, struct sockaddr *__addr, socklen_t __addr_len)
 {
     int n = 0;
 
@@ -294,6 +295,173 @@ int swSocket_sendto_blocking(int fd, void *__buf, size_t __n, int flag, struct s
     return n;
 }
 
+int swSocket_sendto_blocking(int fd, void *__buf, size_t __n, int flag, struct sockaddr *__addr, socklen_t __addr_len)
+{
+#ifdef HAVE_SENDMMSG
+    //the replies of SW_EVENT_UDP_BATCH
+    if (SwooleWG.dgram_batch && flag == 0
+            && swDgramBatch_push(SwooleWG.dgram_batch, fd, __buf, __n, __addr, __addr_len) == SW_OK)
+    {
+        return __n;
+    }
+#endif
+    return swSocket_sendto_wait(fd, __buf, __n, flag, __addr, __addr_len);
+}
+
+#ifdef HAVE_SENDMMSG
+/**
+ * SW_ERR if the datagram can not be queued, it should be sent at once after the queued ones
+ */
+int swDgramBatch_push(swDgramBatch *batch, int fd, void *data, size_t length, struct sockaddr *addr, socklen_t addr_len)
+{
+    if (length > sizeof(batch->buffer) || addr_len > sizeof(batch->items[0].addr.addr))
+    {
+        swDgramBatch_flush(batch);
+        return SW_ERR;
+    }
+    if (batch->num == SW_UDP_SEND_BATCH_SIZE || batch->length + length > sizeof(batch->buffer))
+    {
+        swDgramBatch_flush(batch);
+    }
+
+    swDgramBatch_item *item = &batch->items[batch->num++];
+    item->fd = fd;
+    item->offset = batch->length;
+    item->length = length;
+    memcpy(&item->addr.addr, addr, addr_len);
+    item->addr.len = addr_len;
+
+    memcpy(batch->buffer + batch->length, data, length);
+    batch->length += length;
+    return SW_OK;
+}
+
+#ifdef UDP_SEGMENT
+/**
+ * the datagrams are contiguous in the buffer, every segment of a GSO message has the same size except the last one
+ */
+static uint32_t swDgramBatch_segments(swDgramBatch *batch, uint32_t i)
+{
+    swDgramBatch_item *item = &batch->items[i];
+    sa_family_t family = ((struct sockaddr *) &item->addr.addr)->sa_family;
+    if (batch->gso_disabled || item->length == 0 || (family != AF_INET && family != AF_INET6))
+    {
+        return 1;
+    }
+
+    uint32_t count = 1;
+    uint32_t size = item->length;
+    while (i + count < batch->num)
+    {
+        swDgramBatch_item *next = &batch->items[i + count];
+        if (next->fd != item->fd || next->length == 0 || next->length > item->length
+                || batch->items[i + count - 1].length != item->length || size + next->length > SW_UDP_GSO_MAX_SIZE
+                || next->addr.len != item->addr.len || memcmp(&next->addr.addr, &item->addr.addr, item->addr.len) != 0)
+        {
+            break;
+        }
+        size += next->length;
+        count++;
+    }
+    return count;
+}
+#endif
+
+void swDgramBatch_flush(swDgramBatch *batch)
+{
+    struct mmsghdr msgs[SW_UDP_SEND_BATCH_SIZE];
+    struct iovec iov[SW_UDP_SEND_BATCH_SIZE];
+    uint32_t first[SW_UDP_SEND_BATCH_SIZE];
+    uint32_t segments[SW_UDP_SEND_BATCH_SIZE];
+#ifdef UDP_SEGMENT
+    union
+    {
+        char buf[CMSG_SPACE(sizeof(uint16_t))];
+        struct cmsghdr align;
+    } control[SW_UDP_SEND_BATCH_SIZE];
+#endif
+
+    uint32_t i = 0, n, j, k;
+    while (i < batch->num)
+    {
+        int fd = batch->items[i].fd;
+        //the messages of the same socket
+        for (n = 0; i < batch->num && batch->items[i].fd == fd; n++)
+        {
+            swDgramBatch_item *item = &batch->items[i];
+            uint32_t count = 1;
+#ifdef UDP_SEGMENT
+            count = swDgramBatch_segments(batch, i);
+#endif
+            bzero(&msgs[n], sizeof(msgs[n]));
+            iov[n].iov_base = batch->buffer + item->offset;
+            iov[n].iov_len = batch->items[i + count - 1].offset + batch->items[i + count - 1].length - item->offset;
+            msgs[n].msg_hdr.msg_name = &item->addr.addr;
+            msgs[n].msg_hdr.msg_namelen = item->addr.len;
+            msgs[n].msg_hdr.msg_iov = &iov[n];
+            msgs[n].msg_hdr.msg_iovlen = 1;
+#ifdef UDP_SEGMENT
+            if (count > 1)
+            {
+                msgs[n].msg_hdr.msg_control = control[n].buf;
+                msgs[n].msg_hdr.msg_controllen = sizeof(control[n].buf);
+                struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msgs[n].msg_hdr);
+                cmsg->cmsg_level = SOL_UDP;
+                cmsg->cmsg_type = UDP_SEGMENT;
+                cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+                *(uint16_t *) CMSG_DATA(cmsg) = item->length;
+            }
+#endif
+            first[n] = i;
+            segments[n] = count;
+            i += count;
+        }
+
+        j = 0;
+        while (j < n)
+        {
+            int ret = sendmmsg(fd, &msgs[j], n - j, 0);
+            if (ret > 0)
+            {
+                j += ret;
+                continue;
+            }
+            else if (ret < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            else if (ret < 0 && swConnection_error(errno) == SW_WAIT)
+            {
+                swSocket_wait(fd, 1000, SW_EVENT_WRITE);
+                continue;
+            }
+            //the first message failed
+            if (segments[j] > 1)
+            {
+                //GSO is not supported by the kernel or the device
+                if (errno == EIO || errno == EINVAL || errno == ENOPROTOOPT || errno == EOPNOTSUPP)
+                {
+                    batch->gso_disabled = 1;
+                }
+                for (k = first[j]; k < first[j] + segments[j]; k++)
+                {
+                    swDgramBatch_item *item = &batch->items[k];
+                    swSocket_sendto_wait(fd, batch->buffer + item->offset, item->length, 0,
+                            (struct sockaddr *) &item->addr.addr, item->addr.len);
+                }
+            }
+            else
+            {
+                swSysError("sendmmsg(%d) failed.", fd);
+            }
+            j++;
+        }
+    }
+    batch->num = 0;
+    batch->length = 0;
+}
+#endif
+
 //建立socket 
 int swSocket_create(int type)
 {
@@ -2,12 +2,16 @@
 
 using namespace swoole;
 
-static void channel_defer_callback(void *data)
+static void channel_notify_producer(void *data)
 {
-    notify_msg_t *msg = (notify_msg_t*) data;
-    coroutine_t *co = msg->chan->pop_coroutine(msg->type);
-    coroutine_resume(co);
-    delete msg;
+    Channel *chan = (Channel *) data;
+    coroutine_resume(chan->pop_coroutine(PRODUCER));
+}
+
+static void channel_notify_consumer(void *data)
+{
+    Channel *chan = (Channel *) data;
+    coroutine_resume(chan->pop_coroutine(CONSUMER));
 }
 
 static void channel_pop_timeout(swTimer *timer, swTimer_node *tnode)
@@ -50,18 +54,16 @@ void Channel::yield(enum channel_op type)
 
 void Channel::notify(enum channel_op type)
 {
-    notify_msg_t *msg = new notify_msg_t;
-    msg->chan = this;
-    msg->type = type;
     if (type == PRODUCER)
     {
         notify_producer_count++;
+        SwooleG.main_reactor->defer(SwooleG.main_reactor, channel_notify_producer, this);
     }
     else
     {
         notify_consumer_count++;
+        SwooleG.main_reactor->defer(SwooleG.main_reactor, channel_notify_consumer, this);
     }
-    SwooleG.main_reactor->defer(SwooleG.main_reactor, channel_defer_callback, msg);
 }
 
 void* Channel::pop(double timeout)
@@ -63,6 +63,8 @@ static int swFactoryProcess_shutdown(swFactory *factory)
         swSysError("waitpid(%d) failed.", serv->gs->manager_pid);
     }
 
+    swServer_free_ipc_ring(serv);
+
     return SW_OK;
 }
 
@@ -83,6 +85,12 @@ static int swFactoryProcess_start(swFactory *factory)
 
     serv->reactor_pipe_num = serv->worker_num / serv->reactor_num;
 
+    if (serv->ipc_mode == SW_IPC_RING && swServer_create_ipc_ring(serv) < 0)
+    {
+        swWarn("create ipc rings failed.");
+        return SW_ERR;
+    }
+
     //必须先启动manager进程组，否则会带线程fork
     if (swManager_start(factory) < 0)
     {
@@ -120,6 +128,7 @@ static int swFactoryProcess_dispatch(swFactory *factory, swDispatchData *task)
     int target_worker_id;
     swServer *serv = SwooleG.serv;
     int fd = task->data.info.fd;
+    swConnection *conn = NULL;
 
     if (task->target_worker_id < 0)
     {
@@ -149,12 +158,12 @@ static int swFactoryProcess_dispatch(swFactory *factory, swDispatchData *task)
     //discard the data packet.
     if (target_worker_id < 0)
     {
-        return SW_OK;
+        goto discard_data;
     }
 
     if (swEventData_is_stream(task->data.info.type))
     {
-        swConnection *conn = swServer_connection_get(serv, fd);
+        conn = swServer_connection_get(serv, fd);
         if (conn == NULL || conn->active == 0)
         {
             swWarn("dispatch[type=%d] failed, connection#%d is not active.", task->data.info.type, fd);
@@ -166,7 +175,7 @@ static int swFactoryProcess_dispatch(swFactory *factory, swDispatchData *task)
             //Connection has been clsoed by server
             if (!(task->data.info.type == SW_EVENT_CLOSE && conn->close_force))
             {
-                return SW_OK;
+                goto discard_data;
             }
         }
         //converted fd to session_id
@@ -174,7 +183,35 @@ static int swFactoryProcess_dispatch(swFactory *factory, swDispatchData *task)
         task->data.info.from_fd = conn->from_fd;
     }
 
-    return swReactorThread_send2worker((void *) &(task->data), send_len, target_worker_id);
+    //counted before it is sent, the worker may release it at once
+    if (serv->enable_reactor_steal && conn)
+    {
+        sw_atomic_fetch_add(&conn->route, 1);
+    }
+    if (swReactorThread_send2worker((void *) &(task->data), send_len, target_worker_id) < 0)
+    {
+        if (serv->enable_reactor_steal && conn)
+        {
+            swServer_connection_route_release(serv, conn);
+        }
+        return SW_ERR;
+    }
+    if (swServer_dispatch_count_enable(serv))
+    {
+        sw_atomic_fetch_add(&serv->workers[target_worker_id].dispatch_count, 1);
+        if (serv->dispatch_mode == SW_DISPATCH_CHASH)
+        {
+            sw_atomic_fetch_add(&serv->gs->dispatch_count, 1);
+        }
+    }
+    return SW_OK;
+
+    discard_data:
+    if (task->data.info.type == SW_EVENT_PACKAGE)
+    {
+        swReactorThread_free_package(serv, &task->data);
+    }
+    return SW_OK;
 }
 
 /**
@@ -200,16 +237,19 @@ static int swFactoryProcess_finish(swFactory *factory, swSendData *resp)
         swoole_error_log(SW_LOG_NOTICE, SW_ERROR_SESSION_NOT_EXIST, "connection[fd=%d] does not exists.", session_id);
         return SW_ERR;
     }
-    else if ((conn->closed || conn->removed) && resp->info.type != SW_EVENT_CLOSE)
+
+    //waits if the connection is moving to another reactor thread
+    int reactor_id = swServer_connection_route_acquire(serv, conn);
+    if ((conn->closed || conn->removed) && resp->info.type != SW_EVENT_CLOSE)
     {
         int _len = resp->length > 0 ? resp->length : resp->info.len;
         swoole_error_log(SW_LOG_NOTICE, SW_ERROR_SESSION_CLOSED, "send %d byte failed, because connection[fd=%d] is closed.", _len, session_id);
-        return SW_ERR;
+        goto release_route;
     }
     else if (conn->overflow)
     {
         swoole_error_log(SW_LOG_WARNING, SW_ERROR_OUTPUT_BUFFER_OVERFLOW, "send failed, connection[fd=%d] output buffer has been overflowed.", session_id);
-        return SW_ERR;
+        goto release_route;
     }
 
     swEventData ev_data;
@@ -230,16 +270,24 @@ static int swFactoryProcess_finish(swFactory *factory, swSendData *resp)
         //worker process
         if (SwooleG.main_reactor)
         {
-            int _pipe_fd = swWorker_get_send_pipe(serv, session_id, conn->from_id);
-            swConnection *_pipe_socket = swReactor_get(SwooleG.main_reactor, _pipe_fd);
+            swBuffer *_pipe_buffer;
+            if (SwooleWG.ring_buffer)
+            {
+                _pipe_buffer = SwooleWG.ring_buffer[reactor_id];
+            }
+            else
+            {
+                int _pipe_fd = swWorker_get_send_pipe(serv, session_id, reactor_id);
+                _pipe_buffer = swReactor_get(SwooleG.main_reactor, _pipe_fd)->out_buffer;
+            }
 
             //cannot use send_shm
-            if (!swBuffer_empty(_pipe_socket->out_buffer))
+            if (!swBuffer_empty(_pipe_buffer))
             {
                 pack_data:
                 if (swTaskWorker_large_pack(&ev_data, resp->data, resp->length) < 0)
                 {
-                    return SW_ERR;
+                    goto release_route;
                 }
                 ev_data.info.from_fd = SW_RESPONSE_TMPFILE;
                 goto send_to_reactor_thread;
@@ -267,7 +315,7 @@ static int swFactoryProcess_finish(swFactory *factory, swSendData *resp)
         ev_data.info.from_fd = SW_RESPONSE_SMALL;
     }
 
-    send_to_reactor_thread: ev_data.info.from_id = conn->from_id;
+    send_to_reactor_thread: ev_data.info.from_id = reactor_id;
     sendn = ev_data.info.len + sizeof(resp->info);
 
     swTrace("[Worker] send: sendn=%d|type=%d|content=<<EOF\n%.*s\nEOF", sendn, resp->info.type, resp->length > 0 ? resp->length : resp->info.len, resp->data);
@@ -275,8 +323,13 @@ static int swFactoryProcess_finish(swFactory *factory, swSendData *resp)
     if (ret < 0)
     {
         swWarn("sendto to reactor failed. Error: %s [%d]", strerror(errno), errno);
+        swServer_connection_route_release(serv, conn);
     }
     return ret;
+
+    release_route:
+    swServer_connection_route_release(serv, conn);
+    return SW_ERR;
 }
 
 static int swFactoryProcess_end(swFactory *factory, int fd)
@@ -197,33 +197,14 @@ static void swFactoryThread_onStart(swThreadPool *pool, int id)
     SwooleTG.id = serv->reactor_num + id;
     SwooleTG.type = SW_THREAD_WORKER;
 
+    //cpu affinity setting, before the buffers are allocated
+    swServer_set_cpu_affinity(serv, serv->worker_cpu_set, serv->worker_cpu_set_num, id);
+
     SwooleTG.buffer_input = swServer_create_worker_buffer(serv);
     if (!SwooleTG.buffer_input)
     {
         return;
     }
-
-    //cpu affinity setting
-#ifdef HAVE_CPU_AFFINITY
-    if (serv->open_cpu_affinity)
-    {
-        cpu_set_t cpu_set;
-        CPU_ZERO(&cpu_set);
-        if (serv->cpu_affinity_available_num)
-        {
-            CPU_SET(serv->cpu_affinity_available[id % serv->cpu_affinity_available_num], &cpu_set);
-        }
-        else
-        {
-            CPU_SET(id % SW_CPU_NUM, &cpu_set);
-        }
-        if (0 != pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set))
-        {
-            swWarn("pthread_setaffinity_np() failed");
-        }
-    }
-#endif
-
 }
 
 static void swFactoryThread_onStop(swThreadPool *pool, int id)
@@ -17,6 +17,18 @@
 #include "swoole.h"
 #include "buffer.h"
 
+static sw_inline void swBuffer_count(swBuffer *buffer, swBuffer_chunk *chunk, long sign)
+{
+    if (buffer->counter && chunk->type == SW_CHUNK_DATA)
+    {
+        sw_atomic_fetch_add(&buffer->counter->memory, sign * chunk->size);
+        if (buffer->counter->total)
+        {
+            sw_atomic_fetch_add(buffer->counter->total, sign * chunk->size);
+        }
+    }
+}
+
 /**
  * create new buffer
  */
@@ -68,6 +80,7 @@ swBuffer_chunk *swBuffer_new_chunk(swBuffer *buffer, uint32_t type, uint32_t siz
 
     chunk->type = type;
     buffer->chunk_num ++; //buffer 中的chunk 个数增加
+    swBuffer_count(buffer, chunk, 1);
 
     //把 新申请的chunk 挂载到buffer 链表中
     if (buffer->head == NULL)
@@ -101,6 +114,7 @@ void swBuffer_pop_chunk(swBuffer *buffer, swBuffer_chunk *chunk)
         buffer->length -= chunk->length;
         buffer->chunk_num--;
     }
+    swBuffer_count(buffer, chunk, -1);
     if (chunk->type == SW_CHUNK_DATA)
     {
         sw_free(chunk->store.ptr);
@@ -112,6 +126,63 @@ void swBuffer_pop_chunk(swBuffer *buffer, swBuffer_chunk *chunk)
     sw_free(chunk);
 }
 
+/**
+ * move the head chunk to the tail of another buffer, the memory is not released
+ */
+void swBuffer_move_chunk(swBuffer *from, swBuffer *to)
+{
+    swBuffer_chunk *chunk = from->head;
+    if (chunk->next == NULL)
+    {
+        from->head = NULL;
+        from->tail = NULL;
+        from->length = 0;
+        from->chunk_num = 0;
+    }
+    else
+    {
+        from->head = chunk->next;
+        from->length -= chunk->length;
+        from->chunk_num--;
+    }
+
+    chunk->next = NULL;
+    if (to->head == NULL)
+    {
+        to->tail = to->head = chunk;
+    }
+    else
+    {
+        to->tail->next = chunk;
+        to->tail = chunk;
+    }
+    to->length += chunk->length;
+    to->chunk_num++;
+
+    if (from->counter != to->counter)
+    {
+        swBuffer_count(from, chunk, -1);
+        swBuffer_count(to, chunk, 1);
+    }
+}
+
+/**
+ * the memory of the chunks is moved to another counter
+ */
+void swBuffer_set_counter(swBuffer *buffer, swBuffer_counter *counter)
+{
+    swBuffer_chunk *chunk;
+    for (chunk = buffer->head; chunk != NULL; chunk = chunk->next)
+    {
+        swBuffer_count(buffer, chunk, -1);
+    }
+    buffer->counter = counter;
+    for (chunk = buffer->head; chunk != NULL; chunk = chunk->next)
+    {
+        swBuffer_count(buffer, chunk, 1);
+    }
+}
+
 /**
  * free buffer
  */
@@ -121,6 +192,7 @@ int swBuffer_free(swBuffer *buffer)
     void * *will_free_chunk;  //free the point
     while (chunk != NULL)
     {
+        swBuffer_count(buffer, (swBuffer_chunk *) chunk, -1);
         if (chunk->type == SW_CHUNK_DATA)
         {
             sw_free(chunk->store.ptr);
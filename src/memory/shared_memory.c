@@ -16,6 +16,13 @@
 
 #include "swoole.h"
 #include <sys/shm.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#ifndef MPOL_PREFERRED
+#define MPOL_PREFERRED     1
+#endif
 
 //申请共享内存
 void* sw_shm_malloc(size_t size)
@@ -63,6 +70,25 @@ int sw_shm_protect(void *addr, int flags)
     return mprotect(object, object->size, flags);//object->size 就是这块内存的大小。
 }
 
+/**
+ * the pages which are not touched yet are allocated on the NUMA node, the fallback is the other nodes
+ */
+int sw_shm_bind(void *addr, int node)
+{
+#if defined(__linux__) && defined(SYS_mbind)
+    swShareMemory *object = (swShareMemory *) (addr - sizeof(swShareMemory));
+    unsigned long nodemask[4] = {0};
+    if (node < 0 || node >= sizeof(nodemask) * 8)
+    {
+        return SW_ERR;
+    }
+    nodemask[node / (sizeof(long) * 8)] = 1UL << (node % (sizeof(long) * 8));
+    return syscall(SYS_mbind, object, object->size, MPOL_PREFERRED, nodemask, sizeof(nodemask) * 8, 0);
+#else
+    return SW_ERR;
+#endif
+}
+
 //释放内存
 void sw_shm_free(void *ptr)
 {
@@ -0,0 +1,166 @@
+/*
+ +----------------------------------------------------------------------+
+ | Swoole                                                               |
+ +----------------------------------------------------------------------+
+ | This source file is subject to version 2.0 of the Apache license,    |
+ | that is bundled with this package in the file LICENSE, and is        |
+ | available through the world-wide-web at the following url:           |
+ | http://www.apache.org/licenses/LICENSE-2.0.html                      |
+ | If you did not receive a copy of the Apache2.0 license and are unable|
+ | to obtain it through the world-wide-web, please send a note to       |
+ | license@swoole.com so we can mail you a copy immediately.            |
+ +----------------------------------------------------------------------+
+ | Author: Tianfeng Han  <mikan.tenny@gmail.com>                        |
+ +----------------------------------------------------------------------+
+ */
+
+#include "swoole.h"
+
+/**
+ * the memory is split into pages, an allocation takes a run of contiguous pages.
+ * only one thread may alloc, the pages are released with atomic operations on the bitmap,
+ * so any process can free them without a lock.
+ */
+typedef struct
+{
+    uint32_t page_size;
+    uint32_t page_num;
+    /**
+     * next fit, where the last allocation ended
+     */
+    uint32_t cursor;
+    sw_atomic_t used_num;
+    char *memory;
+    volatile uint64_t bitmap[0];
+} swSlabPool;
+
+typedef struct
+{
+    uint32_t page;
+    uint32_t page_num;
+} swSlabPool_item;
+
+static void* swSlabPool_alloc(swMemoryPool *pool, uint32_t size);
+static void swSlabPool_free(swMemoryPool *pool, void *ptr);
+static void swSlabPool_destroy(swMemoryPool *pool);
+
+swMemoryPool* swSlabPool_new(uint32_t size, uint32_t page_size)
+{
+    uint32_t page_num = size / page_size;
+    if (page_num == 0)
+    {
+        page_num = 1;
+    }
+    size_t bitmap_size = ((page_num + 63) / 64) * sizeof(uint64_t);
+    size_t header_size = sizeof(swMemoryPool) + sizeof(swSlabPool) + bitmap_size;
+    header_size = (header_size + SW_CACHELINE_SIZE - 1) & ~(SW_CACHELINE_SIZE - 1);
+
+    void *mem = sw_shm_malloc(header_size + (size_t) page_num * page_size);
+    if (mem == NULL)
+    {
+        swWarn("sw_shm_malloc(%ld) failed.", header_size + (size_t) page_num * page_size);
+        return NULL;
+    }
+
+    swMemoryPool *pool = mem;
+    swSlabPool *object = mem + sizeof(swMemoryPool);
+    bzero(object, sizeof(swSlabPool) + bitmap_size);
+
+    object->page_size = page_size;
+    object->page_num = page_num;
+    object->memory = mem + header_size;
+
+    pool->object = object;
+    pool->alloc = swSlabPool_alloc;
+    pool->free = swSlabPool_free;
+    pool->destroy = swSlabPool_destroy;
+
+    return pool;
+}
+
+static sw_inline int swSlabPool_is_used(swSlabPool *object, uint32_t page)
+{
+    return (object->bitmap[page >> 6] >> (page & 63)) & 1;
+}
+
+/**
+ * set or clear the bits of [page, page + n)
+ */
+static void swSlabPool_mark(swSlabPool *object, uint32_t page, uint32_t n, int used)
+{
+    while (n > 0)
+    {
+        uint32_t bit = page & 63;
+        uint32_t count = 64 - bit < n ? 64 - bit : n;
+        uint64_t mask = (count == 64 ? ~0ULL : ((1ULL << count) - 1)) << bit;
+        if (used)
+        {
+            __sync_fetch_and_or(&object->bitmap[page >> 6], mask);
+        }
+        else
+        {
+            __sync_fetch_and_and(&object->bitmap[page >> 6], ~mask);
+        }
+        page += count;
+        n -= count;
+    }
+}
+
+static void* swSlabPool_alloc(swMemoryPool *pool, uint32_t size)
+{
+    swSlabPool *object = pool->object;
+    uint32_t n = (size + sizeof(swSlabPool_item) + object->page_size - 1) / object->page_size;
+    if (n > object->page_num || object->used_num + n > object->page_num)
+    {
+        return NULL;
+    }
+
+    uint32_t page = object->cursor, run = 0, i, p;
+    //every page is visited once, plus the run that crosses the cursor
+    for (i = 0; i <= object->page_num + n; i++)
+    {
+        p = page + run;
+        //a run never wraps
+        if (p >= object->page_num)
+        {
+            page = 0;
+            run = 0;
+            continue;
+        }
+        if (swSlabPool_is_used(object, p))
+        {
+            page = p + 1;
+            run = 0;
+            continue;
+        }
+        if (++run == n)
+        {
+            swSlabPool_mark(object, page, n, 1);
+            sw_atomic_fetch_add(&object->used_num, n);
+            object->cursor = page + n < object->page_num ? page + n : 0;
+
+            swSlabPool_item *item = (swSlabPool_item *) (object->memory + (size_t) page * object->page_size);
+            item->page = page;
+            item->page_num = n;
+            return item + 1;
+        }
+    }
+    return NULL;
+}
+
+static void swSlabPool_free(swMemoryPool *pool, void *ptr)
+{
+    swSlabPool *object = pool->object;
+    swSlabPool_item *item = (swSlabPool_item *) ptr - 1;
+
+    assert((char *) item >= object->memory && (char *) item < object->memory + (size_t) object->page_num * object->page_size);
+
+    uint32_t page = item->page, n = item->page_num;
+    sw_atomic_fetch_sub(&object->used_num, n);
+    swSlabPool_mark(object, page, n, 0);
+}
+
+static void swSlabPool_destroy(swMemoryPool *pool)
+{
+    sw_shm_free(pool);
+}
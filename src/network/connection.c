@@ -20,6 +20,10 @@
 #include "server.h"
 
 #include <sys/stat.h>
+#include <sys/uio.h>
+#ifdef __linux__
+#include <linux/errqueue.h>
+#endif
 
 #ifndef MSG_NOSIGNAL
 #define MSG_NOSIGNAL        0
@@ -137,6 +141,19 @@ int swConnection_buffer_send(swConnection *conn)
         return SW_OK;
     }
 
+    /**
+     * more than one data chunk, flush them with one syscall,
+     * the pipes are SOCK_DGRAM, every chunk must be a datagram of its own
+     */
+    if (chunk->next && chunk->next->type == SW_CHUNK_DATA && swConnection_is_stream(conn)
+#ifdef SW_USE_OPENSSL
+            && !conn->ssl
+#endif
+            )
+    {
+        return swConnection_buffer_writev(conn);
+    }
+
     ret = swConnection_send(conn, chunk->store.ptr + chunk->offset, sendn, 0);
     if (ret < 0)
     {
@@ -169,6 +186,223 @@ int swConnection_buffer_send(swConnection *conn)
     return SW_OK;
 }
 
+/**
+ * send the data chunks at the head of the buffer with one sendmsg, at most SW_IOV_MAX chunks,
+ * only for the stream sockets
+ */
+int swConnection_buffer_writev(swConnection *conn)
+{
+    struct iovec iov[SW_IOV_MAX];
+    struct msghdr msg;
+    int iovcnt = 0;
+    ssize_t ret;
+
+    swBuffer *buffer = conn->out_buffer;
+    swBuffer_chunk *chunk;
+
+    for (chunk = swBuffer_get_chunk(buffer); chunk && chunk->type == SW_CHUNK_DATA && iovcnt < SW_IOV_MAX; chunk = chunk->next)
+    {
+        if (chunk->length == chunk->offset)
+        {
+            continue;
+        }
+        iov[iovcnt].iov_base = chunk->store.ptr + chunk->offset;
+        iov[iovcnt].iov_len = chunk->length - chunk->offset;
+        iovcnt++;
+    }
+
+    bzero(&msg, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iovcnt;
+
+    do
+    {
+        ret = sendmsg(conn->fd, &msg, MSG_NOSIGNAL);
+    } while (ret < 0 && errno == EINTR);
+
+    if (ret < 0)
+    {
+        switch (swConnection_error(errno))
+        {
+        case SW_ERROR:
+            swWarn("sendmsg to fd[%d] failed. Error: %s[%d]", conn->fd, strerror(errno), errno);
+            break;
+        case SW_CLOSE:
+            conn->close_errno = errno;
+            conn->close_wait = 1;
+            return SW_ERR;
+        case SW_WAIT:
+            conn->send_wait = 1;
+            return SW_ERR;
+        default:
+            break;
+        }
+        return SW_OK;
+    }
+#ifdef SW_DEBUG
+    conn->total_send_bytes += ret;
+#endif
+
+    //pop the chunks which are fully sent, the last one may be partially sent
+    while (!swBuffer_empty(buffer))
+    {
+        chunk = swBuffer_get_chunk(buffer);
+        if (chunk->type != SW_CHUNK_DATA)
+        {
+            break;
+        }
+        uint32_t n = chunk->length - chunk->offset;
+        if (ret < n)
+        {
+            chunk->offset += ret;
+            break;
+        }
+        ret -= n;
+        swBuffer_pop_chunk(buffer, chunk);
+    }
+    return SW_OK;
+}
+
+/**
+ * send the head chunk with MSG_ZEROCOPY, the memory is moved to conn->zerocopy_buffer
+ * when the chunk is fully sent, and released by swConnection_zerocopy_reap()
+ */
+int swConnection_buffer_send_zerocopy(swConnection *conn)
+{
+#ifdef MSG_ZEROCOPY
+    swBuffer *buffer = conn->out_buffer;
+    swBuffer_chunk *chunk = swBuffer_get_chunk(buffer);
+    uint32_t sendn = chunk->length - chunk->offset;
+    ssize_t ret;
+
+    if (conn->zerocopy_buffer == NULL)
+    {
+        conn->zerocopy_buffer = swBuffer_new(0);
+        if (conn->zerocopy_buffer == NULL)
+        {
+            return SW_ERR;
+        }
+        conn->zerocopy_buffer->counter = buffer->counter;
+    }
+
+    //the kernel copied the data last time, MSG_ZEROCOPY only adds the notifications
+    int flags = conn->zerocopy_copied ? 0 : MSG_ZEROCOPY;
+
+    _send:
+    ret = send(conn->fd, chunk->store.ptr + chunk->offset, sendn, flags);
+    if (ret < 0)
+    {
+        if (errno == EINTR)
+        {
+            goto _send;
+        }
+        //out of the locked memory for the pinned pages, copy it
+        else if (errno == ENOBUFS && flags)
+        {
+            flags = 0;
+            goto _send;
+        }
+        switch (swConnection_error(errno))
+        {
+        case SW_ERROR:
+            swWarn("send to fd[%d] failed. Error: %s[%d]", conn->fd, strerror(errno), errno);
+            break;
+        case SW_CLOSE:
+            conn->close_errno = errno;
+            conn->close_wait = 1;
+            return SW_ERR;
+        case SW_WAIT:
+            conn->send_wait = 1;
+            return SW_ERR;
+        default:
+            break;
+        }
+        return SW_OK;
+    }
+#ifdef SW_DEBUG
+    conn->total_send_bytes += ret;
+#endif
+    //every successful send with MSG_ZEROCOPY has a sequence number
+    if (flags)
+    {
+        conn->zerocopy_seq++;
+    }
+    if (ret == sendn)
+    {
+        //nothing in flight
+        if ((int32_t) (conn->zerocopy_done - conn->zerocopy_seq) >= 0)
+        {
+            swBuffer_pop_chunk(buffer, chunk);
+            return SW_OK;
+        }
+        chunk->seq = conn->zerocopy_seq;
+        swBuffer_move_chunk(buffer, conn->zerocopy_buffer);
+    }
+    else
+    {
+        chunk->offset += ret;
+    }
+    return SW_OK;
+#else
+    return swConnection_buffer_send(conn);
+#endif
+}
+
+/**
+ * read the completions from the error queue and release the chunks, returns the number of notifications
+ */
+int swConnection_zerocopy_reap(swConnection *conn)
+{
+    int n = 0;
+#if defined(MSG_ZEROCOPY) && defined(SO_EE_ORIGIN_ZEROCOPY)
+    char control[128];
+    struct msghdr msg;
+    struct cmsghdr *cmsg;
+    struct sock_extended_err *serr;
+
+    while (1)
+    {
+        bzero(&msg, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if (recvmsg(conn->fd, &msg, MSG_ERRQUEUE) < 0)
+        {
+            break;
+        }
+        for (cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+        {
+            if (!((cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR)
+                    || (cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR)))
+            {
+                continue;
+            }
+            serr = (struct sock_extended_err *) CMSG_DATA(cmsg);
+            if (serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY || serr->ee_errno != 0)
+            {
+                continue;
+            }
+            //[ee_info, ee_data] are completed, TCP completes them in order
+            if ((int32_t) (serr->ee_data + 1 - conn->zerocopy_done) > 0)
+            {
+                conn->zerocopy_done = serr->ee_data + 1;
+            }
+            if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+            {
+                conn->zerocopy_copied = 1;
+            }
+            n++;
+        }
+    }
+#endif
+
+    swBuffer *buffer = conn->zerocopy_buffer;
+    while (!swBuffer_empty(buffer) && (int32_t) (conn->zerocopy_done - swBuffer_get_chunk(buffer)->seq) >= 0)
+    {
+        swBuffer_pop_chunk(buffer, swBuffer_get_chunk(buffer));
+    }
+    return n;
+}
+
 swString* swConnection_get_string_buffer(swConnection *conn)
 {
     swString *buffer = conn->object;
@@ -18,6 +18,7 @@
 #include "server.h"
 
 #include <sys/wait.h>
+#include <sys/ioctl.h>
 
 typedef struct
 {
@@ -26,6 +27,17 @@ typedef struct
     uint8_t reload_task_worker;
     uint8_t read_message;
     uint8_t alarm;
+    /**
+     * the period of alarm(), a divisor of both manager_alarm and SW_AUTOSCALE_INTERVAL,
+     * alarm_time counts the seconds to decide which of them is due
+     */
+    uint32_t alarm_interval;
+    uint32_t alarm_time;
+    /**
+     * min_worker_num and task_min_worker_num
+     */
+    swAutoscale event_autoscale;
+    swAutoscale task_autoscale;
 
 } swManagerProcess;
 
@@ -33,6 +45,8 @@ static int swManager_loop(swFactory *factory);
 static void swManager_signal_handle(int sig);
 static pid_t swManager_spawn_worker(swFactory *factory, int worker_id);
 static void swManager_check_exit_status(swServer *serv, int worker_id, pid_t pid, int status);
+static int swManager_autoscale_init(swAutoscale *as, uint16_t min_num, uint16_t max_num);
+static void swManager_autoscale(swFactory *factory, swProcessPool *pool, swAutoscale *as);
 
 static swManagerProcess ManagerProcess;
 
@@ -44,6 +58,9 @@ int swManager_start(swFactory *factory)
     pid_t pid;
     swServer *serv = factory->ptr;
 
+    //the manager stops and starts the workers above it
+    serv->gs->event_workers.run_worker_num = serv->worker_num;
+
     object->pipes = sw_calloc(serv->worker_num, sizeof(swPipe));
     if (object->pipes == NULL)
     {
@@ -229,6 +246,29 @@ static int swManager_loop(swFactory *factory)
         serv->onManagerStart(serv);
     }
 
+    if (serv->min_worker_num > 0 && swManager_autoscale_init(&ManagerProcess.event_autoscale, serv->min_worker_num, serv->worker_num) < 0)
+    {
+        return SW_ERR;
+    }
+    if (serv->task_min_worker_num > 0 && swManager_autoscale_init(&ManagerProcess.task_autoscale, serv->task_min_worker_num, serv->task_worker_num) < 0)
+    {
+        return SW_ERR;
+    }
+    //the autoscaling shares the alarm, manager_alarm keeps its own period
+    ManagerProcess.alarm_interval = serv->manager_alarm;
+    ManagerProcess.alarm_time = 0;
+    if (serv->min_worker_num > 0 || serv->task_min_worker_num > 0)
+    {
+        uint32_t a = SW_AUTOSCALE_INTERVAL, b = ManagerProcess.alarm_interval, t;
+        while (b > 0)
+        {
+            t = a % b;
+            a = b;
+            b = t;
+        }
+        ManagerProcess.alarm_interval = a;
+    }
+
     reload_worker_num = serv->worker_num + serv->task_worker_num;
     reload_workers = sw_calloc(reload_worker_num, sizeof(swWorker));
     if (reload_workers == NULL)
@@ -248,9 +288,9 @@ static int swManager_loop(swFactory *factory)
 #endif
     //swSignal_add(SIGINT, swManager_signal_handle);
 
-    if (serv->manager_alarm > 0)
+    if (ManagerProcess.alarm_interval > 0)
     {
-        alarm(serv->manager_alarm);
+        alarm(ManagerProcess.alarm_interval);
         swSignal_add(SIGALRM, swManager_signal_handle);
     }
 
@@ -265,7 +305,8 @@ static int swManager_loop(swFactory *factory)
             swWorkerStopMessage msg;
             while (swChannel_pop(serv->message_box, &msg, sizeof(msg)) > 0)
             {
-                if (SwooleG.running == 0)
+                //stopped by the autoscaling
+                if (SwooleG.running == 0 || msg.worker_id >= serv->gs->event_workers.run_worker_num)
                 {
                     continue;
                 }
@@ -283,12 +324,25 @@ static int swManager_loop(swFactory *factory)
             if (ManagerProcess.alarm == 1)
             {
                 ManagerProcess.alarm = 0;
-                alarm(serv->manager_alarm);
+                ManagerProcess.alarm_time += ManagerProcess.alarm_interval;
+                alarm(ManagerProcess.alarm_interval);
 
-                if (serv->hooks[SW_SERVER_HOOK_MANAGER_TIMER])
+                if (serv->manager_alarm > 0 && ManagerProcess.alarm_time % serv->manager_alarm == 0
+                        && serv->hooks[SW_SERVER_HOOK_MANAGER_TIMER])
                 {
                     swServer_call_hook(serv, SW_SERVER_HOOK_MANAGER_TIMER, serv);
                 }
+                if (ManagerProcess.alarm_time % SW_AUTOSCALE_INTERVAL == 0 && ManagerProcess.reloading == 0)
+                {
+                    if (serv->min_worker_num > 0)
+                    {
+                        swManager_autoscale(factory, &serv->gs->event_workers, &ManagerProcess.event_autoscale);
+                    }
+                    if (serv->task_min_worker_num > 0)
+                    {
+                        swManager_autoscale(factory, &serv->gs->task_workers, &ManagerProcess.task_autoscale);
+                    }
+                }
             }
 
             if (ManagerProcess.reloading == 0)
@@ -321,7 +375,7 @@ static int swManager_loop(swFactory *factory)
                     {
                         for (i = 0; i < serv->worker_num; i++)
                         {
-                            if (kill(reload_workers[i].pid, SIGTERM) < 0)
+                            if (reload_workers[i].pid > 0 && kill(reload_workers[i].pid, SIGTERM) < 0)
                             {
                                 swSysError("kill(%d, SIGTERM) [%d] failed.", reload_workers[i].pid, i);
                             }
@@ -380,6 +434,13 @@ static int swManager_loop(swFactory *factory)
                 //Check the process return code and signal
                 swManager_check_exit_status(serv, i, pid, status);
 
+                //stopped by the autoscaling
+                if (i >= serv->gs->event_workers.run_worker_num)
+                {
+                    serv->workers[i].pid = 0;
+                    break;
+                }
+
                 while (1)
                 {
                     new_pid = swManager_spawn_worker(factory, i);
@@ -410,7 +471,16 @@ static int swManager_loop(swFactory *factory)
                         goto _wait;
                     }
                     swManager_check_exit_status(serv, exit_worker->id, pid, status);
-                    swProcessPool_spawn(&serv->gs->task_workers, exit_worker);
+                    //stopped by the autoscaling
+                    if (exit_worker->id - serv->gs->task_workers.start_id >= serv->gs->task_workers.run_worker_num)
+                    {
+                        swHashMap_del_int(serv->gs->task_workers.map, pid);
+                        exit_worker->pid = 0;
+                    }
+                    else
+                    {
+                        swProcessPool_spawn(&serv->gs->task_workers, exit_worker);
+                    }
                 }
             }
             //user process
@@ -433,6 +503,12 @@ static int swManager_loop(swFactory *factory)
                 continue;
             }
             reload_worker_pid = reload_workers[reload_worker_i].pid;
+            //stopped by the autoscaling
+            if (reload_worker_pid == 0)
+            {
+                reload_worker_i++;
+                goto kill_worker;
+            }
             if (kill(reload_worker_pid, SIGTERM) < 0)
             {
                 if (errno == ECHILD)
@@ -446,12 +522,17 @@ static int swManager_loop(swFactory *factory)
     }
 
     sw_free(reload_workers);
+    sw_free(ManagerProcess.event_autoscale.stopped);
+    sw_free(ManagerProcess.task_autoscale.stopped);
     swSignal_none();
     //kill all child process
     for (i = 0; i < serv->worker_num; i++)
     {
         swTrace("[Manager]kill worker processor");
-        kill(serv->workers[i].pid, SIGTERM);
+        if (serv->workers[i].pid > 0)
+        {
+            kill(serv->workers[i].pid, SIGTERM);
+        }
     }
     //kill and wait task process
     if (serv->task_worker_num > 0)
@@ -461,7 +542,7 @@ static int swManager_loop(swFactory *factory)
     //wait child process
     for (i = 0; i < serv->worker_num; i++)
     {
-        if (swWaitpid(serv->workers[i].pid, &status, 0) < 0)
+        if (serv->workers[i].pid > 0 && swWaitpid(serv->workers[i].pid, &status, 0) < 0)
         {
             swSysError("waitpid(%d) failed.", serv->workers[i].pid);
         }
@@ -480,6 +561,166 @@ static int swManager_loop(swFactory *factory)
     return SW_OK;
 }
 
+static int swManager_autoscale_init(swAutoscale *as, uint16_t min_num, uint16_t max_num)
+{
+    as->min_num = min_num;
+    as->max_num = max_num;
+    as->stopped = sw_calloc(max_num, sizeof(pid_t));
+    if (as->stopped == NULL)
+    {
+        swError("malloc[autoscale] failed");
+        return SW_ERR;
+    }
+    return SW_OK;
+}
+
+/**
+ * grow fast and shrink slowly, the workers are added or removed after some samples in a row
+ */
+int swAutoscale_target(swAutoscale *as, swAutoscaleSample *sample)
+{
+    uint32_t run_num = sample->run_num;
+    uint64_t delay = run_num > 0 ? (uint64_t) sample->queue_num * sample->process_usec / run_num : 0;
+
+    if ((sample->queue_num > 0 && sample->idle_num * 100 < run_num * SW_AUTOSCALE_IDLE_LOW) || delay >= SW_AUTOSCALE_DELAY_HIGH)
+    {
+        as->idle_ticks = 0;
+        if (as->busy_ticks < SW_AUTOSCALE_UP_TICKS)
+        {
+            as->busy_ticks++;
+        }
+    }
+    else if (sample->queue_num == 0 && sample->idle_num * 100 >= run_num * SW_AUTOSCALE_IDLE_HIGH)
+    {
+        as->busy_ticks = 0;
+        if (as->idle_ticks < SW_AUTOSCALE_DOWN_TICKS)
+        {
+            as->idle_ticks++;
+        }
+    }
+    else
+    {
+        as->busy_ticks = as->idle_ticks = 0;
+    }
+
+    if (as->busy_ticks >= SW_AUTOSCALE_UP_TICKS && run_num < as->max_num)
+    {
+        as->busy_ticks = 0;
+        run_num += run_num / 2 > 0 ? run_num / 2 : 1;
+        return run_num > as->max_num ? as->max_num : run_num;
+    }
+    if (as->idle_ticks >= SW_AUTOSCALE_DOWN_TICKS && run_num > as->min_num)
+    {
+        as->idle_ticks = 0;
+        return run_num - 1;
+    }
+    return run_num;
+}
+
+/**
+ * nothing is waiting for the worker in its pipe
+ */
+static int swManager_worker_drained(swWorker *worker)
+{
+    int n = 0;
+    if (worker->status != SW_WORKER_IDLE || (int32_t) (worker->dispatch_count - worker->finish_count) > 0)
+    {
+        return SW_FALSE;
+    }
+    if (worker->pipe_worker > 0 && ioctl(worker->pipe_worker, FIONREAD, &n) == 0 && n > 0)
+    {
+        return SW_FALSE;
+    }
+    return SW_TRUE;
+}
+
+static void swManager_autoscale(swFactory *factory, swProcessPool *pool, swAutoscale *as)
+{
+    swServer *serv = factory->ptr;
+    swAutoscaleSample sample;
+    swWorker *worker;
+    uint32_t i, target, in_flight = 0;
+    uint64_t process_usec = 0;
+
+    //removed from the schedule in the previous samples, the messages sent before are handled first
+    for (i = pool->run_worker_num; i < as->max_num; i++)
+    {
+        worker = &pool->workers[i];
+        if (worker->pid > 0 && as->stopped[i] != worker->pid && swManager_worker_drained(worker))
+        {
+            if (kill(worker->pid, SIGTERM) < 0)
+            {
+                swSysError("kill(%d, SIGTERM) failed.", worker->pid);
+                continue;
+            }
+            as->stopped[i] = worker->pid;
+        }
+    }
+
+    bzero(&sample, sizeof(sample));
+    sample.run_num = pool->run_worker_num;
+    for (i = 0; i < sample.run_num; i++)
+    {
+        worker = &pool->workers[i];
+        if (worker->status == SW_WORKER_IDLE)
+        {
+            sample.idle_num++;
+        }
+        int32_t n = (int32_t) (worker->dispatch_count - worker->finish_count);
+        in_flight += n > 0 ? n : 0;
+        process_usec += worker->process_usec;
+    }
+    if (pool == &serv->gs->task_workers)
+    {
+        int tasking_num = serv->stats->tasking_num;
+        sample.queue_num = tasking_num > 0 ? tasking_num : 0;
+    }
+    else
+    {
+        //the busy workers are handling one of them
+        uint32_t busy_num = sample.run_num - sample.idle_num;
+        sample.queue_num = in_flight > busy_num ? in_flight - busy_num : 0;
+        sample.process_usec = process_usec / sample.run_num;
+    }
+
+    target = swAutoscale_target(as, &sample);
+    if (target > sample.run_num)
+    {
+        for (i = sample.run_num; i < target; i++)
+        {
+            worker = &pool->workers[i];
+            //it is exiting, and started again when it exits
+            if (worker->pid > 0)
+            {
+                continue;
+            }
+            if (pool == &serv->gs->task_workers)
+            {
+                if (swProcessPool_spawn(pool, worker) < 0)
+                {
+                    break;
+                }
+            }
+            else
+            {
+                pid_t pid = swManager_spawn_worker(factory, i);
+                if (pid < 0)
+                {
+                    break;
+                }
+                worker->pid = pid;
+            }
+        }
+        target = i;
+    }
+    if (target != sample.run_num)
+    {
+        swNotice("[Manager] %s: %d -> %d, idle=%d, queue=%d.", pool == &serv->gs->task_workers ? "task workers" : "workers",
+                sample.run_num, target, sample.idle_num, sample.queue_num);
+        pool->run_worker_num = target;
+    }
+}
+
 static pid_t swManager_spawn_worker(swFactory *factory, int worker_id)
 {
     pid_t pid;
@@ -37,6 +37,7 @@ void swPort_init(swListenPort *port)
 
     //listen backlog
     port->backlog = SW_BACKLOG;
+    port->accept_batch = SW_ACCEPT_MAX_COUNT;
     //tcp keepalive
     port->tcp_keepcount = SW_TCP_KEEPCOUNT;
     port->tcp_keepinterval = SW_TCP_KEEPINTERVAL;
@@ -224,6 +225,20 @@ static int swPort_onRead_raw(swReactor *reactor, swListenPort *port, swEvent *ev
     swDispatchData task;
     swConnection *conn =  event->socket;
 
+#ifdef HAVE_IO_URING
+    /**
+     * dispatch the data in the registered buffer directly
+     */
+    if (conn->completion && conn->completion_length > 0)
+    {
+        int ret;
+        n = conn->completion_length > SW_BUFFER_SIZE ? SW_BUFFER_SIZE : conn->completion_length;
+        ret = swReactorThread_dispatch(conn, conn->completion_data, n);
+        swConnection_completion_consume(conn, n);
+        return ret;
+    }
+#endif
+
     n = swConnection_recv(conn, task.data.data, SW_BUFFER_SIZE, 0);
     if (n < 0)
     {
@@ -574,6 +589,17 @@ void swPort_free(swListenPort *port)
 #endif
 
     close(port->sock);
+    if (port->reactor_socks)
+    {
+        int i;
+        //reactor_socks[0] is the socket of the port
+        for (i = 1; i < SwooleG.serv->reactor_num; i++)
+        {
+            close(port->reactor_socks[i]);
+        }
+        sw_free(port->reactor_socks);
+        port->reactor_socks = NULL;
+    }
 
     //remove unix socket file
     if (port->type == SW_SOCK_UNIX_STREAM || port->type == SW_SOCK_UNIX_DGRAM)
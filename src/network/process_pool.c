@@ -251,6 +251,11 @@ int swProcessPool_dispatch(swProcessPool *pool, swEventData *data, int *dst_work
     {
         *dst_worker_id = swProcessPool_schedule(pool);
     }
+    //stopped by the autoscaling
+    else if (*dst_worker_id >= pool->run_worker_num)
+    {
+        *dst_worker_id %= pool->run_worker_num;
+    }
 
     *dst_worker_id += pool->start_id;
     worker = swProcessPool_get_worker(pool, *dst_worker_id);
@@ -301,6 +306,11 @@ int swProcessPool_dispatch_blocking(swProcessPool *pool, swEventData *data, int
     {
         *dst_worker_id = swProcessPool_schedule(pool);
     }
+    //stopped by the autoscaling
+    else if (*dst_worker_id >= pool->run_worker_num)
+    {
+        *dst_worker_id %= pool->run_worker_num;
+    }
 
     *dst_worker_id += pool->start_id;
     swWorker *worker = swProcessPool_get_worker(pool, *dst_worker_id);
@@ -325,20 +335,24 @@ void swProcessPool_shutdown(swProcessPool *pool)
     SwooleG.running = 0;
 
 	swSignal_none();
-    //concurrent kill
-    for (i = 0; i < pool->run_worker_num; i++)
+    //concurrent kill, the workers stopped by the autoscaling are skipped
+    for (i = 0; i < pool->worker_num; i++)
     {
         worker = &pool->workers[i];
+        if (worker->pid == 0)
+        {
+            continue;
+        }
         if (swKill(worker->pid, SIGTERM) < 0)
         {
             swSysError("kill(%d) failed.", worker->pid);
             continue;
         }
     }
-    for (i = 0; i < pool->run_worker_num; i++)
+    for (i = 0; i < pool->worker_num; i++)
     {
         worker = &pool->workers[i];
-        if (swWaitpid(worker->pid, &status, 0) < 0)
+        if (worker->pid > 0 && swWaitpid(worker->pid, &status, 0) < 0)
         {
             swSysError("waitpid(%d) failed.", worker->pid);
         }
@@ -433,15 +447,6 @@ static int swProcessPool_worker_loop(swProcessPool *pool, swWorker *worker)
      */
     out.buf.info.from_fd = worker->id;
 
-    if (pool->dispatch_mode == SW_DISPATCH_QUEUE)
-    {
-        out.mtype = 0;
-    }
-    else
-    {
-        out.mtype = worker->id + 1;
-    }
-
     while (SwooleG.running > 0 && task_n > 0)
     {
         /**
@@ -449,6 +454,19 @@ static int swProcessPool_worker_loop(swProcessPool *pool, swWorker *worker)
          */
         if (pool->use_msgqueue)
         {
+            //msgrcv() overwrites it with the type of the message
+            if (pool->dispatch_mode != SW_DISPATCH_QUEUE)
+            {
+                out.mtype = worker->id + 1;
+            }
+            else if (pool->type == SW_PROCESS_TASKWORKER)
+            {
+                out.mtype = -LONG_MAX;
+            }
+            else
+            {
+                out.mtype = 0;
+            }
             n = swMsgQueue_pop(pool->queue, (swQueue_data *) &out, sizeof(out.buf));
             if (n < 0 && errno != EINTR)
             {
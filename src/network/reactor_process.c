@@ -201,7 +201,7 @@ static int swReactorProcess_onPipeRead(swReactor *reactor, swEvent *event)
         serv->onPipeMessage(serv, &task);
         break;
     case SW_EVENT_FINISH:
-        serv->onFinish(serv, &task);
+        swTaskWorker_finish_dispatch(serv, &task);
         break;
     case SW_EVENT_SENDFILE:
         memcpy(&_send.info, &task.info, sizeof(_send.info));
@@ -276,6 +276,11 @@ static int swReactorProcess_loop(swProcessPool *pool, swWorker *worker)
     {
         return SW_ERR;
     }
+    reactor->busy_poll_usec = reactor->busy_poll_budget = serv->busy_poll_usec;
+    if (SwooleG.enable_latency_stats)
+    {
+        reactor->latency = swHistogram_new();
+    }
 
     swListenPort *ls;
     int fdtype;
@@ -425,6 +430,13 @@ static int swReactorProcess_loop(swProcessPool *pool, swWorker *worker)
         serv->onWorkerStop(serv, worker->id);
     }
 
+    //read by stats() until onWorkerStop
+    if (reactor->latency)
+    {
+        swHistogram_free(reactor->latency);
+        reactor->latency = NULL;
+    }
+
     return SW_OK;
 }
 
@@ -534,7 +546,9 @@ static void swReactorProcess_onTimeout(swTimer *timer, swTimer_node *tnode)
     swEvent notify_ev;
     swConnection *conn;
 
-    if (serv->gs->now < heartbeat_check_lasttime + 10)
+    time_t now = swReactor_now(reactor);
+
+    if (now < heartbeat_check_lasttime + 10)
     {
         return;
     }
@@ -550,7 +564,7 @@ static void swReactorProcess_onTimeout(swTimer *timer, swTimer_node *tnode)
     serv_max_fd = swServer_get_maxfd(serv);
     serv_min_fd = swServer_get_minfd(serv);
 
-    checktime = serv->gs->now - serv->heartbeat_idle_time;
+    checktime = now - serv->heartbeat_idle_time;
 
     for (fd = serv_min_fd; fd <= serv_max_fd; fd++)
     {
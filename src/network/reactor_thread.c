@@ -27,6 +27,12 @@ static int swReactorThread_onRead(swReactor *reactor, swEvent *ev);
 static int swReactorThread_onWrite(swReactor *reactor, swEvent *ev);
 static int swReactorThread_onPackage(swReactor *reactor, swEvent *event);
 static void swReactorThread_onStreamResponse(swStream *stream, char *data, uint32_t length);
+static void swReactorThread_onSteal(swReactor *reactor);
+static void swReactorThread_onFinish(swReactor *reactor);
+static void swReactorThread_resume_recv(swReactor *reactor);
+static int swReactorThread_onError(swReactor *reactor, swEvent *ev);
+static void swReactorThread_zerocopy_linger(swReactorThread *thread, swConnection *conn);
+static void swReactorThread_zerocopy_prune(swReactorThread *thread, time_t now);
 
 #if 0
 static int swReactorThread_dispatch_array_buffer(swReactorThread *thread, swConnection *conn);
@@ -149,6 +155,122 @@ static void swReactorThread_onStreamResponse(swStream *stream, char *data, uint3
     swReactorThread_send(&response);
 }
 
+static void swReactorThread_dgram_info(swDataHead *info, int fd, int socket_type)
+{
+    bzero(info, sizeof(*info));
+    info->from_fd = fd;
+    info->from_id = SwooleTG.id;
+#ifdef SW_BUFFER_RECV_TIME
+    info->time = swoole_microtime();
+#endif
+
+    switch(socket_type)
+    {
+    case SW_SOCK_UDP6:
+        info->type = SW_EVENT_UDP6;
+        break;
+    case SW_SOCK_UNIX_DGRAM:
+        info->type = SW_EVENT_UNIX_DGRAM;
+        break;
+    case SW_SOCK_UDP:
+    default:
+        info->type = SW_EVENT_UDP;
+        break;
+    }
+}
+
+/**
+ * [swDgramPacket][unix socket path] in front of the datagram, returns the size of the header
+ */
+static uint32_t swReactorThread_dgram_header(int socket_type, swSocketAddress *info, swDgramPacket *pkt, swEventData *data)
+{
+    //IPv4
+    if (socket_type == SW_SOCK_UDP)
+    {
+        pkt->port = ntohs(info->addr.inet_v4.sin_port);
+        pkt->addr.v4.s_addr = info->addr.inet_v4.sin_addr.s_addr;
+        data->info.fd = pkt->addr.v4.s_addr;
+    }
+    //IPv6
+    else if (socket_type == SW_SOCK_UDP6)
+    {
+        pkt->port = ntohs(info->addr.inet_v6.sin6_port);
+        memcpy(&pkt->addr.v6, &info->addr.inet_v6.sin6_addr, sizeof(info->addr.inet_v6.sin6_addr));
+        memcpy(&data->info.fd, &info->addr.inet_v6.sin6_addr, sizeof(data->info.fd));
+    }
+    //Unix Dgram
+    else
+    {
+        pkt->addr.un.path_length = strlen(info->addr.un.sun_path) + 1;
+        pkt->length += pkt->addr.un.path_length;
+        pkt->port = 0;
+        memcpy(&data->info.fd, info->addr.un.sun_path + pkt->addr.un.path_length - 6, sizeof(data->info.fd));
+    }
+
+    uint32_t header_size = sizeof(*pkt);
+
+    //dgram header
+    memcpy(data->data, pkt, sizeof(*pkt));
+    //unix dgram
+    if (socket_type == SW_SOCK_UNIX_DGRAM)
+    {
+        header_size += pkt->addr.un.path_length;
+        memcpy(data->data + sizeof(*pkt), info->addr.un.sun_path, pkt->addr.un.path_length);
+    }
+    return header_size;
+}
+
+/**
+ * the body follows the header, a datagram larger than one message is sent in parts to the same worker
+ */
+static int swReactorThread_dispatch_dgram(swFactory *factory, swDispatchData *task, uint32_t header_size, uint32_t length, char *packet)
+{
+    //dgram body
+    if (length > SW_BUFFER_SIZE - sizeof(swDgramPacket))
+    {
+        task->data.info.len = SW_BUFFER_SIZE;
+    }
+    else
+    {
+        task->data.info.len = length + sizeof(swDgramPacket);
+    }
+    //dispatch packet header
+    memcpy(task->data.data + header_size, packet, task->data.info.len - header_size);
+
+    uint32_t send_n = length + sizeof(swDgramPacket);
+    uint32_t offset = 0;
+
+    /**
+     * lock target
+     */
+    SwooleTG.factory_lock_target = 1;
+
+    int ret = factory->dispatch(factory, task);
+    if (ret == SW_OK)
+    {
+        send_n -= task->data.info.len;
+        offset = SW_BUFFER_SIZE - header_size;
+        while (send_n > 0)
+        {
+            task->data.info.len = send_n > SW_BUFFER_SIZE ? SW_BUFFER_SIZE : send_n;
+            memcpy(task->data.data, packet + offset, task->data.info.len);
+            send_n -= task->data.info.len;
+            offset += task->data.info.len;
+
+            if (factory->dispatch(factory, task) < 0)
+            {
+                break;
+            }
+        }
+    }
+    /**
+     * unlock
+     */
+    SwooleTG.factory_target_worker = -1;
+    SwooleTG.factory_lock_target = 0;
+    return ret;
+}
+
 /**
  * for udp
  */
@@ -165,27 +287,8 @@ static int swReactorThread_onPackage(swReactor *reactor, swEvent *event)
     swFactory *factory = &serv->factory;
 
     info.len = sizeof(info.addr);
-    bzero(&task.data.info, sizeof(task.data.info));
-    task.data.info.from_fd = fd;
-    task.data.info.from_id = SwooleTG.id;
-#ifdef SW_BUFFER_RECV_TIME
-    task.data.info.time = swoole_microtime();
-#endif
-
     int socket_type = server_sock->socket_type;
-    switch(socket_type)
-    {
-    case SW_SOCK_UDP6:
-        task.data.info.type = SW_EVENT_UDP6;
-        break;
-    case SW_SOCK_UNIX_DGRAM:
-        task.data.info.type = SW_EVENT_UNIX_DGRAM;
-        break;
-    case SW_SOCK_UDP:
-    default:
-        task.data.info.type = SW_EVENT_UDP;
-        break;
-    }
+    swReactorThread_dgram_info(&task.data.info, fd, socket_type);
 
     char packet[SW_BUFFER_SIZE_UDP];
     do_recvfrom:
@@ -194,114 +297,172 @@ static int swReactorThread_onPackage(swReactor *reactor, swEvent *event)
     if (ret > 0)
     {
         pkt.length = ret;
-
-        //IPv4
-        if (socket_type == SW_SOCK_UDP)
+        task.target_worker_id = -1;
+        uint32_t header_size = swReactorThread_dgram_header(socket_type, &info, &pkt, &task.data);
+        if (swReactorThread_dispatch_dgram(factory, &task, header_size, pkt.length, packet) < 0)
         {
-            pkt.port = ntohs(info.addr.inet_v4.sin_port);
-            pkt.addr.v4.s_addr = info.addr.inet_v4.sin_addr.s_addr;
-            task.data.info.fd = pkt.addr.v4.s_addr;
+            return SW_ERR;
         }
-        //IPv6
-        else if (socket_type == SW_SOCK_UDP6)
+        goto do_recvfrom;
+    }
+    else
+    {
+        if (errno == EAGAIN)
         {
-            pkt.port = ntohs(info.addr.inet_v6.sin6_port);
-            memcpy(&pkt.addr.v6, &info.addr.inet_v6.sin6_addr, sizeof(info.addr.inet_v6.sin6_addr));
-            memcpy(&task.data.info.fd, &info.addr.inet_v6.sin6_addr, sizeof(task.data.info.fd));
+            return SW_OK;
         }
-        //Unix Dgram
         else
         {
-            pkt.addr.un.path_length = strlen(info.addr.un.sun_path) + 1;
-            pkt.length += pkt.addr.un.path_length;
-            pkt.port = 0;
-            memcpy(&task.data.info.fd, info.addr.un.sun_path + pkt.addr.un.path_length - 6, sizeof(task.data.info.fd));
+            swSysError("recvfrom(%d) failed.", fd);
         }
+    }
+    return ret;
+}
 
-        task.target_worker_id = -1;
-        uint32_t header_size = sizeof(pkt);
+#ifdef HAVE_RECVMMSG
+typedef struct _swDgramRecvBatch
+{
+    struct mmsghdr msgs[SW_UDP_BATCH_SIZE];
+    struct iovec iov[SW_UDP_BATCH_SIZE];
+    swSocketAddress addr[SW_UDP_BATCH_SIZE];
+    int target[SW_UDP_BATCH_SIZE];
+    swEventData records[SW_UDP_BATCH_SIZE];
+    swDispatchData task;
+    char packets[SW_UDP_BATCH_SIZE][SW_BUFFER_SIZE_UDP];
+} swDgramRecvBatch;
 
-        //dgram header
-        memcpy(task.data.data, &pkt, sizeof(pkt));
-        //unix dgram
-        if (socket_type == SW_SOCK_UNIX_DGRAM)
-        {
-            header_size += pkt.addr.un.path_length;
-            memcpy(task.data.data + sizeof(pkt), info.addr.un.sun_path, pkt.addr.un.path_length);
-        }
-        //dgram body
-        if (pkt.length > SW_BUFFER_SIZE - sizeof(pkt))
-        {
-            task.data.info.len = SW_BUFFER_SIZE;
-        }
-        else
-        {
-            task.data.info.len = pkt.length + sizeof(pkt);
-        }
-        //dispatch packet header
-        memcpy(task.data.data + header_size, packet, task.data.info.len - header_size);
+static swDgramRecvBatch* swReactorThread_dgram_batch(swReactorThread *thread)
+{
+    if (thread->dgram_batch)
+    {
+        return thread->dgram_batch;
+    }
+    swDgramRecvBatch *batch = sw_malloc(sizeof(swDgramRecvBatch));
+    if (batch == NULL)
+    {
+        swWarn("malloc(%ld) failed.", sizeof(swDgramRecvBatch));
+        return NULL;
+    }
+    int i;
+    for (i = 0; i < SW_UDP_BATCH_SIZE; i++)
+    {
+        batch->iov[i].iov_base = batch->packets[i];
+        batch->iov[i].iov_len = SW_BUFFER_SIZE_UDP;
+    }
+    thread->dgram_batch = batch;
+    return batch;
+}
 
-        uint32_t send_n = pkt.length + header_size;
-        if (socket_type == SW_SOCK_UNIX_DGRAM)
-        {
-            send_n -= pkt.addr.un.path_length;
-        }
-        uint32_t offset = 0;
+/**
+ * enable_udp_batch: the datagrams of one recvmmsg are grouped by the target worker,
+ * the datagrams of a group are sent in one SW_EVENT_UDP_BATCH message
+ */
+static int swReactorThread_onPackageBatch(swReactor *reactor, swEvent *event)
+{
+    int fd = event->fd;
+    int i, j, n;
 
-        /**
-         * lock target
-         */
-        SwooleTG.factory_lock_target = 1;
+    swServer *serv = SwooleG.serv;
+    swFactory *factory = &serv->factory;
+    int socket_type = serv->connection_list[fd].socket_type;
+    swDgramRecvBatch *batch = swReactorThread_dgram_batch(swServer_get_thread(serv, SwooleTG.id));
+    if (batch == NULL)
+    {
+        return swReactorThread_onPackage(reactor, event);
+    }
+    swEventData *message = &batch->task.data;
 
-        if (factory->dispatch(factory, &task) < 0)
+    //less than a batch, the socket is drained
+    do
+    {
+        for (i = 0; i < SW_UDP_BATCH_SIZE; i++)
         {
-            return SW_ERR;
+            bzero(&batch->msgs[i], sizeof(batch->msgs[i]));
+            batch->msgs[i].msg_hdr.msg_name = &batch->addr[i].addr;
+            batch->msgs[i].msg_hdr.msg_namelen = sizeof(batch->addr[i].addr);
+            batch->msgs[i].msg_hdr.msg_iov = &batch->iov[i];
+            batch->msgs[i].msg_hdr.msg_iovlen = 1;
         }
-
-        send_n -= task.data.info.len;
-        if (send_n == 0)
+        n = recvmmsg(fd, batch->msgs, SW_UDP_BATCH_SIZE, 0, NULL);
+        if (n < 0)
         {
-            /**
-             * unlock
-             */
-            SwooleTG.factory_target_worker = -1;
-            SwooleTG.factory_lock_target = 0;
-            goto do_recvfrom;
+            if (errno == EAGAIN || errno == EINTR)
+            {
+                return SW_OK;
+            }
+            swSysError("recvmmsg(%d) failed.", fd);
+            return SW_ERR;
         }
 
-        offset = SW_BUFFER_SIZE - header_size;
-        while (send_n > 0)
+        for (i = 0; i < n; i++)
         {
-            task.data.info.len = send_n > SW_BUFFER_SIZE ? SW_BUFFER_SIZE : send_n;
-            memcpy(task.data.data, packet + offset, task.data.info.len);
-            send_n -= task.data.info.len;
-            offset += task.data.info.len;
+            swEventData *record = &batch->records[i];
+            swDgramPacket pkt;
+            pkt.length = batch->msgs[i].msg_len;
+            swReactorThread_dgram_info(&record->info, fd, socket_type);
+            uint32_t header_size = swReactorThread_dgram_header(socket_type, &batch->addr[i], &pkt, record);
 
-            if (factory->dispatch(factory, &task) < 0)
+            //larger than a record, the parts are sent alone
+            if (pkt.length + sizeof(swDgramPacket) > SW_BUFFER_SIZE - sizeof(swDataHead) - 8)
             {
-                break;
+                batch->target[i] = -1;
+                batch->task.target_worker_id = -1;
+                memcpy(message, record, sizeof(swDataHead) + header_size);
+                if (swReactorThread_dispatch_dgram(factory, &batch->task, header_size, pkt.length, batch->packets[i]) < 0)
+                {
+                    return SW_ERR;
+                }
+                continue;
             }
+            record->info.len = pkt.length + sizeof(swDgramPacket);
+            memcpy(record->data + header_size, batch->packets[i], batch->msgs[i].msg_len);
+            //the base mode handles the datagrams itself
+            batch->target[i] = serv->factory_mode == SW_MODE_PROCESS ? swServer_worker_schedule(serv, record->info.fd, record) : 0;
         }
-        /**
-         * unlock
-         */
-        SwooleTG.factory_target_worker = -1;
-        SwooleTG.factory_lock_target = 0;
-        goto do_recvfrom;
-    }
-    else
-    {
-        if (errno == EAGAIN)
-        {
-            return SW_OK;
-        }
-        else
+
+        for (i = 0; i < n; i++)
         {
-            swSysError("recvfrom(%d) failed.", fd);
+            //discarded or dispatched
+            if (batch->target[i] < 0)
+            {
+                continue;
+            }
+            batch->task.target_worker_id = batch->target[i];
+            for (j = i + 1; j < n && batch->target[j] != batch->target[i]; j++);
+            //the only one of the worker
+            if (j == n)
+            {
+                memcpy(message, &batch->records[i], sizeof(swDataHead) + batch->records[i].info.len);
+                factory->dispatch(factory, &batch->task);
+                continue;
+            }
+
+            message->info = batch->records[i].info;
+            message->info.type = SW_EVENT_UDP_BATCH;
+            message->info.len = 0;
+            for (j = i; j < n; j++)
+            {
+                if (batch->target[j] != batch->task.target_worker_id)
+                {
+                    continue;
+                }
+                uint32_t size = swEventData_batch_size(&batch->records[j].info);
+                if (message->info.len + size > SW_BUFFER_SIZE)
+                {
+                    factory->dispatch(factory, &batch->task);
+                    message->info.len = 0;
+                }
+                memcpy(message->data + message->info.len, &batch->records[j], sizeof(swDataHead) + batch->records[j].info.len);
+                message->info.len += size;
+                batch->target[j] = -1;
+            }
+            factory->dispatch(factory, &batch->task);
         }
-    }
-    return ret;
+    } while (n == SW_UDP_BATCH_SIZE);
+
+    return SW_OK;
 }
+#endif
 
 /**
  * close connection
@@ -318,8 +479,8 @@ int swReactorThread_close(swReactor *reactor, int fd)
 
     if (serv->factory_mode == SW_MODE_PROCESS)
     {
-        assert(fd % serv->reactor_num == reactor->id);
-        assert(fd % serv->reactor_num == SwooleTG.id);
+        assert(serv->connection_list[fd].from_id == reactor->id);
+        assert(serv->connection_list[fd].from_id == SwooleTG.id);
     }
 
     if (conn->removed == 0 && reactor->del(reactor, fd) < 0)
@@ -339,6 +500,15 @@ int swReactorThread_close(swReactor *reactor, int fd)
     }
 #endif
 
+    if (conn->zerocopy_buffer)
+    {
+        swReactorThread_zerocopy_linger(swServer_get_thread(serv, reactor->id), conn);
+    }
+    if (conn->recv_paused)
+    {
+        swServer_get_thread(serv, SwooleTG.id)->recv_paused_num--;
+    }
+
     //free the receive memory buffer
     swServer_free_buffer(serv, fd);
 
@@ -415,8 +585,8 @@ int swReactorThread_onClose(swReactor *reactor, swEvent *event)
     swDataHead notify_ev;
     bzero(&notify_ev, sizeof(notify_ev));
 
-    assert(fd % serv->reactor_num == reactor->id);
-    assert(fd % serv->reactor_num == SwooleTG.id);
+    assert(serv->connection_list[fd].from_id == reactor->id);
+    assert(serv->connection_list[fd].from_id == SwooleTG.id);
 
     notify_ev.from_id = reactor->id;
     notify_ev.fd = fd;
@@ -444,6 +614,155 @@ int swReactorThread_onClose(swReactor *reactor, swEvent *event)
     }
 }
 
+/**
+ * EPOLLERR without EPOLLIN and EPOLLOUT, the MSG_ZEROCOPY completions are in the error queue,
+ * also of the chunk which is still partially sent in out_buffer.
+ * EPOLLHUP and EPOLLRDHUP are level-triggered, the connection is only kept when EPOLLERR comes alone
+ */
+static int swReactorThread_onError(swReactor *reactor, swEvent *ev)
+{
+    swConnection *conn = ev->socket;
+    if (conn->zerocopy && (conn->zerocopy_done != conn->zerocopy_seq || !swBuffer_empty(conn->zerocopy_buffer)))
+    {
+        int error = 0;
+        socklen_t len = sizeof(error);
+        char c;
+        swConnection_zerocopy_reap(conn);
+        //nothing but the completions, recv() returns 0 after the peer has shut down
+        if (getsockopt(conn->fd, SOL_SOCKET, SO_ERROR, &error, &len) == 0 && error == 0
+                && recv(conn->fd, &c, 1, MSG_PEEK | MSG_DONTWAIT) < 0 && errno == EAGAIN)
+        {
+            return SW_OK;
+        }
+    }
+    return swReactorThread_onClose(reactor, ev);
+}
+
+/**
+ * the socket is closed, but the kernel may still send from the chunks
+ */
+static void swReactorThread_zerocopy_linger(swReactorThread *thread, swConnection *conn)
+{
+    swConnection_zerocopy_reap(conn);
+
+    if (thread->zerocopy_linger == NULL)
+    {
+        thread->zerocopy_linger = swBuffer_new(0);
+        if (thread->zerocopy_linger)
+        {
+            thread->zerocopy_linger->counter = &thread->output_memory;
+        }
+    }
+    swBuffer *linger = thread->zerocopy_linger;
+    time_t now = swReactor_now(&thread->reactor);
+
+    if (linger)
+    {
+        //partially sent
+        if (conn->zerocopy_done != conn->zerocopy_seq && !swBuffer_empty(conn->out_buffer)
+                && swBuffer_get_chunk(conn->out_buffer)->offset > 0)
+        {
+            swBuffer_move_chunk(conn->out_buffer, linger);
+            linger->tail->seq = now + SW_ZEROCOPY_LINGER_TIME;
+        }
+        while (!swBuffer_empty(conn->zerocopy_buffer))
+        {
+            swBuffer_move_chunk(conn->zerocopy_buffer, linger);
+            //the deadline
+            linger->tail->seq = now + SW_ZEROCOPY_LINGER_TIME;
+        }
+        swReactorThread_zerocopy_prune(thread, now);
+    }
+    swBuffer_free(conn->zerocopy_buffer);
+    conn->zerocopy_buffer = NULL;
+}
+
+/**
+ * release the lingering chunks after their deadline, called by the connections closing and the reactor timeout
+ */
+static void swReactorThread_zerocopy_prune(swReactorThread *thread, time_t now)
+{
+    swBuffer *linger = thread->zerocopy_linger;
+    while (!swBuffer_empty(linger) && (time_t) swBuffer_get_chunk(linger)->seq <= now)
+    {
+        swBuffer_pop_chunk(linger, swBuffer_get_chunk(linger));
+    }
+}
+
+/**
+ * send the response of the worker to the client
+ */
+static int swReactorThread_onResponse(swReactor *reactor, swEventData *resp)
+{
+    swSendData _send;
+    swPackage_response pkg_resp;
+    swWorker *worker;
+
+    memcpy(&_send.info, &resp->info, sizeof(resp->info));
+    //pipe data
+    if (_send.info.from_fd == SW_RESPONSE_SMALL)
+    {
+        _send.data = resp->data;
+        _send.length = resp->info.len;
+        swReactorThread_send(&_send);
+    }
+    //use send shm
+    else if (_send.info.from_fd == SW_RESPONSE_SHM)
+    {
+        memcpy(&pkg_resp, resp->data, sizeof(pkg_resp));
+        worker = swServer_get_worker(SwooleG.serv, pkg_resp.worker_id);
+
+        _send.data = worker->send_shm;
+        _send.length = pkg_resp.length;
+
+#if 0
+        struct
+        {
+            uint32_t worker;
+            uint32_t index;
+            uint32_t serid;
+        } pkg_header;
+
+        memcpy(&pkg_header, _send.data + 4, sizeof(pkg_header));
+        swWarn("fd=%d, worker=%d, index=%d, serid=%d", _send.info.fd, pkg_header.worker, pkg_header.index, pkg_header.serid);
+#endif
+        swReactorThread_send(&_send);
+        worker->lock.unlock(&worker->lock);
+    }
+    //use tmp file
+    else if (_send.info.from_fd == SW_RESPONSE_TMPFILE)
+    {
+        swString *data = swTaskWorker_large_unpack(resp);
+        if (data == NULL)
+        {
+            return SW_ERR;
+        }
+        _send.data = data->str;
+        _send.length = data->length;
+        swReactorThread_send(&_send);
+    }
+    //reactor thread exit
+    else if (_send.info.from_fd == SW_RESPONSE_EXIT)
+    {
+        reactor->running = 0;
+        return SW_OK;
+    }
+    //will never be here
+    else
+    {
+        abort();
+    }
+    if (SwooleG.serv->enable_reactor_steal)
+    {
+        swConnection *conn = swServer_connection_verify_no_ssl(SwooleG.serv, _send.info.fd);
+        if (conn)
+        {
+            swServer_connection_route_release(SwooleG.serv, conn);
+        }
+    }
+    return SW_OK;
+}
+
 /**
  * receive data from worker process pipe
  */
@@ -451,10 +770,6 @@ static int swReactorThread_onPipeReceive(swReactor *reactor, swEvent *ev)
 {
     int n;
     swEventData resp;
-    swSendData _send;
-
-    swPackage_response pkg_resp;
-    swWorker *worker;
 
 #ifdef SW_REACTOR_RECV_AGAIN
     while (1)
@@ -463,73 +778,99 @@ static int swReactorThread_onPipeReceive(swReactor *reactor, swEvent *ev)
         n = read(ev->fd, &resp, sizeof(resp));
         if (n > 0)
         {
-            memcpy(&_send.info, &resp.info, sizeof(resp.info));
-            //pipe data
-            if (_send.info.from_fd == SW_RESPONSE_SMALL)
+            if (swReactorThread_onResponse(reactor, &resp) < 0)
             {
-                _send.data = resp.data;
-                _send.length = resp.info.len;
-                swReactorThread_send(&_send);
+                return SW_ERR;
             }
-            //use send shm
-            else if (_send.info.from_fd == SW_RESPONSE_SHM)
+            //reactor thread exit
+            if (resp.info.from_fd == SW_RESPONSE_EXIT)
             {
-                memcpy(&pkg_resp, resp.data, sizeof(pkg_resp));
-                worker = swServer_get_worker(SwooleG.serv, pkg_resp.worker_id);
+                return SW_OK;
+            }
+        }
+        else if (errno == EAGAIN)
+        {
+            return SW_OK;
+        }
+        else
+        {
+            swWarn("read(worker_pipe) failed. Error: %s[%d]", strerror(errno), errno);
+            return SW_ERR;
+        }
+    }
 
-                _send.data = worker->send_shm;
-                _send.length = pkg_resp.length;
+    return SW_OK;
+}
 
-#if 0
-                struct
-                {
-                    uint32_t worker;
-                    uint32_t index;
-                    uint32_t serid;
-                } pkg_header;
+static int swReactorThread_ring_empty(swServer *serv, int reactor_id)
+{
+    int i;
+    for (i = 0; i < serv->worker_num; i++)
+    {
+        if (!swShmRing_empty(swServer_get_response_ring(serv, i, reactor_id)))
+        {
+            return SW_FALSE;
+        }
+    }
+    return SW_TRUE;
+}
 
-                memcpy(&pkg_header, _send.data + 4, sizeof(pkg_header));
-                swWarn("fd=%d, worker=%d, index=%d, serid=%d", _send.info.fd, pkg_header.worker, pkg_header.index, pkg_header.serid);
-#endif
-                swReactorThread_send(&_send);
-                worker->lock.unlock(&worker->lock);
+/**
+ * SW_IPC_RING: the doorbell of the reactor thread, receive the responses from the rings of all workers
+ */
+int swReactorThread_onRingReceive(swReactor *reactor, swEvent *ev)
+{
+    swServer *serv = reactor->ptr;
+    int reactor_id = reactor->id;
+    swReactorThread *thread = swServer_get_thread(serv, reactor_id);
+    swDoorbell *bell = &serv->reactor_doorbells[reactor_id];
+    swEventData resp;
+    swShmRing *ring;
+    int i, n, more;
+
+    swDoorbell_clear(bell);
+
+    while (1)
+    {
+        more = 0;
+        for (i = 0; i < serv->worker_num; i++)
+        {
+            ring = swServer_get_response_ring(serv, i, reactor_id);
+            for (n = 0; n < SW_IPC_RING_BATCH && swShmRing_pop(ring, &resp, sizeof(resp)) > 0; n++)
+            {
+                swReactorThread_onResponse(reactor, &resp);
             }
-            //use tmp file
-            else if (_send.info.from_fd == SW_RESPONSE_TMPFILE)
+            if (n > 0)
             {
-                swString *data = swTaskWorker_large_unpack(&resp);
-                if (data == NULL)
+                swServer_ring_release(ring, &serv->worker_doorbells[i]);
+                if (n == SW_IPC_RING_BATCH)
                 {
-                    return SW_ERR;
+                    more = 1;
                 }
-                _send.data = data->str;
-                _send.length = data->length;
-                swReactorThread_send(&_send);
             }
-            //reactor thread exit
-            else if (_send.info.from_fd == SW_RESPONSE_EXIT)
+            //the requests waiting for the ring of this worker
+            if (!swBuffer_empty(thread->ring_buffer[i]))
             {
-                reactor->running = 0;
-                return SW_OK;
-            }
-            //will never be here
-            else
-            {
-                abort();
+                swServer_ring_flush(swServer_get_request_ring(serv, i, reactor_id), thread->ring_buffer[i], &serv->worker_doorbells[i]);
             }
         }
-        else if (errno == EAGAIN)
+        //give the other events a chance, and come back in the next round
+        if (more)
         {
+            swDoorbell_notify(bell);
             return SW_OK;
         }
-        else
+        swDoorbell_sleep(bell);
+        if (swReactorThread_ring_empty(serv, reactor_id))
         {
-            swWarn("read(worker_pipe) failed. Error: %s[%d]", strerror(errno), errno);
-            return SW_ERR;
+            return SW_OK;
+        }
+        //a worker has rung the doorbell, the eventfd will fire again
+        if (!swDoorbell_wakeup(bell))
+        {
+            return SW_OK;
         }
     }
-
-    return SW_OK;
 }
 
 int swReactorThread_send2worker(void *data, int len, uint16_t target_worker_id)
@@ -541,8 +882,15 @@ int swReactorThread_send2worker(void *data, int len, uint16_t target_worker_id)
     int ret = -1;
     swWorker *worker = &(serv->workers[target_worker_id]);
 
+    //reactor thread, shared memory ring
+    if (SwooleTG.type == SW_THREAD_REACTOR && serv->ipc_mode == SW_IPC_RING)
+    {
+        swReactorThread *thread = swServer_get_thread(serv, SwooleTG.id);
+        ret = swServer_ring_push(swServer_get_request_ring(serv, target_worker_id, SwooleTG.id),
+                &thread->ring_buffer[target_worker_id], &serv->worker_doorbells[target_worker_id], data, len);
+    }
     //reactor thread
-    if (SwooleTG.type == SW_THREAD_REACTOR)
+    else if (SwooleTG.type == SW_THREAD_REACTOR)
     {
         int pipe_fd = worker->pipe_master;
         int thread_id = serv->connection_list[pipe_fd].from_id;
@@ -590,6 +938,28 @@ int swReactorThread_send2worker(void *data, int len, uint16_t target_worker_id)
     return ret;
 }
 
+/**
+ * the output buffers take more memory than output_memory_high_watermark,
+ * the connections holding more than the average stop reading until it is below the low watermark
+ */
+static sw_inline int swReactorThread_pause_recv(swServer *serv, swConnection *conn)
+{
+    if (conn->recv_paused || serv->output_memory_high_watermark == 0 || swBuffer_empty(conn->out_buffer))
+    {
+        return conn->recv_paused;
+    }
+    long total = serv->stats->output_buffer_memory;
+    if (total < (long) serv->output_memory_high_watermark
+            || (long) conn->out_buffer->length * serv->stats->connection_num < total)
+    {
+        return SW_FALSE;
+    }
+    conn->recv_paused = 1;
+    swServer_get_thread(serv, SwooleTG.id)->recv_paused_num++;
+    swTraceLog(SW_TRACE_REACTOR, "connection#%d stops reading, output memory=%ld.", conn->fd, total);
+    return SW_TRUE;
+}
+
 /**
  * send to client or append to out_buffer
  */
@@ -644,8 +1014,8 @@ int swReactorThread_send(swSendData *_send)
     else
     {
         reactor = &(serv->reactor_threads[conn->from_id].reactor);
-        assert(fd % serv->reactor_num == reactor->id);
-        assert(fd % serv->reactor_num == SwooleTG.id);
+        assert(serv->connection_list[fd].from_id == reactor->id);
+        assert(serv->connection_list[fd].from_id == SwooleTG.id);
     }
 
     /**
@@ -705,7 +1075,8 @@ int swReactorThread_send(swSendData *_send)
         //Direct send
         if (_send->info.type != SW_EVENT_SENDFILE)
         {
-            if (!conn->direct_send)
+            //MSG_ZEROCOPY sends from the chunk, which lives until the kernel completes
+            if (!conn->direct_send || (conn->zerocopy && _send_length >= serv->zerocopy_threshold))
             {
                 goto buffer_send;
             }
@@ -773,8 +1144,8 @@ int swReactorThread_send(swSendData *_send)
             swWarn("connection#%d is closed by client.", fd);
             return SW_ERR;
         }
-        //connection output buffer overflow
-        if (conn->out_buffer->length >= conn->buffer_size)
+        //connection output buffer overflow, including the chunks waiting for MSG_ZEROCOPY completions
+        if (conn->out_buffer->length + (conn->zerocopy_buffer ? conn->zerocopy_buffer->length : 0) >= conn->buffer_size)
         {
             if (serv->send_yield)
             {
@@ -791,10 +1162,36 @@ int swReactorThread_send(swSendData *_send)
             }
         }
 
+        //counted by the reactor thread which owns the connection
+        swReactorThread *thread = swServer_get_thread(serv, SwooleTG.id);
+        if (conn->out_buffer->counter != &thread->output_memory)
+        {
+            thread->output_memory.total = &serv->stats->output_buffer_memory;
+            swBuffer_set_counter(conn->out_buffer, &thread->output_memory);
+            if (conn->zerocopy_buffer)
+            {
+                swBuffer_set_counter(conn->zerocopy_buffer, &thread->output_memory);
+            }
+        }
+
         int _length = _send_length;
         void* _pos = _send_data;
         int _n;
 
+        //one chunk, sent with MSG_ZEROCOPY
+        if (conn->zerocopy && _length >= serv->zerocopy_threshold)
+        {
+            chunk = swBuffer_new_chunk(conn->out_buffer, SW_CHUNK_DATA, _length);
+            if (chunk == NULL)
+            {
+                return SW_ERR;
+            }
+            memcpy(chunk->store.ptr, _pos, _length);
+            chunk->length = _length;
+            conn->out_buffer->length += _length;
+            _length = 0;
+        }
+
         //buffer enQueue
         while (_length > 0)
         {
@@ -812,8 +1209,8 @@ int swReactorThread_send(swSendData *_send)
         }
     }
 
-    //listen EPOLLOUT event
-    if (reactor->set(reactor, fd, SW_EVENT_TCP | SW_EVENT_WRITE | SW_EVENT_READ) < 0
+    //listen EPOLLOUT event, stop reading if the output buffers take too much memory
+    if (reactor->set(reactor, fd, SW_EVENT_TCP | SW_EVENT_WRITE | (swReactorThread_pause_recv(serv, conn) ? 0 : SW_EVENT_READ)) < 0
             && (errno == EBADF || errno == ENOENT))
     {
         goto close_fd;
@@ -911,11 +1308,20 @@ static int swReactorThread_onPipeWrite(swReactor *reactor, swEvent *ev)
 void swReactorThread_set_protocol(swServer *serv, swReactor *reactor)
 {
     //UDP Packet
+#ifdef HAVE_RECVMMSG
+    reactor->setHandle(reactor, SW_FD_UDP, serv->enable_udp_batch ? swReactorThread_onPackageBatch : swReactorThread_onPackage);
+#else
     reactor->setHandle(reactor, SW_FD_UDP, swReactorThread_onPackage);
+#endif
     //Write
     reactor->setHandle(reactor, SW_FD_TCP | SW_EVENT_WRITE, swReactorThread_onWrite);
     //Read
     reactor->setHandle(reactor, SW_FD_TCP | SW_EVENT_READ, swReactorThread_onRead);
+    //MSG_ZEROCOPY completions
+    if (serv->zerocopy_threshold)
+    {
+        reactor->setHandle(reactor, SW_FD_TCP | SW_EVENT_ERROR, swReactorThread_onError);
+    }
 
     swListenPort *ls;
     //listen the all tcp port
@@ -952,16 +1358,38 @@ static int swReactorThread_onRead(swReactor *reactor, swEvent *event)
     /**
      * TimeWheel update
      */
-    if (reactor->timewheel && swTimeWheel_new_index(reactor->timewheel) != event->socket->timewheel_index)
+    if (reactor->timewheel && unlikely(event->socket->timewheel_moved))
+    {
+        event->socket->timewheel_moved = 0;
+        swTimeWheel_add(reactor->timewheel, event->socket);
+    }
+    else if (reactor->timewheel && swTimeWheel_new_index(reactor->timewheel) != event->socket->timewheel_index)
+    {
+        swTimeWheel_update(reactor->timewheel, event->socket);
+    }
+#endif
+
+    event->socket->last_time = swReactor_now(reactor);
+#ifdef SW_BUFFER_RECV_TIME
+    event->socket->last_time_usec = swoole_microtime();
+#endif
+
+    if (serv->enable_reactor_steal)
+    {
+        swReactorThread *thread = swServer_get_thread(serv, reactor->id);
+        thread->steal_events++;
+        if (event->socket->steal_period != thread->steal_period)
+        {
+            event->socket->steal_period = thread->steal_period;
+            event->socket->steal_events = 0;
+        }
+        event->socket->steal_events++;
+    }
+    //EPOLLERR of the MSG_ZEROCOPY completions is ignored together with EPOLLIN
+    if (!swBuffer_empty(event->socket->zerocopy_buffer))
     {
-        swTimeWheel_update(reactor->timewheel, event->socket);
+        swConnection_zerocopy_reap(event->socket);
     }
-#endif
-
-    event->socket->last_time = serv->gs->now;
-#ifdef SW_BUFFER_RECV_TIME
-    event->socket->last_time_usec = swoole_microtime();
-#endif
 
     return port->onRead(reactor, port, event);
 }
@@ -975,8 +1403,8 @@ static int swReactorThread_onWrite(swReactor *reactor, swEvent *ev)
 
     if (serv->factory_mode == SW_MODE_PROCESS)
     {
-        assert(fd % serv->reactor_num == reactor->id);
-        assert(fd % serv->reactor_num == SwooleTG.id);
+        assert(serv->connection_list[fd].from_id == reactor->id);
+        assert(serv->connection_list[fd].from_id == SwooleTG.id);
     }
 
     swConnection *conn = swServer_connection_get(serv, fd);
@@ -984,10 +1412,26 @@ static int swReactorThread_onWrite(swReactor *reactor, swEvent *ev)
     {
         return SW_ERR;
     }
+    if (!swBuffer_empty(conn->zerocopy_buffer))
+    {
+        swConnection_zerocopy_reap(conn);
+    }
 
     swTraceLog(SW_TRACE_REACTOR, "fd=%d, conn->connect_notify=%d, conn->close_notify=%d, serv->disable_notify=%d, conn->close_force=%d",
             fd, conn->connect_notify, conn->close_notify, serv->disable_notify, conn->close_force);
 
+#ifdef SW_USE_TIMEWHEEL
+    //moved from another reactor thread, see swReactorThread_steal
+    if (conn->timewheel_moved)
+    {
+        conn->timewheel_moved = 0;
+        if (reactor->timewheel)
+        {
+            swTimeWheel_add(reactor->timewheel, conn);
+        }
+    }
+#endif
+
     if (conn->connect_notify)
     {
         conn->connect_notify = 0;
@@ -1055,6 +1499,10 @@ static int swReactorThread_onWrite(swReactor *reactor, swEvent *ev)
         {
             ret = swConnection_onSendfile(conn, chunk);
         }
+        else if (conn->zerocopy && chunk->length >= serv->zerocopy_threshold)
+        {
+            ret = swConnection_buffer_send_zerocopy(conn);
+        }
         else
         {
             ret = swConnection_buffer_send(conn);
@@ -1091,7 +1539,8 @@ static int swReactorThread_onWrite(swReactor *reactor, swEvent *ev)
     //remove EPOLLOUT event
     if (!conn->removed && swBuffer_empty(conn->out_buffer))
     {
-        reactor->set(reactor, fd, SW_FD_TCP | SW_EVENT_READ);
+        reactor->set(reactor, fd, SW_FD_TCP | (conn->recv_paused ? 0 : SW_EVENT_READ));
+        swReactorThread_resume_recv(reactor);
     }
     return SW_OK;
 }
@@ -1109,6 +1558,42 @@ int swReactorThread_create(swServer *serv)
         return SW_ERR;
     }
 
+    /**
+     * the latency histograms are read by the workers, put them in the shared memory
+     */
+    if (SwooleG.enable_latency_stats)
+    {
+        int i;
+        for (i = 0; i < serv->reactor_num; i++)
+        {
+            swHistogram *hist = SwooleG.memory_pool->alloc(SwooleG.memory_pool, sizeof(swHistogram));
+            if (hist == NULL)
+            {
+                swError("alloc[latency] failed.");
+                return SW_ERR;
+            }
+            swHistogram_reset(hist);
+            serv->reactor_threads[i].latency = hist;
+        }
+    }
+
+    /**
+     * the workers release the packages, the pools must be created before fork
+     */
+    if (serv->package_pool_size > 0 && serv->factory_mode == SW_MODE_PROCESS)
+    {
+        int i;
+        for (i = 0; i < serv->reactor_num; i++)
+        {
+            serv->reactor_threads[i].package_pool = swSlabPool_new(serv->package_pool_size, SW_PACKAGE_POOL_PAGE_SIZE);
+            if (serv->reactor_threads[i].package_pool == NULL)
+            {
+                swError("create package_pool failed.");
+                return SW_ERR;
+            }
+        }
+    }
+
     /**
      * alloc the memory for connection_list
      */
@@ -1158,6 +1643,68 @@ int swReactorThread_create(swServer *serv)
     return SW_OK;
 }
 
+#ifdef HAVE_REUSEPORT
+/**
+ * create the listening socket of each reactor thread, must be called before listen()
+ */
+int swReactorThread_reuse_port(swServer *serv, swListenPort *ls)
+{
+    int i, sock, option = 1;
+    int listen_sock = ls->sock;
+
+    //the first reactor thread uses the socket of the port
+    if (setsockopt(listen_sock, SOL_SOCKET, SO_REUSEPORT, &option, sizeof(option)) < 0)
+    {
+        swSysError("setsockopt(%d, SO_REUSEPORT) failed.", listen_sock);
+        return SW_ERR;
+    }
+    ls->reactor_socks = sw_calloc(serv->reactor_num, sizeof(int));
+    if (ls->reactor_socks == NULL)
+    {
+        swWarn("malloc(%ld) failed.", serv->reactor_num * sizeof(int));
+        return SW_ERR;
+    }
+    ls->reactor_socks[0] = listen_sock;
+
+    SwooleG.reuse_port = 1;
+    for (i = 1; i < serv->reactor_num; i++)
+    {
+        sock = swSocket_create(ls->type);
+        if (sock < 0)
+        {
+            swSysError("create socket failed.");
+            goto _fail;
+        }
+        if (swSocket_bind(sock, ls->type, ls->host, &ls->port) < 0)
+        {
+            close(sock);
+            goto _fail;
+        }
+        swSetNonBlock(sock);
+        ls->sock = sock;
+        ls->reactor_socks[i] = sock;
+        if (swPort_listen(ls) < 0)
+        {
+            goto _fail;
+        }
+    }
+    SwooleG.reuse_port = 0;
+    ls->sock = listen_sock;
+    return SW_OK;
+
+    _fail:
+    SwooleG.reuse_port = 0;
+    ls->sock = listen_sock;
+    for (i = 1; i < serv->reactor_num && ls->reactor_socks[i] > 0; i++)
+    {
+        close(ls->reactor_socks[i]);
+    }
+    sw_free(ls->reactor_socks);
+    ls->reactor_socks = NULL;
+    return SW_ERR;
+}
+#endif
+
 int swReactorThread_start(swServer *serv, swReactor *main_reactor_ptr)
 {
     swThreadParam *param;
@@ -1178,6 +1725,19 @@ int swReactorThread_start(swServer *serv, swReactor *main_reactor_ptr)
         {
             continue;
         }
+        //the reactor threads accept by themselves
+        if (serv->accept_mode != SW_ACCEPT_MASTER)
+        {
+            if (ls->reactor_socks)
+            {
+                for (i = 1; i < serv->reactor_num; i++)
+                {
+                    serv->connection_list[ls->reactor_socks[i]] = serv->connection_list[ls->sock];
+                    serv->connection_list[ls->reactor_socks[i]].fd = ls->reactor_socks[i];
+                }
+            }
+            continue;
+        }
         main_reactor_ptr->add(main_reactor_ptr, ls->sock, SW_FD_LISTEN);
     }
 
@@ -1232,6 +1792,28 @@ static int swReactorThread_loop(swThreadParam *param)
     SwooleTG.id = reactor_id;
     SwooleTG.type = SW_THREAD_REACTOR;
 
+    swReactorThread *thread = swServer_get_thread(serv, reactor_id);
+    swReactor *reactor = &thread->reactor;
+
+    //pinned before the buffers are allocated, so they are on the same NUMA node
+    int node = swServer_set_cpu_affinity(serv, serv->reactor_cpu_set, serv->reactor_cpu_set_num, reactor_id);
+    //the memory written by the reactor thread
+    if (node >= 0 && serv->factory_mode == SW_MODE_PROCESS)
+    {
+        if (thread->package_pool)
+        {
+            sw_shm_bind(thread->package_pool, node);
+        }
+        if (serv->request_rings)
+        {
+            int i;
+            for (i = 0; i < serv->worker_num; i++)
+            {
+                sw_shm_bind(swServer_get_request_ring(serv, i, reactor_id), node);
+            }
+        }
+    }
+
     if (serv->factory_mode == SW_MODE_BASE || serv->factory_mode == SW_MODE_THREAD)
     {
         SwooleTG.buffer_input = swServer_create_worker_buffer(serv);
@@ -1247,34 +1829,8 @@ static int swReactorThread_loop(swThreadParam *param)
         return SW_ERR;
     }
 
-    swReactorThread *thread = swServer_get_thread(serv, reactor_id);
-    swReactor *reactor = &thread->reactor;
-
     SwooleTG.reactor = reactor;
 
-#ifdef HAVE_CPU_AFFINITY
-    //cpu affinity setting
-    if (serv->open_cpu_affinity)
-    {
-        cpu_set_t cpu_set;
-        CPU_ZERO(&cpu_set);
-
-        if (serv->cpu_affinity_available_num)
-        {
-            CPU_SET(serv->cpu_affinity_available[reactor_id % serv->cpu_affinity_available_num], &cpu_set);
-        }
-        else
-        {
-            CPU_SET(reactor_id % SW_CPU_NUM, &cpu_set);
-        }
-
-        if (0 != pthread_setaffinity_np(thread_id, sizeof(cpu_set), &cpu_set))
-        {
-            swSysError("pthread_setaffinity_np() failed.");
-        }
-    }
-#endif
-
     ret = swReactor_create(reactor, SW_REACTOR_MAXEVENTS);
     if (ret < 0)
     {
@@ -1288,15 +1844,58 @@ static int swReactorThread_loop(swThreadParam *param)
     reactor->thread = 1;
     reactor->socket_list = serv->connection_list;
     reactor->max_socket = serv->max_connection;
+    reactor->busy_poll_usec = reactor->busy_poll_budget = serv->busy_poll_usec;
+    reactor->latency = thread->latency;
+
+#ifdef HAVE_IO_URING
+    if (serv->io_uring_completion
+            && swReactorIOUring_enable_completion(reactor, SW_IOURING_RECV_BUFFER_NUM, SW_IOURING_RECV_BUFFER_SIZE) < 0)
+    {
+        swWarn("reactor#%d: io_uring completion mode is disabled.", reactor_id);
+    }
+#endif
 
     reactor->onFinish = NULL;
     reactor->onTimeout = NULL;
     reactor->close = swReactorThread_close;
 
+    if (serv->enable_reactor_steal || serv->output_memory_high_watermark > 0 || serv->zerocopy_threshold > 0)
+    {
+        reactor->onFinish = swReactorThread_onFinish;
+        reactor->onTimeout = swReactorThread_onFinish;
+        if (serv->output_memory_high_watermark > 0)
+        {
+            reactor->timeout_msec = SW_OUTPUT_MEMORY_CHECK_INTERVAL;
+        }
+        else if (serv->enable_reactor_steal)
+        {
+            reactor->timeout_msec = SW_REACTOR_STEAL_INTERVAL;
+        }
+        else
+        {
+            reactor->timeout_msec = SW_ZEROCOPY_LINGER_CHECK_INTERVAL;
+        }
+        thread->steal_time = swReactor_now_msec(reactor) + SW_REACTOR_STEAL_INTERVAL;
+    }
+
     reactor->setHandle(reactor, SW_FD_CLOSE, swReactorThread_onClose);
     reactor->setHandle(reactor, SW_FD_PIPE | SW_EVENT_READ, swReactorThread_onPipeReceive);
     reactor->setHandle(reactor, SW_FD_PIPE | SW_EVENT_WRITE, swReactorThread_onPipeWrite);
 
+    if (serv->ipc_mode == SW_IPC_RING)
+    {
+        thread->ring_buffer = sw_calloc(serv->worker_num, sizeof(swBuffer *));
+        if (thread->ring_buffer == NULL)
+        {
+            swSysError("thread->ring_buffer create failed");
+            return SW_ERR;
+        }
+        int bell_fd = swDoorbell_getFd(&serv->reactor_doorbells[reactor_id]);
+        serv->connection_list[bell_fd].fd = bell_fd;
+        reactor->add(reactor, bell_fd, SW_FD_IPC_RING);
+        reactor->setHandle(reactor, SW_FD_IPC_RING, swReactorThread_onRingReceive);
+    }
+
     //listen UDP
     if (serv->have_udp_sock == 1)
     {
@@ -1329,6 +1928,13 @@ static int swReactorThread_loop(swThreadParam *param)
     //set protocol function point
     swReactorThread_set_protocol(serv, reactor);
 
+    //accept the new connections in this thread
+    if (serv->accept_mode != SW_ACCEPT_MASTER)
+    {
+        reactor->setHandle(reactor, SW_FD_LISTEN, swServer_master_onAccept);
+        swServer_enable_accept(reactor);
+    }
+
     int i = 0, pipe_fd;
 #ifdef SW_USE_RINGBUFFER
     int j = 0;
@@ -1419,6 +2025,20 @@ static int swReactorThread_loop(swThreadParam *param)
     }
 #endif
 
+    //accept_mode, wake up to accept again after too many open files
+    if (serv->accept_mode != SW_ACCEPT_MASTER)
+    {
+        if (reactor->onFinish == NULL)
+        {
+            reactor->onFinish = swReactorThread_onFinish;
+            reactor->onTimeout = swReactorThread_onFinish;
+        }
+        if (reactor->timeout_msec <= 0 || reactor->timeout_msec > 1000)
+        {
+            reactor->timeout_msec = 1000;
+        }
+    }
+
     //wait other thread
 #ifdef HAVE_PTHREAD_BARRIER
     pthread_barrier_wait(&serv->barrier);
@@ -1437,6 +2057,19 @@ static int swReactorThread_loop(swThreadParam *param)
     }
 #endif
 
+    if (thread->ring_buffer)
+    {
+        for (i = 0; i < serv->worker_num; i++)
+        {
+            if (thread->ring_buffer[i])
+            {
+                swBuffer_free(thread->ring_buffer[i]);
+            }
+        }
+        sw_free(thread->ring_buffer);
+        thread->ring_buffer = NULL;
+    }
+
     swString_free(SwooleTG.buffer_stack);
     pthread_exit(0);
     return SW_OK;
@@ -1516,6 +2149,33 @@ int swReactorThread_dispatch(swConnection *conn, char *data, uint32_t length)
     }
 #else
 
+    /**
+     * copy the package to the shared memory once, the worker gets the descriptor
+     */
+    swReactorThread *thread = SwooleTG.type == SW_THREAD_REACTOR ? swServer_get_thread(serv, SwooleTG.id) : NULL;
+    if (length > SW_BUFFER_SIZE && thread && thread->package_pool)
+    {
+        swPackage package;
+        package.length = length;
+        package.id = conn->session_id;
+        package.data = thread->package_pool->alloc(thread->package_pool, length);
+        //the pool is full, send the chunks
+        if (package.data)
+        {
+            memcpy(package.data, data, length);
+            task.data.info.type = SW_EVENT_PACKAGE;
+            task.data.info.len = sizeof(package);
+            memcpy(task.data.data, &package, sizeof(package));
+            task.target_worker_id = -1;
+
+            if (factory->dispatch(factory, &task) < 0)
+            {
+                thread->package_pool->free(thread->package_pool, package.data);
+            }
+            return SW_OK;
+        }
+    }
+
     task.data.info.type = SW_EVENT_PACKAGE_START;
     task.target_worker_id = -1;
 
@@ -1601,17 +2261,219 @@ void swReactorThread_free(swServer *serv)
 #ifdef SW_USE_RINGBUFFER
         thread->buffer_input->destroy(thread->buffer_input);
 #endif
+        if (thread->package_pool)
+        {
+            thread->package_pool->destroy(thread->package_pool);
+            thread->package_pool = NULL;
+        }
+        if (thread->zerocopy_linger)
+        {
+            swBuffer_free(thread->zerocopy_linger);
+            thread->zerocopy_linger = NULL;
+        }
     }
 }
 
 #ifdef SW_USE_TIMEWHEEL
 static void swReactorThread_onReactorCompleted(swReactor *reactor)
 {
-    swServer *serv = reactor->ptr;
-    if (reactor->heartbeat_interval > 0 && reactor->last_heartbeat_time < serv->gs->now - reactor->heartbeat_interval)
+    time_t now = swReactor_now(reactor);
+    if (reactor->heartbeat_interval > 0 && reactor->last_heartbeat_time < now - reactor->heartbeat_interval)
     {
         swTimeWheel_forward(reactor->timewheel, reactor);
-        reactor->last_heartbeat_time = serv->gs->now;
+        reactor->last_heartbeat_time = now;
+    }
+    swReactorThread_onFinish(reactor);
+}
+#endif
+
+static void swReactorThread_onFinish(swReactor *reactor)
+{
+    swServer *serv = reactor->ptr;
+    if (serv->enable_reactor_steal)
+    {
+        swReactorThread_onSteal(reactor);
+    }
+    swReactorThread_resume_recv(reactor);
+
+    swReactorThread *thread = swServer_get_thread(serv, reactor->id);
+    //accept_mode, the listening sockets are only changed by the thread itself
+    if (reactor->disable_accept && swReactor_now(reactor) >= thread->accept_resume_time)
+    {
+        reactor->disable_accept = 0;
+        swServer_enable_accept(reactor);
+    }
+    if (!swBuffer_empty(thread->zerocopy_linger))
+    {
+        swReactorThread_zerocopy_prune(thread, swReactor_now(reactor));
+    }
+}
+
+/**
+ * the output memory is below the low watermark, the paused connections of the thread read again
+ */
+static void swReactorThread_resume_recv(swReactor *reactor)
+{
+    swServer *serv = reactor->ptr;
+    swReactorThread *thread = swServer_get_thread(serv, SwooleTG.id);
+    if (thread->recv_paused_num == 0 || serv->stats->output_buffer_memory > (long) serv->output_memory_low_watermark)
+    {
+        return;
+    }
+
+    int fd, max_fd = swServer_get_maxfd(serv), min_fd = swServer_get_minfd(serv);
+    swConnection *conn;
+    for (fd = min_fd; fd <= max_fd && thread->recv_paused_num > 0; fd++)
+    {
+        conn = &serv->connection_list[fd];
+        if (!conn->recv_paused || conn->from_id != reactor->id)
+        {
+            continue;
+        }
+        conn->recv_paused = 0;
+        thread->recv_paused_num--;
+        if (conn->active && !conn->removed)
+        {
+            reactor->set(reactor, fd, SW_FD_TCP | SW_EVENT_READ | (swBuffer_empty(conn->out_buffer) ? 0 : SW_EVENT_WRITE));
+        }
+    }
+}
+
+/**
+ * move an idle connection to another reactor thread, nothing may be in flight between the connection and the workers
+ */
+static int swReactorThread_steal(swReactor *reactor, swConnection *conn, int target_id)
+{
+    swServer *serv = reactor->ptr;
+    swReactor *target = &serv->reactor_threads[target_id].reactor;
+    int fd = conn->fd;
+    int owner = reactor->id;
+
+    //the workers wait until the route is set again
+    if (!sw_atomic_cmp_set(&conn->route, (uint32_t) reactor->id << SW_CONNECTION_ROUTE_SHIFT,
+            (uint32_t) SW_CONNECTION_ROUTE_LOCKED << SW_CONNECTION_ROUTE_SHIFT))
+    {
+        return SW_ERR;
+    }
+    if (reactor->del(reactor, fd) == SW_OK)
+    {
+        int events = SW_FD_TCP | SW_EVENT_READ;
+#ifdef SW_USE_TIMEWHEEL
+        /**
+         * the wheel of the target is only changed by its own thread,
+         * the writable event makes it add the connection at once, see swReactorThread_onWrite
+         */
+        if (reactor->timewheel)
+        {
+            swTimeWheel_remove(reactor->timewheel, conn);
+            conn->timewheel_moved = 1;
+            events |= SW_EVENT_WRITE;
+        }
+#endif
+        conn->from_id = target_id;
+        //the same as a new connection from the master thread, see swServer_master_onAccept
+        if (target->add(target, fd, events) == SW_OK)
+        {
+            owner = target_id;
+        }
+        else
+        {
+            conn->from_id = reactor->id;
+#ifdef SW_USE_TIMEWHEEL
+            if (conn->timewheel_moved)
+            {
+                conn->timewheel_moved = 0;
+                swTimeWheel_add(reactor->timewheel, conn);
+            }
+#endif
+            reactor->add(reactor, fd, SW_FD_TCP | SW_EVENT_READ);
+        }
     }
+    swServer_connection_route_set(conn, owner);
+    swTraceLog(SW_TRACE_REACTOR, "connection#%d moved from reactor#%d to reactor#%d.", fd, reactor->id, owner);
+    return owner == target_id ? SW_OK : SW_ERR;
 }
+
+static sw_inline int swReactorThread_can_steal(swReactor *reactor, swConnection *conn)
+{
+    if (!conn->active || conn->closed || conn->removed || conn->from_id != reactor->id || conn->fdtype != SW_FD_TCP
+            || conn->events != SW_EVENT_READ || conn->listen_wait || !swBuffer_empty(conn->out_buffer))
+    {
+        return SW_FALSE;
+    }
+    //idle between two reads
+    if ((conn->recv_buffer && conn->recv_buffer->length > 0) || (conn->websocket_buffer && conn->websocket_buffer->length > 0))
+    {
+        return SW_FALSE;
+    }
+#ifdef SW_USE_OPENSSL
+    if (conn->ssl)
+    {
+        return SW_FALSE;
+    }
 #endif
+    return SW_TRUE;
+}
+
+/**
+ * once per SW_REACTOR_STEAL_INTERVAL, an overloaded reactor thread gives the connections
+ * which fit into the gap to the least loaded thread
+ */
+static void swReactorThread_onSteal(swReactor *reactor)
+{
+    swServer *serv = reactor->ptr;
+    swReactorThread *thread = swServer_get_thread(serv, reactor->id);
+    int64_t now = swReactor_now_msec(reactor);
+
+    if (now < thread->steal_time)
+    {
+        return;
+    }
+    thread->steal_time = now + SW_REACTOR_STEAL_INTERVAL;
+    thread->steal_load = thread->steal_events;
+    thread->steal_events = 0;
+    uint16_t period = thread->steal_period++;
+
+    uint64_t total = 0;
+    uint32_t min_load = thread->steal_load;
+    int i, target_id = reactor->id;
+    for (i = 0; i < serv->reactor_num; i++)
+    {
+        uint32_t load = serv->reactor_threads[i].steal_load;
+        total += load;
+        if (load < min_load)
+        {
+            min_load = load;
+            target_id = i;
+        }
+    }
+    uint32_t average = total / serv->reactor_num;
+    if (target_id == reactor->id || thread->steal_load < SW_REACTOR_STEAL_MIN_EVENTS
+            || (uint64_t) thread->steal_load * 100 <= (uint64_t) average * SW_REACTOR_STEAL_FACTOR)
+    {
+        return;
+    }
+
+    //move half of the gap, or less, so that the target does not become the hot one
+    uint32_t budget = thread->steal_load - average;
+    if (average - min_load < budget)
+    {
+        budget = average - min_load;
+    }
+
+    int fd, max_fd = swServer_get_maxfd(serv), min_fd = swServer_get_minfd(serv);
+    swConnection *conn;
+    for (fd = min_fd; fd <= max_fd && budget > 0; fd++)
+    {
+        conn = &serv->connection_list[fd];
+        if (conn->steal_period != period || conn->steal_events == 0 || conn->steal_events > budget
+                || !swReactorThread_can_steal(reactor, conn))
+        {
+            continue;
+        }
+        if (swReactorThread_steal(reactor, conn, target_id) == SW_OK)
+        {
+            budget -= conn->steal_events;
+        }
+    }
+}
@@ -20,6 +20,7 @@
 #include "server.h"
 #include "http.h"
 #include "connection.h"
+#include "hash.h"
 #include <spawn.h>
 #include <sys/stat.h>
 #if __APPLE__
@@ -63,6 +64,26 @@ __thread swThreadG SwooleTG;
 int16_t sw_errno;
 char sw_error[SW_ERROR_MSG_SIZE];
 
+/**
+ * the reactor threads accept by themselves, the main reactor has id reactor_num
+ */
+static sw_inline int swServer_is_reactor_accept(swServer *serv, swReactor *reactor)
+{
+    return serv->accept_mode != SW_ACCEPT_MASTER && reactor->id < serv->reactor_num;
+}
+
+/**
+ * the listening socket of the reactor, reactor threads have their own sockets in SO_REUSEPORT mode
+ */
+static sw_inline int swServer_get_accept_socket(swListenPort *ls, swReactor *reactor)
+{
+    if (ls->reactor_socks && swServer_is_reactor_accept(SwooleG.serv, reactor))
+    {
+        return ls->reactor_socks[reactor->id];
+    }
+    return ls->sock;
+}
+
 static void swServer_disable_accept(swReactor *reactor)
 {
     swListenPort *ls;
@@ -74,13 +95,20 @@ static void swServer_disable_accept(swReactor *reactor)
         {
             continue;
         }
-        reactor->del(reactor, ls->sock);
+        reactor->del(reactor, swServer_get_accept_socket(ls, reactor));
     }
 }
 
 void swServer_enable_accept(swReactor *reactor)
 {
     swListenPort *ls;
+    int fdtype = SW_FD_LISTEN;
+
+    //the reactor threads share the listening socket, wake up only one of them
+    if (swServer_is_reactor_accept(SwooleG.serv, reactor) && SwooleG.serv->accept_mode == SW_ACCEPT_EXCLUSIVE)
+    {
+        fdtype = SW_FD_LISTEN | SW_EVENT_READ | SW_EVENT_EXCLUSIVE;
+    }
 
     LL_FOREACH(SwooleG.serv->listen_list, ls)
     {
@@ -89,7 +117,7 @@ void swServer_enable_accept(swReactor *reactor)
         {
             continue;
         }
-        reactor->add(reactor, ls->sock, SW_FD_LISTEN);
+        reactor->add(reactor, swServer_get_accept_socket(ls, reactor), fdtype);
     }
 }
 
@@ -118,8 +146,8 @@ int swServer_master_onAccept(swReactor *reactor, swEvent *event)
 
     int new_fd = 0, reactor_id = 0, i;
 
-    //SW_ACCEPT_AGAIN
-    for (i = 0; i < SW_ACCEPT_MAX_COUNT; i++)
+    //SW_ACCEPT_AGAIN, the budget of each wakeup keeps the ports fair
+    for (i = 0; i < listen_host->accept_batch; i++)
     {
 #ifdef HAVE_ACCEPT4
         new_fd = accept4(event->fd, (struct sockaddr *) &client_addr, &client_addrlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
@@ -137,8 +165,13 @@ int swServer_master_onAccept(swReactor *reactor, swEvent *event)
             default:
                 if (errno == EMFILE || errno == ENFILE)
                 {
+                    sw_atomic_fetch_add(&listen_host->emfile_count, 1);
                     swServer_disable_accept(reactor);
                     reactor->disable_accept = 1;
+                    if (swServer_is_reactor_accept(serv, reactor))
+                    {
+                        swServer_get_thread(serv, reactor->id)->accept_resume_time = swReactor_now(reactor) + 1;
+                    }
                 }
                 swoole_error_log(SW_LOG_ERROR, SW_ERROR_SYSTEM_CALL_FAIL, "accept() failed. Error: %s[%d]", strerror(errno), errno);
                 return SW_OK;
@@ -157,6 +190,7 @@ int swServer_master_onAccept(swReactor *reactor, swEvent *event)
         if (new_fd >= serv->max_connection)
         {
             swoole_error_log(SW_LOG_WARNING, SW_ERROR_SERVER_TOO_MANY_SOCKET, "Too many connections [now: %d].", new_fd);
+            sw_atomic_fetch_add(&listen_host->reject_count, 1);
             close(new_fd);
             return SW_OK;
         }
@@ -165,6 +199,11 @@ int swServer_master_onAccept(swReactor *reactor, swEvent *event)
         {
             reactor_id = 0;
         }
+        //accepted by the reactor thread, keep the connection in it
+        else if (serv->accept_mode != SW_ACCEPT_MASTER)
+        {
+            reactor_id = reactor->id;
+        }
         else
         {
             reactor_id = new_fd % serv->reactor_num;
@@ -181,6 +220,7 @@ int swServer_master_onAccept(swReactor *reactor, swEvent *event)
         {
             if (swSSL_create(conn, listen_host->ssl_context, 0) < 0)
             {
+                sw_atomic_fetch_add(&listen_host->reject_count, 1);
                 bzero(conn, sizeof(swConnection));
                 close(new_fd);
                 return SW_OK;
@@ -197,10 +237,12 @@ int swServer_master_onAccept(swReactor *reactor, swEvent *event)
         conn->connect_notify = 1;
         if (sub_reactor->add(sub_reactor, new_fd, SW_FD_TCP | SW_EVENT_WRITE) < 0)
         {
+            sw_atomic_fetch_add(&listen_host->reject_count, 1);
             bzero(conn, sizeof(swConnection));
             close(new_fd);
             return SW_OK;
         }
+        sw_atomic_fetch_add(&listen_host->accept_count, 1);
 
 #ifdef SW_ACCEPT_AGAIN
         continue;
@@ -228,10 +270,23 @@ static int swServer_start_check(swServer *serv)
     {
         serv->onPacket = serv->onReceive;
     }
-    //disable notice when use SW_DISPATCH_ROUND and SW_DISPATCH_QUEUE
+    //only the reactor threads can accept by themselves
+    if (serv->accept_mode != SW_ACCEPT_MASTER && serv->factory_mode != SW_MODE_PROCESS)
+    {
+        swWarn("accept_mode %d requires SWOOLE_PROCESS mode, use the default.", serv->accept_mode);
+        serv->accept_mode = SW_ACCEPT_MASTER;
+    }
+#ifndef HAVE_REUSEPORT
+    if (serv->accept_mode == SW_ACCEPT_REUSEPORT)
+    {
+        swWarn("SO_REUSEPORT is not supported, use SW_ACCEPT_EXCLUSIVE.");
+        serv->accept_mode = SW_ACCEPT_EXCLUSIVE;
+    }
+#endif
+    //disable notice when use SW_DISPATCH_ROUND, SW_DISPATCH_QUEUE, SW_DISPATCH_P2C and SW_DISPATCH_EWMA
     if (serv->factory_mode == SW_MODE_PROCESS)
     {
-        if (serv->dispatch_mode == SW_DISPATCH_ROUND || serv->dispatch_mode == SW_DISPATCH_QUEUE)
+        if (swServer_dispatch_unbound(serv))
         {
             if (!serv->enable_unsafe_event)
             {
@@ -259,6 +314,16 @@ static int swServer_start_check(swServer *serv)
             swWarn("serv->task_worker_num > %d, Too many processes, the system will be slow", SW_CPU_NUM * SW_MAX_WORKER_NCPU);
             serv->task_worker_num = SW_CPU_NUM * SW_MAX_WORKER_NCPU;
         }
+        //the reactor of the task worker reads the tasks from its own pipe
+        if (serv->task_enable_coroutine && serv->task_ipc_mode != SW_TASK_IPC_UNIXSOCK)
+        {
+            swWarn("task_enable_coroutine requires task_ipc_mode=1, disable it.");
+            serv->task_enable_coroutine = 0;
+        }
+        if (serv->task_max_concurrency == 0)
+        {
+            serv->task_max_concurrency = 1;
+        }
     }
     //check thread num
     if (serv->reactor_num > SW_CPU_NUM * SW_MAX_THREAD_NCPU)
@@ -274,6 +339,100 @@ static int swServer_start_check(swServer *serv)
     {
         serv->reactor_num = serv->worker_num;
     }
+    /**
+     * autoscaling, only the manager of SWOOLE_PROCESS starts and stops the workers,
+     * and the messages must not be bound to a worker
+     */
+    if (serv->min_worker_num > 0 && (serv->factory_mode != SW_MODE_PROCESS
+            || (serv->dispatch_mode != SW_DISPATCH_P2C && serv->dispatch_mode != SW_DISPATCH_EWMA)))
+    {
+        swWarn("min_worker_num requires SWOOLE_PROCESS mode and dispatch_mode=8/9, disable it.");
+        serv->min_worker_num = 0;
+    }
+    if (serv->min_worker_num >= serv->worker_num)
+    {
+        serv->min_worker_num = 0;
+    }
+    if (serv->task_min_worker_num > 0 && serv->factory_mode != SW_MODE_PROCESS)
+    {
+        swWarn("task_min_worker_num requires SWOOLE_PROCESS mode, disable it.");
+        serv->task_min_worker_num = 0;
+    }
+    if (serv->task_min_worker_num >= serv->task_worker_num)
+    {
+        serv->task_min_worker_num = 0;
+    }
+    //the rings only connect the reactor threads and the workers of SWOOLE_PROCESS
+    if (serv->ipc_mode == SW_IPC_RING && serv->factory_mode != SW_MODE_PROCESS)
+    {
+        serv->ipc_mode = SW_IPC_UNIXSOCK;
+    }
+    if (serv->ipc_ring_size < sizeof(swEventData) * 4)
+    {
+        serv->ipc_ring_size = sizeof(swEventData) * 4;
+    }
+    /**
+     * the io_uring reactors can not be driven by another thread,
+     * and the responses of SW_DISPATCH_STREAM are bound to the thread which opened the stream
+     */
+    if (serv->enable_reactor_steal && (serv->factory_mode != SW_MODE_PROCESS || serv->reactor_num < 2
+            || serv->reactor_num >= SW_CONNECTION_ROUTE_LOCKED || serv->io_uring_completion
+            || serv->dispatch_mode == SW_DISPATCH_STREAM))
+    {
+        swWarn("enable_reactor_steal requires SWOOLE_PROCESS mode with 2 or more reactor threads, without io_uring completion and dispatch_mode=7.");
+        serv->enable_reactor_steal = 0;
+    }
+    /**
+     * the completions are handled by the reactor threads, io_uring sends from the output buffer by itself
+     */
+    if (serv->zerocopy_threshold > 0)
+    {
+#if defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY)
+        if (serv->factory_mode != SW_MODE_PROCESS || serv->io_uring_completion)
+        {
+            swWarn("zerocopy_threshold requires SWOOLE_PROCESS mode without io_uring completion.");
+            serv->zerocopy_threshold = 0;
+        }
+        else if (serv->zerocopy_threshold < SW_ZEROCOPY_MIN_SIZE)
+        {
+            serv->zerocopy_threshold = SW_ZEROCOPY_MIN_SIZE;
+        }
+#else
+        swWarn("MSG_ZEROCOPY is not supported.");
+        serv->zerocopy_threshold = 0;
+#endif
+    }
+    /**
+     * the paused connections are resumed by the reactor threads, io_uring receives without waiting for the events
+     */
+    if (serv->output_memory_high_watermark > 0)
+    {
+        if (serv->factory_mode != SW_MODE_PROCESS || serv->io_uring_completion)
+        {
+            swWarn("output_memory_high_watermark requires SWOOLE_PROCESS mode without io_uring completion.");
+            serv->output_memory_high_watermark = 0;
+        }
+        else if (serv->output_memory_low_watermark == 0 || serv->output_memory_low_watermark > serv->output_memory_high_watermark)
+        {
+            serv->output_memory_low_watermark = serv->output_memory_high_watermark / 100 * SW_OUTPUT_MEMORY_LOW_WATERMARK;
+        }
+    }
+    /**
+     * the reactor threads choose the target workers of the datagrams
+     */
+    if (serv->enable_udp_batch)
+    {
+#if defined(HAVE_RECVMMSG) && defined(HAVE_SENDMMSG)
+        if (serv->factory_mode != SW_MODE_PROCESS && serv->factory_mode != SW_MODE_BASE)
+        {
+            swWarn("enable_udp_batch requires SWOOLE_PROCESS or SWOOLE_BASE mode.");
+            serv->enable_udp_batch = 0;
+        }
+#else
+        swWarn("recvmmsg/sendmmsg is not supported.");
+        serv->enable_udp_batch = 0;
+#endif
+    }
     if (SwooleG.max_sockets > 0 && serv->max_connection > SwooleG.max_sockets)
     {
         swWarn("serv->max_connection is exceed the maximum value[%d].", SwooleG.max_sockets);
@@ -347,6 +506,13 @@ static int swServer_start_proxy(swServer *serv)
         {
             continue;
         }
+#ifdef HAVE_REUSEPORT
+        if (serv->accept_mode == SW_ACCEPT_REUSEPORT && (ls->type == SW_SOCK_TCP || ls->type == SW_SOCK_TCP6)
+                && swReactorThread_reuse_port(serv, ls) < 0)
+        {
+            return SW_ERR;
+        }
+#endif
         if (swPort_listen(ls) < 0)
         {
             return SW_ERR;
@@ -544,32 +710,248 @@ int swServer_create_task_worker(swServer *serv)
     return SW_OK;
 }
 
-int swServer_worker_init(swServer *serv, swWorker *worker)
+/**
+ * SW_IPC_RING, must be created before the workers are forked
+ */
+int swServer_create_ipc_ring(swServer *serv)
 {
-#ifdef HAVE_CPU_AFFINITY
-    if (serv->open_cpu_affinity)
+    int i, n = serv->worker_num * serv->reactor_num;
+
+    serv->request_rings = SwooleG.memory_pool->alloc(SwooleG.memory_pool, n * sizeof(swShmRing *) * 2);
+    serv->worker_doorbells = SwooleG.memory_pool->alloc(SwooleG.memory_pool, (serv->worker_num + serv->reactor_num) * sizeof(swDoorbell));
+    if (serv->request_rings == NULL || serv->worker_doorbells == NULL)
     {
-        cpu_set_t cpu_set;
-        CPU_ZERO(&cpu_set);
-        if (serv->cpu_affinity_available_num)
+        swWarn("[Master] alloc for ipc rings failed.");
+        return SW_ERR;
+    }
+    serv->response_rings = serv->request_rings + n;
+    serv->reactor_doorbells = serv->worker_doorbells + serv->worker_num;
+
+    for (i = 0; i < n * 2; i++)
+    {
+        serv->request_rings[i] = swShmRing_new(serv->ipc_ring_size);
+        if (serv->request_rings[i] == NULL)
         {
-            CPU_SET(serv->cpu_affinity_available[SwooleWG.id % serv->cpu_affinity_available_num], &cpu_set);
+            return SW_ERR;
         }
-        else
+    }
+    for (i = 0; i < serv->worker_num + serv->reactor_num; i++)
+    {
+        if (swDoorbell_create(&serv->worker_doorbells[i]) < 0)
         {
-            CPU_SET(SwooleWG.id % SW_CPU_NUM, &cpu_set);
+            return SW_ERR;
         }
-#ifdef __FreeBSD__
-        if (cpuset_setaffinity(CPU_LEVEL_WHICH, CPU_WHICH_PID, -1,
-                                sizeof(cpu_set), &cpu_set) < 0)
+    }
+    return SW_OK;
+}
+
+void swServer_free_ipc_ring(swServer *serv)
+{
+    int i;
+    if (serv->request_rings == NULL)
+    {
+        return;
+    }
+    for (i = 0; i < serv->worker_num * serv->reactor_num * 2; i++)
+    {
+        if (serv->request_rings[i])
+        {
+            swShmRing_free(serv->request_rings[i]);
+        }
+    }
+    for (i = 0; i < serv->worker_num + serv->reactor_num; i++)
+    {
+        if (serv->worker_doorbells[i].pipe.object)
+        {
+            swDoorbell_free(&serv->worker_doorbells[i]);
+        }
+    }
+    serv->request_rings = serv->response_rings = NULL;
+}
+
+/**
+ * the data goes to the overflow buffer when the ring is full, and keeps the order after that
+ */
+int swServer_ring_push(swShmRing *ring, swBuffer **overflow, swDoorbell *consumer, void *data, uint32_t length)
+{
+    swBuffer *buffer = *overflow;
+    if (buffer && !swBuffer_empty(buffer))
+    {
+        goto append_buffer;
+    }
+    if (swShmRing_push(ring, data, length) == SW_OK)
+    {
+        swDoorbell_ring(consumer);
+        return SW_OK;
+    }
+    //the consumer may free some space in the meantime, pairs with swServer_ring_release
+    ring->waiting = 1;
+    sw_atomic_memory_barrier();
+    if (swShmRing_push(ring, data, length) == SW_OK)
+    {
+        swDoorbell_ring(consumer);
+        return SW_OK;
+    }
+    if (buffer == NULL)
+    {
+        buffer = *overflow = swBuffer_new(0);
+        if (buffer == NULL)
+        {
+            return SW_ERR;
+        }
+    }
+
+    append_buffer:
+    if (swBuffer_append(buffer, data, length) < 0)
+    {
+        swWarn("append to the ring buffer failed.");
+        return SW_ERR;
+    }
+    swDoorbell_ring(consumer);
+    return SW_OK;
+}
+
+/**
+ * move the overflow buffer into the ring, SW_ERR if the ring is full again
+ */
+int swServer_ring_flush(swShmRing *ring, swBuffer *overflow, swDoorbell *consumer)
+{
+    int n = 0;
+    swBuffer_chunk *chunk;
+
+    while (!swBuffer_empty(overflow))
+    {
+        chunk = swBuffer_get_chunk(overflow);
+        if (swShmRing_push(ring, chunk->store.ptr, chunk->length) < 0)
+        {
+            ring->waiting = 1;
+            sw_atomic_memory_barrier();
+            if (swShmRing_push(ring, chunk->store.ptr, chunk->length) < 0)
+            {
+                break;
+            }
+        }
+        swBuffer_pop_chunk(overflow, chunk);
+        n++;
+    }
+    if (n > 0)
+    {
+        swDoorbell_ring(consumer);
+    }
+    return swBuffer_empty(overflow) ? SW_OK : SW_ERR;
+}
+
+/**
+ * the cpu of the reactor thread or worker, -1 if it is not pinned
+ */
+int swServer_get_affinity_cpu(swServer *serv, int *cpu_set, int cpu_set_num, int id)
+{
+    if (cpu_set_num > 0)
+    {
+        return cpu_set[id % cpu_set_num];
+    }
+    if (!serv->open_cpu_affinity)
+    {
+        return SW_ERR;
+    }
+    if (serv->cpu_affinity_available_num)
+    {
+        return serv->cpu_affinity_available[id % serv->cpu_affinity_available_num];
+    }
+    return id % SW_CPU_NUM;
+}
+
+/**
+ * pin the calling thread, returns the NUMA node of the cpu
+ */
+int swServer_set_cpu_affinity(swServer *serv, int *cpu_set, int cpu_set_num, int id)
+{
+#ifdef HAVE_CPU_AFFINITY
+    int cpu = swServer_get_affinity_cpu(serv, cpu_set, cpu_set_num, id);
+    if (cpu < 0)
+    {
+        return SW_ERR;
+    }
+
+    cpu_set_t _cpu_set;
+    CPU_ZERO(&_cpu_set);
+    CPU_SET(cpu, &_cpu_set);
+    if (0 != pthread_setaffinity_np(pthread_self(), sizeof(_cpu_set), &_cpu_set))
+    {
+        swSysError("pthread_setaffinity_np(%d) failed.", cpu);
+        return SW_ERR;
+    }
+    return swoole_get_numa_node();
 #else
-        if (sched_setaffinity(getpid(), sizeof(cpu_set), &cpu_set) < 0)
+    return SW_ERR;
 #endif
+}
+
+/**
+ * run on all the cpus of the NUMA node, returns the node
+ */
+static int swServer_set_node_affinity(int node)
+{
+#ifdef HAVE_CPU_AFFINITY
+    cpu_set_t _cpu_set;
+    int cpu, n = 0;
+
+    if (node < 0)
+    {
+        return SW_ERR;
+    }
+    CPU_ZERO(&_cpu_set);
+    for (cpu = 0; cpu < SW_CPU_NUM && cpu < CPU_SETSIZE; cpu++)
+    {
+        if (swoole_get_cpu_numa_node(cpu) == node)
         {
-            swSysError("sched_setaffinity() failed.");
+            CPU_SET(cpu, &_cpu_set);
+            n++;
         }
     }
+    if (n == 0)
+    {
+        return SW_ERR;
+    }
+    if (0 != pthread_setaffinity_np(pthread_self(), sizeof(_cpu_set), &_cpu_set))
+    {
+        swSysError("pthread_setaffinity_np(node=%d) failed.", node);
+        return SW_ERR;
+    }
+    return node;
+#else
+    return SW_ERR;
 #endif
+}
+
+int swServer_worker_init(swServer *serv, swWorker *worker)
+{
+    int node = swServer_set_cpu_affinity(serv, serv->worker_cpu_set, serv->worker_cpu_set_num, SwooleWG.id);
+    /**
+     * the worker is not pinned, but the reactor thread reading its pipe is,
+     * keep the pair on one node
+     */
+    if (node < 0 && serv->factory_mode == SW_MODE_PROCESS && serv->reactor_cpu_set_num > 0 && !serv->open_cpu_affinity)
+    {
+        int reactor_id = SwooleWG.id % serv->reactor_num;
+        node = swServer_set_node_affinity(swoole_get_cpu_numa_node(serv->reactor_cpu_set[reactor_id % serv->reactor_cpu_set_num]));
+    }
+    //the memory written by the worker
+    if (node >= 0 && serv->factory_mode == SW_MODE_PROCESS)
+    {
+        if (worker->send_shm)
+        {
+            sw_shm_bind(worker->send_shm, node);
+        }
+        if (serv->response_rings)
+        {
+            int i;
+            for (i = 0; i < serv->reactor_num; i++)
+            {
+                sw_shm_bind(swServer_get_response_ring(serv, SwooleWG.id, i), node);
+            }
+        }
+    }
 
     //signal init
     swWorker_signal_init();
@@ -728,6 +1110,11 @@ int swServer_start(swServer *serv)
         serv->gs->event_workers.workers[i].pool = &serv->gs->event_workers;
     }
 
+    if (serv->dispatch_mode == SW_DISPATCH_CHASH && swServer_create_hash_ring(serv) < 0)
+    {
+        return SW_ERR;
+    }
+
 #ifdef SW_USE_RINGBUFFER
     for (i = 0; i < serv->reactor_num; i++)
     {
@@ -755,6 +1142,19 @@ int swServer_start(swServer *serv)
         }
     }
 
+    /**
+     * the large task payloads are released by the receiver, create it before fork
+     */
+    if (serv->task_pool_size > 0)
+    {
+        serv->task_pool = swSlabPool_new(serv->task_pool_size, SW_TASK_POOL_PAGE_SIZE);
+        if (serv->task_pool == NULL)
+        {
+            swError("create task_pool failed.");
+            return SW_ERR;
+        }
+    }
+
     /**
      * user worker process
      */
@@ -814,6 +1214,9 @@ void swServer_init(swServer *serv)
     serv->reactor_num = SW_REACTOR_NUM > SW_REACTOR_MAX_THREAD ? SW_REACTOR_MAX_THREAD : SW_REACTOR_NUM;
 
     serv->dispatch_mode = SW_DISPATCH_FDMOD;
+    serv->accept_mode = SW_ACCEPT_MASTER;
+    serv->ipc_mode = SW_IPC_UNIXSOCK;
+    serv->ipc_ring_size = SW_IPC_RING_SIZE;
 
     serv->worker_num = SW_CPU_NUM;
     serv->max_connection = SwooleG.max_sockets < SW_SESSION_LIST_SIZE ? SwooleG.max_sockets : SW_SESSION_LIST_SIZE;
@@ -835,6 +1238,7 @@ void swServer_init(swServer *serv)
     serv->buffer_output_size = SW_BUFFER_OUTPUT_SIZE;
 
     serv->task_ipc_mode = SW_TASK_IPC_UNIXSOCK;
+    serv->task_max_concurrency = SW_TASK_MAX_CONCURRENCY;
 
     /**
      * alloc shared memory
@@ -962,6 +1366,11 @@ int swServer_free(swServer *serv)
         unlink(serv->stream_socket);
         sw_free(serv->stream_socket);
     }
+    if (serv->hash_ring)
+    {
+        sw_free(serv->hash_ring);
+        serv->hash_ring = NULL;
+    }
     if (serv->gs->start > 0 && serv->onShutdown != NULL)
     {
         serv->onShutdown(serv);
@@ -969,6 +1378,89 @@ int swServer_free(swServer *serv)
     return SW_OK;
 }
 
+static int swServer_hash_ring_compare(const void *a, const void *b)
+{
+    uint32_t x = ((swHashRing_node *) a)->hash;
+    uint32_t y = ((swHashRing_node *) b)->hash;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static sw_inline uint32_t swServer_hash_ring_key(uint32_t a, uint32_t b)
+{
+    uint32_t key[2] = {a, b};
+    return (uint32_t) swoole_hash_jenkins((char *) key, sizeof(key));
+}
+
+/**
+ * the virtual nodes only depend on the worker id,
+ * so a different worker_num only moves the keys from or to the added or removed workers.
+ */
+int swServer_create_hash_ring(swServer *serv)
+{
+    uint32_t n = serv->worker_num * SW_WORKER_HASH_VNODES;
+    serv->hash_ring = sw_malloc(n * sizeof(swHashRing_node));
+    if (serv->hash_ring == NULL)
+    {
+        swWarn("malloc[hash_ring] failed.");
+        return SW_ERR;
+    }
+
+    uint32_t i, j;
+    for (i = 0; i < serv->worker_num; i++)
+    {
+        for (j = 0; j < SW_WORKER_HASH_VNODES; j++)
+        {
+            serv->hash_ring[i * SW_WORKER_HASH_VNODES + j].hash = swServer_hash_ring_key(i, j);
+            serv->hash_ring[i * SW_WORKER_HASH_VNODES + j].worker_id = i;
+        }
+    }
+    qsort(serv->hash_ring, n, sizeof(swHashRing_node), swServer_hash_ring_compare);
+    serv->hash_ring_size = n;
+    return SW_OK;
+}
+
+/**
+ * consistent hashing with bounded loads:
+ * walk clockwise from the key until a worker is below SW_WORKER_HASH_LOAD_FACTOR% of the average load.
+ * the key stays on its worker only while the worker is not overloaded, the spilled messages go to the next ones,
+ * so the state of a connection must not be kept in the worker memory.
+ */
+int swServer_worker_schedule_chash(swServer *serv, uint32_t key)
+{
+    uint32_t hash = swServer_hash_ring_key(key, UINT32_MAX);
+    swHashRing_node *ring = serv->hash_ring;
+
+    //the first node with ring[i].hash >= hash
+    uint32_t low = 0, high = serv->hash_ring_size;
+    while (low < high)
+    {
+        uint32_t mid = low + (high - low) / 2;
+        if (ring[mid].hash < hash)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    int32_t total = (int32_t) (serv->gs->dispatch_count - serv->gs->finish_count);
+    uint64_t capacity = (uint64_t) (total > 0 ? total + 1 : 1) * SW_WORKER_HASH_LOAD_FACTOR;
+    uint64_t bound = (capacity + 100 * serv->worker_num - 1) / (100 * serv->worker_num);
+
+    uint32_t i, pos;
+    for (i = 0; i < serv->hash_ring_size; i++)
+    {
+        pos = (low + i) % serv->hash_ring_size;
+        if (swServer_worker_load(serv, &serv->workers[ring[pos].worker_id]) < bound)
+        {
+            return ring[pos].worker_id;
+        }
+    }
+    return ring[low % serv->hash_ring_size].worker_id;
+}
+
 int swServer_udp_send(swServer *serv, swSendData *resp)
 {
     struct sockaddr_in addr_in;
@@ -1011,7 +1503,13 @@ int swServer_tcp_feedback(swServer *serv, int fd, int event)
 
     if (serv->factory_mode == SW_MODE_PROCESS)
     {
-        return swWorker_send2reactor((swEventData *) &_send.info, sizeof(_send.info), fd);
+        _send.info.from_id = swServer_connection_route_acquire(serv, conn);
+        if (swWorker_send2reactor((swEventData *) &_send.info, sizeof(_send.info), fd) < 0)
+        {
+            swServer_connection_route_release(serv, conn);
+            return SW_ERR;
+        }
+        return SW_OK;
     }
     else
     {
@@ -1220,12 +1718,21 @@ int swServer_tcp_close(swServer *serv, int fd, int reset)
     int ret;
     if (!swIsWorker())
     {
-        swWorker *worker = swServer_get_worker(serv, conn->fd % serv->worker_num);
+        swWorker *worker = swServer_get_worker(serv, conn->fd % swServer_run_worker_num(serv));
         swDataHead ev;
         ev.type = SW_EVENT_CLOSE;
         ev.fd = fd;
         ev.from_id = conn->from_id;
+        //released by the worker like the messages from the reactor threads
+        if (serv->enable_reactor_steal)
+        {
+            sw_atomic_fetch_add(&conn->route, 1);
+        }
         ret = swWorker_send2worker(worker, &ev, sizeof(ev), SW_PIPE_MASTER);
+        if (ret < 0)
+        {
+            swServer_connection_route_release(serv, conn);
+        }
     }
     else
     {
@@ -1671,7 +2178,11 @@ static void swServer_signal_hanlder(int sig)
             for (i = 0; i < SwooleG.serv->worker_num + serv->task_worker_num + SwooleG.serv->user_worker_num; i++)
             {
                 worker = swServer_get_worker(SwooleG.serv, i);
-                kill(worker->pid, SIGRTMIN);
+                //stopped by the autoscaling
+                if (worker->pid > 0)
+                {
+                    kill(worker->pid, SIGRTMIN);
+                }
             }
             if (SwooleG.serv->factory_mode == SW_MODE_PROCESS)
             {
@@ -1783,13 +2294,19 @@ static swConnection* swServer_connection_new(swServer *serv, swListenPort *ls, i
 {
     swConnection* connection = NULL;
 
-    serv->stats->accept_count++;
+    sw_atomic_fetch_add(&serv->stats->accept_count, 1);
     sw_atomic_fetch_add(&serv->stats->connection_num, 1);
     sw_atomic_fetch_add(&ls->connection_num, 1);
 
     if (fd > swServer_get_maxfd(serv))
     {
-        swServer_set_maxfd(serv, fd);
+        //the reactor threads may accept at the same time
+        sw_spinlock(&serv->gs->spinlock);
+        if (fd > swServer_get_maxfd(serv))
+        {
+            swServer_set_maxfd(serv, fd);
+        }
+        sw_spinlock_release(&serv->gs->spinlock);
     }
 
     connection = &(serv->connection_list[fd]);
@@ -1806,6 +2323,15 @@ static swConnection* swServer_connection_new(swServer *serv, swListenPort *ls, i
         connection->tcp_nodelay = 1;
     }
 
+#if defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY)
+    //large responses are sent with MSG_ZEROCOPY, SSL encrypts into its own buffer
+    if (serv->zerocopy_threshold > 0 && !ls->ssl && (ls->type == SW_SOCK_TCP || ls->type == SW_SOCK_TCP6))
+    {
+        int sockopt = 1;
+        connection->zerocopy = setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &sockopt, sizeof(sockopt)) == 0;
+    }
+#endif
+
     //socket recv buffer size
     if (ls->kernel_socket_recv_buffer_size > 0)
     {
@@ -1826,6 +2352,7 @@ static swConnection* swServer_connection_new(swServer *serv, swListenPort *ls, i
 
     connection->fd = fd;
     connection->from_id = serv->factory_mode == SW_MODE_SINGLE ? SwooleWG.id : reactor_id;
+    connection->route = (uint32_t) connection->from_id << SW_CONNECTION_ROUTE_SHIFT;
     connection->from_fd = (sw_atomic_t) from_fd;
     connection->connect_time = serv->gs->now;
     connection->last_time = serv->gs->now;
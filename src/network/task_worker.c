@@ -18,8 +18,21 @@
 #include "server.h"
 
 static swEventData *current_task = NULL;
+/**
+ * the results of a SW_TASK_BATCH message
+ */
+static swEventData *batch_result = NULL;
+/**
+ * task_enable_coroutine, the tasks of this worker that are not done yet
+ */
+static uint32_t task_running_num = 0;
+static uint8_t task_paused = 0;
+static uint8_t task_exiting = 0;
+static int task_max_request = 0;
 
 static void swTaskWorker_signal_init(void);
+static int swTaskWorker_loop_async(swProcessPool *pool, swWorker *worker);
+static void swTaskWorker_pause(void);
 
 void swTaskWorker_init(swProcessPool *pool)
 {
@@ -36,6 +49,10 @@ void swTaskWorker_init(swProcessPool *pool)
     {
         pool->dispatch_mode = SW_DISPATCH_QUEUE;
     }
+    if (serv->task_enable_coroutine)
+    {
+        pool->main_loop = swTaskWorker_loop_async;
+    }
 }
 
 /**
@@ -52,7 +69,149 @@ int swTaskWorker_onFinish(swReactor *reactor, swEvent *event)
         n = read(event->fd, &task, sizeof(task));
     } while (n < 0 && errno == EINTR);
 
-    return serv->onFinish(serv, &task);
+    return swTaskWorker_finish_dispatch(serv, &task);
+}
+
+int swTaskWorker_finish_dispatch(swServer *serv, swEventData *task)
+{
+    if (swTask_type(task) & SW_TASK_BATCH)
+    {
+        return swTaskWorker_batch_foreach(serv, task, serv->onFinish);
+    }
+    return serv->onFinish(serv, task);
+}
+
+/**
+ * append a packed task or result, fails if the batch is full
+ */
+int swTaskWorker_batch_append(swEventData *batch, swEventData *task)
+{
+    uint32_t length = sizeof(task->info) + task->info.len;
+    if (batch->info.len + length > sizeof(batch->data))
+    {
+        return SW_ERR;
+    }
+    memcpy(batch->data + batch->info.len, task, length);
+    batch->info.len += length;
+    return SW_OK;
+}
+
+int swTaskWorker_batch_foreach(swServer *serv, swEventData *batch, int (*callback)(swServer *, swEventData *))
+{
+    swEventData task;
+    uint32_t offset = 0;
+    uint32_t length;
+
+    while (offset + sizeof(task.info) <= batch->info.len)
+    {
+        memcpy(&task.info, batch->data + offset, sizeof(task.info));
+        length = sizeof(task.info) + task.info.len;
+        if (offset + length > batch->info.len)
+        {
+            swWarn("bad task batch, offset=%d, length=%d.", offset, batch->info.len);
+            return SW_ERR;
+        }
+        memcpy(task.data, batch->data + offset + sizeof(task.info), task.info.len);
+        callback(serv, &task);
+        offset += length;
+    }
+    return SW_OK;
+}
+
+static int swTaskWorker_batch_flush(swServer *serv)
+{
+    swWorker *worker = swServer_get_worker(serv, batch_result->info.from_id);
+    if (batch_result->info.len == 0 || worker == NULL)
+    {
+        return SW_OK;
+    }
+    int ret = swWorker_send2worker(worker, batch_result, sizeof(batch_result->info) + batch_result->info.len, SW_PIPE_MASTER);
+    batch_result->info.len = 0;
+    return ret;
+}
+
+/**
+ * drop the task if the caller has given up on it,
+ * the caller still waits for the result of a task with callback to release the callback.
+ * onTask returns SW_ERR if the task is not started, it is done at once
+ */
+static int swTaskWorker_call(swServer *serv, swEventData *task)
+{
+    if (swTask_type(task) & SW_TASK_DEADLINE && swoole_monotonic_usec() > swTask_get_deadline(task))
+    {
+        sw_atomic_fetch_sub(&serv->stats->tasking_num, 1);
+        sw_atomic_fetch_add(&serv->stats->task_expired_count, 1);
+        if (swTask_type(task) & SW_TASK_TMPFILE)
+        {
+            swTaskWorker_large_free(task);
+        }
+        if ((swTask_type(task) & SW_TASK_NONBLOCK) && (swTask_type(task) & SW_TASK_CALLBACK))
+        {
+            return swTaskWorker_finish_task(serv, task, "", 0, SW_TASK_EXPIRED);
+        }
+        return SW_OK;
+    }
+    if (serv->task_enable_coroutine)
+    {
+        task_running_num++;
+        sw_atomic_fetch_add(&serv->stats->task_running_num, 1);
+        if (task_running_num >= serv->task_max_concurrency)
+        {
+            swTaskWorker_pause();
+        }
+    }
+    int ret = serv->onTask(serv, task);
+    if (ret < 0 && serv->task_enable_coroutine)
+    {
+        swTaskWorker_done(serv);
+    }
+    return ret;
+}
+
+/**
+ * stop reading, the other task workers are preferred while this one is busy
+ */
+static void swTaskWorker_pause(void)
+{
+    if (!task_paused)
+    {
+        SwooleG.main_reactor->del(SwooleG.main_reactor, SwooleWG.worker->pipe_worker);
+        task_paused = 1;
+    }
+    SwooleWG.worker->status = SW_WORKER_BUSY;
+}
+
+/**
+ * task_enable_coroutine, must be called once for each task when it is done
+ */
+void swTaskWorker_done(swServer *serv)
+{
+    if (task_running_num == 0)
+    {
+        return;
+    }
+    task_running_num--;
+    sw_atomic_fetch_sub(&serv->stats->task_running_num, 1);
+
+    if (task_exiting)
+    {
+        if (task_running_num == 0)
+        {
+            SwooleG.main_reactor->running = 0;
+        }
+    }
+    else if (task_paused && task_running_num < serv->task_max_concurrency)
+    {
+        SwooleG.main_reactor->add(SwooleG.main_reactor, SwooleWG.worker->pipe_worker, SW_FD_PIPE | SW_EVENT_READ);
+        SwooleWG.worker->status = SW_WORKER_IDLE;
+        task_paused = 0;
+    }
+}
+
+static int swTaskWorker_batch_onTask(swServer *serv, swEventData *task)
+{
+    current_task = task;
+    return swTaskWorker_call(serv, task);
 }
 
 int swTaskWorker_onTask(swProcessPool *pool, swEventData *task)
@@ -65,9 +224,28 @@ int swTaskWorker_onTask(swProcessPool *pool, swEventData *task)
     {
         serv->onPipeMessage(serv, task);
     }
+    else if (swTask_type(task) & SW_TASK_BATCH)
+    {
+        //the results are sent back together
+        swEventData result;
+        result.info.type = SW_EVENT_FINISH;
+        result.info.fd = task->info.fd;
+        result.info.from_id = task->info.from_id;
+        result.info.len = 0;
+        swTask_type(&result) = SW_TASK_BATCH;
+        batch_result = &result;
+
+        ret = swTaskWorker_batch_foreach(serv, task, swTaskWorker_batch_onTask);
+        if (swTaskWorker_batch_flush(serv) < 0)
+        {
+            swWarn("TaskWorker: send result to worker failed. Error: %s[%d]", strerror(errno), errno);
+        }
+        batch_result = NULL;
+        current_task = task;
+    }
     else
     {
-        ret = serv->onTask(serv, task);
+        ret = swTaskWorker_call(serv, task);
     }
 
     return ret;
@@ -78,6 +256,20 @@ int swTaskWorker_large_pack(swEventData *task, void *data, int data_len)
     swPackage_task pkg;
     bzero(&pkg, sizeof(pkg));
 
+    //copy to the shared memory, fall back to tmp file if the pool is full
+    swServer *serv = SwooleG.serv;
+    if (serv && serv->task_pool)
+    {
+        sw_spinlock(&serv->gs->task_pool_lock);
+        pkg.data = serv->task_pool->alloc(serv->task_pool, data_len);
+        sw_spinlock_release(&serv->gs->task_pool_lock);
+        if (pkg.data)
+        {
+            memcpy(pkg.data, data, data_len);
+            goto _pack;
+        }
+    }
+
     memcpy(pkg.tmpfile, SwooleG.task_tmpdir, SwooleG.task_tmpdir_len);
 
     //create temp file
@@ -91,19 +283,38 @@ int swTaskWorker_large_pack(swEventData *task, void *data, int data_len)
     if (swoole_sync_writefile(tmp_fd, data, data_len) <= 0)
     {
         swWarn("write to tmpfile failed.");
+        close(tmp_fd);
         return SW_ERR;
     }
+    close(tmp_fd);
 
+    _pack:
     task->info.len = sizeof(swPackage_task);
     //use tmp file
     swTask_type(task) |= SW_TASK_TMPFILE;
 
     pkg.length = data_len;
     memcpy(task->data, &pkg, sizeof(swPackage_task));
-    close(tmp_fd);
     return SW_OK;
 }
 
+/**
+ * release the data of a task that is not unpacked
+ */
+void swTaskWorker_large_free(swEventData *task)
+{
+    swPackage_task pkg;
+    memcpy(&pkg, task->data, sizeof(pkg));
+    if (pkg.data)
+    {
+        SwooleG.serv->task_pool->free(SwooleG.serv->task_pool, pkg.data);
+    }
+    else
+    {
+        unlink(pkg.tmpfile);
+    }
+}
+
 static void swTaskWorker_signal_init(void)
 {
     swSignal_set(SIGHUP, NULL, 1, 0);
@@ -117,6 +328,86 @@ static void swTaskWorker_signal_init(void)
 #endif
 }
 
+/**
+ * task_enable_coroutine, read the tasks in the reactor
+ */
+static int swTaskWorker_onPipeReceive(swReactor *reactor, swEvent *event)
+{
+    swServer *serv = reactor->ptr;
+    swEventData task;
+    int n;
+
+    do
+    {
+        n = read(event->fd, &task, sizeof(task));
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0)
+    {
+        if (errno != EAGAIN)
+        {
+            swSysError("[Worker#%d] read(%d) failed.", SwooleWG.id, event->fd);
+        }
+        return SW_OK;
+    }
+
+    swTaskWorker_onTask(&serv->gs->task_workers, &task);
+    //the coroutines keep the header of the task by themselves
+    current_task = NULL;
+
+    //exit after the tasks in flight are done
+    if (task_max_request > 0 && ++SwooleWG.worker->request_count >= task_max_request && !task_exiting)
+    {
+        swTaskWorker_pause();
+        task_exiting = 1;
+        if (task_running_num == 0)
+        {
+            reactor->running = 0;
+        }
+    }
+    return SW_OK;
+}
+
+static void swTaskWorker_onTimeout(swTimer *timer, swTimer_node *tnode)
+{
+    swWarn("[Worker#%d] %d tasks are not done in %d seconds.", SwooleWG.id, task_running_num, SwooleG.serv->max_wait_time);
+    SwooleG.main_reactor->running = 0;
+}
+
+static int swTaskWorker_loop_async(swProcessPool *pool, swWorker *worker)
+{
+    swServer *serv = pool->ptr;
+    swReactor *reactor = SwooleG.main_reactor;
+    int pipe_worker = worker->pipe_worker;
+
+    task_max_request = pool->max_request;
+    if (task_max_request > 10)
+    {
+        task_max_request += swoole_system_random(1, task_max_request / 2);
+    }
+
+    swSetNonBlock(pipe_worker);
+    reactor->ptr = serv;
+    reactor->add(reactor, pipe_worker, SW_FD_PIPE | SW_EVENT_READ);
+    reactor->setHandle(reactor, SW_FD_PIPE, swTaskWorker_onPipeReceive);
+    reactor->wait(reactor, NULL);
+
+    //stopped by the signal, wait for the tasks in flight
+    if (task_running_num > 0 && !task_exiting)
+    {
+        swTaskWorker_pause();
+        task_exiting = 1;
+        if (SwooleG.timer.fd == 0)
+        {
+            swTimer_init(serv->max_wait_time * 1000);
+        }
+        SwooleG.timer.add(&SwooleG.timer, serv->max_wait_time * 1000, 0, NULL, swTaskWorker_onTimeout);
+        reactor->running = 1;
+        reactor->wait(reactor, NULL);
+    }
+    return SW_OK;
+}
+
 void swTaskWorker_onStart(swProcessPool *pool, int worker_id)
 {
     swServer *serv = pool->ptr;
@@ -128,9 +419,31 @@ void swTaskWorker_onStart(swProcessPool *pool, int worker_id)
     swServer_close_port(serv, SW_TRUE);
 
     swTaskWorker_signal_init();
+    //task workers are only pinned to an explicit cpu set
+    if (serv->task_worker_cpu_set_num > 0)
+    {
+        swServer_set_cpu_affinity(serv, serv->task_worker_cpu_set, serv->task_worker_cpu_set_num, worker_id - serv->worker_num);
+    }
+    //the reactor of the master process is not used, the new one is created after the ports are closed
+    SwooleG.main_reactor = NULL;
+    if (serv->task_enable_coroutine)
+    {
+        SwooleG.main_reactor = sw_malloc(sizeof(swReactor));
+        if (SwooleG.main_reactor == NULL)
+        {
+            swError("[TaskWorker] malloc for reactor failed.");
+        }
+        if (swReactor_create(SwooleG.main_reactor, SW_REACTOR_MAXEVENTS) < 0)
+        {
+            swError("[TaskWorker] create reactor failed.");
+        }
+    }
     swWorker_onStart(serv);
 
-    SwooleG.main_reactor = NULL;
+    if (!serv->task_enable_coroutine)
+    {
+        SwooleG.main_reactor = NULL;
+    }
     swWorker *worker = swProcessPool_get_worker(pool, worker_id);
     worker->start_time = serv->gs->now;
     worker->request_count = 0;
@@ -149,9 +462,17 @@ void swTaskWorker_onStop(swProcessPool *pool, int worker_id)
  * Send the task result to worker
  */
 int swTaskWorker_finish(swServer *serv, char *data, int data_len, int flags)
+{
+    return swTaskWorker_finish_task(serv, current_task, data, data_len, flags);
+}
+
+/**
+ * only the header of the task is used, it is saved by the coroutine of task_enable_coroutine
+ */
+int swTaskWorker_finish_task(swServer *serv, swEventData *task, char *data, int data_len, int flags)
 {
     swEventData buf;
-    if (!current_task)
+    if (!task)
     {
         swWarn("cannot use finish in worker");
         return SW_ERR;
@@ -161,13 +482,13 @@ int swTaskWorker_finish(swServer *serv, char *data, int data_len, int flags)
         swWarn("cannot use task/finish, because no set serv->task_worker_num.");
         return SW_ERR;
     }
-	if (current_task->info.type == SW_EVENT_PIPE_MESSAGE)
+	if (task->info.type == SW_EVENT_PIPE_MESSAGE)
 	{
 		swWarn("task/finish is not supported in onPipeMessage callback.");
 		return SW_ERR;
 	}
 
-    uint16_t source_worker_id = current_task->info.from_id;
+    uint16_t source_worker_id = task->info.from_id;
     swWorker *worker = swServer_get_worker(serv, source_worker_id);
 
     if (worker == NULL)
@@ -178,16 +499,16 @@ int swTaskWorker_finish(swServer *serv, char *data, int data_len, int flags)
 
     int ret;
     //for swoole_server_task
-    if (swTask_type(current_task) & SW_TASK_NONBLOCK)
+    if (swTask_type(task) & SW_TASK_NONBLOCK)
     {
         buf.info.type = SW_EVENT_FINISH;
-        buf.info.fd = current_task->info.fd;
+        buf.info.fd = task->info.fd;
         //callback function
-        if (swTask_type(current_task) & SW_TASK_CALLBACK)
+        if (swTask_type(task) & SW_TASK_CALLBACK)
         {
             flags |= SW_TASK_CALLBACK;
         }
-        else if (swTask_type(current_task) & SW_TASK_COROUTINE)
+        else if (swTask_type(task) & SW_TASK_COROUTINE)
         {
             flags |= SW_TASK_COROUTINE;
         }
@@ -208,7 +529,13 @@ int swTaskWorker_finish(swServer *serv, char *data, int data_len, int flags)
             buf.info.len = data_len;
         }
 
-        if (worker->pool->use_socket && worker->pool->stream->last_connection > 0)
+        //collected until the batch is full, a result that never fits is sent alone
+        if (batch_result && batch_result->info.from_id == source_worker_id && (swTaskWorker_batch_append(batch_result, &buf) == SW_OK
+                || (swTaskWorker_batch_flush(serv) >= 0 && swTaskWorker_batch_append(batch_result, &buf) == SW_OK)))
+        {
+            ret = SW_OK;
+        }
+        else if (worker->pool->use_socket && worker->pool->stream->last_connection > 0)
         {
             int32_t _len = htonl(data_len);
             ret = swSocket_write_blocking(worker->pool->stream->last_connection, (void *) &_len, sizeof(_len));
@@ -235,7 +562,7 @@ int swTaskWorker_finish(swServer *serv, char *data, int data_len, int flags)
         //lock worker
         worker->lock.lock(&worker->lock);
 
-        if (swTask_type(current_task) & SW_TASK_WAITALL)
+        if (swTask_type(task) & SW_TASK_WAITALL)
         {
             sw_atomic_t *finish_count = (sw_atomic_t*) result->data;
             char *_tmpfile = result->data + 4;
@@ -243,7 +570,7 @@ int swTaskWorker_finish(swServer *serv, char *data, int data_len, int flags)
             if (fd >= 0)
             {
                 buf.info.type = SW_EVENT_FINISH;
-                buf.info.fd = current_task->info.fd;
+                buf.info.fd = task->info.fd;
                 swTask_type(&buf) = flags;
                 //result pack
                 if (data_len >= SW_IPC_MAX_SIZE - sizeof(buf.info))
@@ -271,7 +598,7 @@ int swTaskWorker_finish(swServer *serv, char *data, int data_len, int flags)
         else
         {
             result->info.type = SW_EVENT_FINISH;
-            result->info.fd = current_task->info.fd;
+            result->info.fd = task->info.fd;
             swTask_type(result) = flags;
 
             if (data_len >= SW_IPC_MAX_SIZE - sizeof(buf.info))
@@ -113,18 +113,38 @@ int swTimer_init(long msec)
         return SW_ERR;
     }
 
-    //最小堆
-    SwooleG.timer.heap = swHeap_new(1024, SW_MIN_HEAP);
-    if (!SwooleG.timer.heap)
+    if (SwooleG.enable_timer_wheel)
     {
-        return SW_ERR;
+        //时间轮
+        SwooleG.timer.wheel = swTimerWheel_new(0);
+        if (!SwooleG.timer.wheel)
+        {
+            return SW_ERR;
+        }
+    }
+    else
+    {
+        //最小堆
+        SwooleG.timer.heap = swHeap_new(1024, SW_MIN_HEAP);
+        if (!SwooleG.timer.heap)
+        {
+            return SW_ERR;
+        }
     }
     //hashmap  SW_HASHMAP_INIT_BUCKET_N =32
     SwooleG.timer.map = swHashMap_new(SW_HASHMAP_INIT_BUCKET_N, NULL);
     if (!SwooleG.timer.map)
     {
-        swHeap_free(SwooleG.timer.heap);
-        SwooleG.timer.heap = NULL;
+        if (SwooleG.timer.heap)
+        {
+            swHeap_free(SwooleG.timer.heap);
+            SwooleG.timer.heap = NULL;
+        }
+        if (SwooleG.timer.wheel)
+        {
+            swTimerWheel_free(SwooleG.timer.wheel);
+            SwooleG.timer.wheel = NULL;
+        }
         return SW_ERR;
     }
 
@@ -133,7 +153,12 @@ int swTimer_init(long msec)
     SwooleG.timer._next_id = 1;
     SwooleG.timer.add = swTimer_add;//追加定时器回调函数
 
-    if (swIsTaskWorker())//task 进程
+    if (SwooleG.enable_latency_stats && SwooleG.timer.lag == NULL)
+    {
+        SwooleG.timer.lag = swHistogram_new();
+    }
+
+    if (swIsTaskWorker() && !SwooleG.main_reactor)//task 进程
     {   //创建eventfd 
         swSystemTimer_init(msec, SwooleG.use_timer_pipe);
     }
@@ -151,6 +176,23 @@ void swTimer_free(swTimer *timer)
     {
         swHeap_free(timer->heap);
     }
+    if (timer->wheel)
+    {
+        swTimerWheel_free(timer->wheel);
+        timer->wheel = NULL;
+    }
+    swTimer_node *tnode;
+    while ((tnode = timer->node_pool))
+    {
+        timer->node_pool = tnode->data;
+        sw_free(tnode);
+    }
+    timer->node_pool_num = 0;
+    if (timer->lag)
+    {
+        swHistogram_free(timer->lag);
+        timer->lag = NULL;
+    }
 }
 
 //定时器初始化
@@ -169,19 +211,49 @@ static int swReactorTimer_set(swTimer *timer, long exec_msec)
     return SW_OK;
 }
 
-static swTimer_node* swTimer_add(swTimer *timer, int _msec, int interval, void *data, swTimerCallback callback)
+static sw_inline swTimer_node* swTimer_node_alloc(swTimer *timer)
 {
-    swTimer_node *tnode = sw_malloc(sizeof(swTimer_node));
+    swTimer_node *tnode = timer->node_pool;
+    if (tnode)
+    {
+        timer->node_pool = tnode->data;
+        timer->node_pool_num--;
+        return tnode;
+    }
+    tnode = sw_malloc(sizeof(swTimer_node));
     if (!tnode)
     {
         swSysError("malloc(%ld) failed.", sizeof(swTimer_node));
         return NULL;
     }
+    return tnode;
+}
+
+static sw_inline void swTimer_node_free(swTimer *timer, swTimer_node *tnode)
+{
+    if (timer->node_pool_num < SW_TIMER_NODE_POOL_SIZE)
+    {
+        tnode->data = timer->node_pool;
+        timer->node_pool = tnode;
+        timer->node_pool_num++;
+    }
+    else
+    {
+        sw_free(tnode);
+    }
+}
 
+static swTimer_node* swTimer_add(swTimer *timer, int _msec, int interval, void *data, swTimerCallback callback)
+{
     int64_t now_msec = swTimer_get_relative_msec();
     if (now_msec < 0)
     {
-        sw_free(tnode);
+        return NULL;
+    }
+
+    swTimer_node *tnode = swTimer_node_alloc(timer);
+    if (!tnode)
+    {
         return NULL;
     }
 
@@ -204,14 +276,22 @@ static swTimer_node* swTimer_add(swTimer *timer, int _msec, int interval, void *
         tnode->id = 1;
         timer->_next_id = 2;
     }
-    timer->num++;
 
-    tnode->heap_node = swHeap_push(timer->heap, tnode->exec_msec, tnode);
-    if (tnode->heap_node == NULL)
+    if (timer->wheel)
     {
-        sw_free(tnode);
-        return NULL;
+        tnode->heap_node = NULL;
+        swTimerWheel_add(timer->wheel, tnode);
+    }
+    else
+    {
+        tnode->heap_node = swHeap_push(timer->heap, tnode->exec_msec, tnode);
+        if (tnode->heap_node == NULL)
+        {
+            swTimer_node_free(timer, tnode);
+            return NULL;
+        }
     }
+    timer->num++;
     swHashMap_add_int(timer->map, tnode->id, tnode);
     return tnode;
 }
@@ -231,17 +311,69 @@ int swTimer_del(swTimer *timer, swTimer_node *tnode)
     {
         return SW_ERR;
     }
-    if (tnode->heap_node)
+    if (timer->wheel)
+    {
+        swTimerWheel_remove(timer->wheel, tnode);
+    }
+    else if (tnode->heap_node)
     {
         //remove from min-heap
         swHeap_remove(timer->heap, tnode->heap_node);
         sw_free(tnode->heap_node);
     }
-    sw_free(tnode);
+    swTimer_node_free(timer, tnode);
     timer->num --;
     return SW_TRUE;
 }
 
+static int swTimer_select_wheel(swTimer *timer, int64_t now_msec)
+{
+    swTimer_node *tnode;
+    long timer_id;
+
+    while ((tnode = swTimerWheel_pop(timer->wheel, now_msec)))
+    {
+        timer_id = timer->_current_id = tnode->id;
+        if (!tnode->remove)
+        {
+            if (timer->lag)
+            {
+                swHistogram_record(timer->lag, (now_msec - tnode->exec_msec) * 1000);
+            }
+            tnode->callback(timer, tnode);
+        }
+        timer->_current_id = -1;
+
+        //persistent timer
+        if (tnode->interval > 0 && !tnode->remove)
+        {
+            while (tnode->exec_msec <= now_msec)
+            {
+                tnode->exec_msec += tnode->interval;
+            }
+            swTimerWheel_add(timer->wheel, tnode);
+            continue;
+        }
+
+        timer->num--;
+        swHashMap_del_int(timer->map, timer_id);
+        swTimer_node_free(timer, tnode);
+    }
+
+    int64_t next_msec = swTimerWheel_next(timer->wheel);
+    if (next_msec < 0)
+    {
+        timer->_next_msec = -1;
+        timer->set(timer, -1);
+    }
+    else
+    {
+        timer->_next_msec = next_msec > now_msec ? next_msec - now_msec : 1;
+        timer->set(timer, timer->_next_msec);
+    }
+    return SW_OK;
+}
+
 int swTimer_select(swTimer *timer)
 {
     int64_t now_msec = swTimer_get_relative_msec();
@@ -250,6 +382,11 @@ int swTimer_select(swTimer *timer)
         return SW_ERR;
     }
 
+    if (timer->wheel)
+    {
+        return swTimer_select_wheel(timer, now_msec);
+    }
+
     swTimer_node *tnode = NULL;
     swHeap_node *tmp;
     long timer_id;
@@ -265,6 +402,10 @@ int swTimer_select(swTimer *timer)
         timer_id = timer->_current_id = tnode->id;
         if (!tnode->remove)
         {
+            if (timer->lag)
+            {
+                swHistogram_record(timer->lag, (now_msec - tnode->exec_msec) * 1000);
+            }
             tnode->callback(timer, tnode);
         }
         timer->_current_id = -1;
@@ -283,7 +424,7 @@ int swTimer_select(swTimer *timer)
         timer->num--;
         swHeap_pop(timer->heap);
         swHashMap_del_int(timer->map, timer_id);
-        sw_free(tnode);
+        swTimer_node_free(timer, tnode);
     }
 
     if (!tnode || !tmp)
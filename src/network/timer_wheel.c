@@ -0,0 +1,282 @@
+/*
+ +----------------------------------------------------------------------+
+ | Swoole                                                               |
+ +----------------------------------------------------------------------+
+ | This source file is subject to version 2.0 of the Apache license,    |
+ | that is bundled with this package in the file LICENSE, and is        |
+ | available through the world-wide-web at the following url:           |
+ | http://www.apache.org/licenses/LICENSE-2.0.html                      |
+ | If you did not receive a copy of the Apache2.0 license and are unable|
+ | to obtain it through the world-wide-web, please send a note to       |
+ | license@swoole.com so we can mail you a copy immediately.            |
+ +----------------------------------------------------------------------+
+ | Author: Tianfeng Han  <mikan.tenny@gmail.com>                        |
+ +----------------------------------------------------------------------+
+ */
+
+#include "swoole.h"
+#include <stddef.h>
+
+/**
+ * hierarchical timer wheel, 1 millisecond per tick:
+ * level 0 has 256 slots of 1ms, level 1~4 have 64 slots of 2^8, 2^14, 2^20, 2^26 ms.
+ * the slots of a higher level are cascaded into the lower levels when the lower level wraps.
+ */
+#define SW_TIMER_WHEEL_ROOT_BITS    8
+#define SW_TIMER_WHEEL_ROOT_SIZE    (1 << SW_TIMER_WHEEL_ROOT_BITS)
+#define SW_TIMER_WHEEL_ROOT_MASK    (SW_TIMER_WHEEL_ROOT_SIZE - 1)
+#define SW_TIMER_WHEEL_BITS         6
+#define SW_TIMER_WHEEL_SIZE         (1 << SW_TIMER_WHEEL_BITS)
+#define SW_TIMER_WHEEL_MASK         (SW_TIMER_WHEEL_SIZE - 1)
+#define SW_TIMER_WHEEL_LEVEL        5
+#define SW_TIMER_WHEEL_SLOT_NUM     (SW_TIMER_WHEEL_ROOT_SIZE + (SW_TIMER_WHEEL_LEVEL - 1) * SW_TIMER_WHEEL_SIZE)
+#define SW_TIMER_WHEEL_MAX_DELTA    ((1LL << (SW_TIMER_WHEEL_ROOT_BITS + (SW_TIMER_WHEEL_LEVEL - 1) * SW_TIMER_WHEEL_BITS)) - 1)
+
+#define swTimerWheel_shift(level)   (SW_TIMER_WHEEL_ROOT_BITS + ((level) - 1) * SW_TIMER_WHEEL_BITS)
+#define swTimerWheel_slot(level, i) (SW_TIMER_WHEEL_ROOT_SIZE + ((level) - 1) * SW_TIMER_WHEEL_SIZE + (i))
+
+struct _swTimerWheel
+{
+    /**
+     * the next tick to be processed
+     */
+    int64_t current;
+    uint32_t num;
+    /**
+     * bitmap of the non-empty slots
+     */
+    uint64_t bitmap[SW_TIMER_WHEEL_SLOT_NUM / 64];
+    swTimer_link slots[SW_TIMER_WHEEL_SLOT_NUM];
+};
+
+static sw_inline void swTimerWheel_link(swTimerWheel *wheel, uint32_t slot, swTimer_node *tnode)
+{
+    swTimer_link *head = &wheel->slots[slot];
+    tnode->slot = slot;
+    tnode->link.prev = head->prev;
+    tnode->link.next = head;
+    head->prev->next = &tnode->link;
+    head->prev = &tnode->link;
+    wheel->bitmap[slot >> 6] |= 1ULL << (slot & 63);
+}
+
+static sw_inline void swTimerWheel_unlink(swTimerWheel *wheel, swTimer_node *tnode)
+{
+    tnode->link.prev->next = tnode->link.next;
+    tnode->link.next->prev = tnode->link.prev;
+    tnode->link.prev = tnode->link.next = NULL;
+    swTimer_link *head = &wheel->slots[tnode->slot];
+    if (head->next == head)
+    {
+        wheel->bitmap[tnode->slot >> 6] &= ~(1ULL << (tnode->slot & 63));
+    }
+}
+
+#define swTimerWheel_node(l)        ((swTimer_node *) ((char *) (l) - offsetof(swTimer_node, link)))
+
+/**
+ * the first non-empty slot in [from, to) of the bitmap, -1 if not found
+ */
+static int swTimerWheel_find(uint64_t *bitmap, int from, int to)
+{
+    int i = from;
+    while (i < to)
+    {
+        uint64_t bits = bitmap[i >> 6] >> (i & 63);
+        if (bits)
+        {
+            i += __builtin_ctzll(bits);
+            return i < to ? i : -1;
+        }
+        i = (i | 63) + 1;
+    }
+    return -1;
+}
+
+swTimerWheel* swTimerWheel_new(int64_t now_msec)
+{
+    swTimerWheel *wheel = sw_malloc(sizeof(swTimerWheel));
+    if (!wheel)
+    {
+        swWarn("malloc(%ld) failed.", sizeof(swTimerWheel));
+        return NULL;
+    }
+    bzero(wheel->bitmap, sizeof(wheel->bitmap));
+    int i;
+    for (i = 0; i < SW_TIMER_WHEEL_SLOT_NUM; i++)
+    {
+        wheel->slots[i].prev = wheel->slots[i].next = &wheel->slots[i];
+    }
+    wheel->current = now_msec;
+    wheel->num = 0;
+    return wheel;
+}
+
+void swTimerWheel_free(swTimerWheel *wheel)
+{
+    sw_free(wheel);
+}
+
+static void swTimerWheel_insert(swTimerWheel *wheel, swTimer_node *tnode)
+{
+    int64_t expire = tnode->exec_msec;
+    int64_t delta = expire - wheel->current;
+    if (delta < 0)
+    {
+        expire = wheel->current;
+        delta = 0;
+    }
+    else if (delta > SW_TIMER_WHEEL_MAX_DELTA)
+    {
+        expire = wheel->current + SW_TIMER_WHEEL_MAX_DELTA;
+        delta = SW_TIMER_WHEEL_MAX_DELTA;
+    }
+
+    if (delta < SW_TIMER_WHEEL_ROOT_SIZE)
+    {
+        swTimerWheel_link(wheel, expire & SW_TIMER_WHEEL_ROOT_MASK, tnode);
+        return;
+    }
+    int level;
+    for (level = 1; level < SW_TIMER_WHEEL_LEVEL - 1; level++)
+    {
+        if (delta < (1LL << swTimerWheel_shift(level + 1)))
+        {
+            break;
+        }
+    }
+    swTimerWheel_link(wheel, swTimerWheel_slot(level, (expire >> swTimerWheel_shift(level)) & SW_TIMER_WHEEL_MASK), tnode);
+}
+
+void swTimerWheel_add(swTimerWheel *wheel, swTimer_node *tnode)
+{
+    swTimerWheel_insert(wheel, tnode);
+    wheel->num++;
+}
+
+void swTimerWheel_remove(swTimerWheel *wheel, swTimer_node *tnode)
+{
+    if (tnode->link.next == NULL)
+    {
+        return;
+    }
+    swTimerWheel_unlink(wheel, tnode);
+    wheel->num--;
+}
+
+/**
+ * move the nodes of the higher levels down, wheel->current is at the start of a root round
+ */
+static void swTimerWheel_cascade(swTimerWheel *wheel)
+{
+    int level;
+    for (level = 1; level < SW_TIMER_WHEEL_LEVEL; level++)
+    {
+        int index = (wheel->current >> swTimerWheel_shift(level)) & SW_TIMER_WHEEL_MASK;
+        swTimer_link *head = &wheel->slots[swTimerWheel_slot(level, index)];
+        while (head->next != head)
+        {
+            swTimer_node *tnode = swTimerWheel_node(head->next);
+            swTimerWheel_unlink(wheel, tnode);
+            swTimerWheel_insert(wheel, tnode);
+        }
+        if (index != 0)
+        {
+            break;
+        }
+    }
+}
+
+/**
+ * detach the next node that expires at or before now_msec, NULL if there is none
+ */
+swTimer_node* swTimerWheel_pop(swTimerWheel *wheel, int64_t now_msec)
+{
+    while (wheel->current <= now_msec)
+    {
+        if (wheel->num == 0)
+        {
+            wheel->current = now_msec + 1;
+            break;
+        }
+        int index = wheel->current & SW_TIMER_WHEEL_ROOT_MASK;
+        swTimer_link *head = &wheel->slots[index];
+        if (head->next != head)
+        {
+            swTimer_node *tnode = swTimerWheel_node(head->next);
+            swTimerWheel_unlink(wheel, tnode);
+            wheel->num--;
+            return tnode;
+        }
+        //skip the empty slots, but never across the start of the next round
+        int64_t target;
+        int found = swTimerWheel_find(wheel->bitmap, index + 1, SW_TIMER_WHEEL_ROOT_SIZE);
+        if (found >= 0)
+        {
+            target = wheel->current + (found - index);
+        }
+        else
+        {
+            target = (wheel->current | SW_TIMER_WHEEL_ROOT_MASK) + 1;
+        }
+        wheel->current = target > now_msec + 1 ? now_msec + 1 : target;
+        if ((wheel->current & SW_TIMER_WHEEL_ROOT_MASK) == 0)
+        {
+            swTimerWheel_cascade(wheel);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * the tick at which the wheel must be processed next, -1 if it is empty
+ */
+int64_t swTimerWheel_next(swTimerWheel *wheel)
+{
+    if (wheel->num == 0)
+    {
+        return -1;
+    }
+    int index = wheel->current & SW_TIMER_WHEEL_ROOT_MASK;
+    int found = swTimerWheel_find(wheel->bitmap, index, SW_TIMER_WHEEL_ROOT_SIZE);
+    if (found >= 0)
+    {
+        return wheel->current + (found - index);
+    }
+
+    int64_t round = (wheel->current | SW_TIMER_WHEEL_ROOT_MASK) + 1;
+    int64_t next = -1;
+    //the root slots before the current one belong to the next round
+    found = swTimerWheel_find(wheel->bitmap, 0, index);
+    if (found >= 0)
+    {
+        next = round + found;
+    }
+    int level;
+    for (level = 1; level < SW_TIMER_WHEEL_LEVEL; level++)
+    {
+        int shift = swTimerWheel_shift(level);
+        int pos = (wheel->current >> shift) & SW_TIMER_WHEEL_MASK;
+        int from = swTimerWheel_slot(level, 0);
+        //the slot after pos is cascaded first, pos itself is a full turn away
+        found = swTimerWheel_find(wheel->bitmap, from + pos + 1, from + SW_TIMER_WHEEL_SIZE);
+        if (found < 0)
+        {
+            found = swTimerWheel_find(wheel->bitmap, from, from + pos + 1);
+            if (found >= 0)
+            {
+                found += SW_TIMER_WHEEL_SIZE;
+            }
+        }
+        if (found < 0)
+        {
+            continue;
+        }
+        int64_t cascade = ((wheel->current >> shift) + (found - from - pos)) << shift;
+        if (next < 0 || cascade < next)
+        {
+            next = cascade;
+        }
+    }
+    return next;
+}
@@ -84,7 +84,7 @@ void swWorker_signal_handler(int signo)
         /**
          * Event worker
          */
-        if (SwooleG.main_reactor)
+        if (SwooleG.main_reactor && !swIsTaskWorker())
         {
             swWorker_stop();
         }
@@ -94,6 +94,10 @@ void swWorker_signal_handler(int signo)
         else
         {
             SwooleG.running = 0;
+            if (SwooleG.main_reactor)
+            {
+                SwooleG.main_reactor->running = 0;
+            }
         }
         break;
     case SIGALRM:
@@ -145,17 +149,14 @@ static sw_inline int swWorker_discard_data(swServer *serv, swEventData *task)
         }
     }
     discard_data:
-#ifdef SW_USE_RINGBUFFER
     if (task->info.type == SW_EVENT_PACKAGE)
     {
         swPackage package;
         memcpy(&package, task->data, sizeof(package));
-        swReactorThread *thread = swServer_get_thread(SwooleG.serv, task->info.from_id);
-        thread->buffer_input->free(thread->buffer_input, package.data);
+        swReactorThread_free_package(serv, task);
         swoole_error_log(SW_LOG_WARNING, SW_ERROR_SESSION_DISCARD_TIMEOUT_DATA, "[1]received the wrong data[%d bytes] from socket#%d", package.length, session_id);
     }
     else
-#endif
     {
         swoole_error_log(SW_LOG_WARNING, SW_ERROR_SESSION_DISCARD_TIMEOUT_DATA, "[1]received the wrong data[%d bytes] from socket#%d", task->info.len, session_id);
     }
@@ -277,11 +278,83 @@ static int swWorker_onStreamPackage(swConnection *conn, char *data, uint32_t len
     return SW_OK;
 }
 
+static void swWorker_onDgram(swServer *serv, swEventData *task)
+{
+    swWorker *worker = SwooleWG.worker;
+    swString *package = swWorker_get_buffer(serv, task->info.from_id);
+    swString_append_ptr(package, task->data, task->info.len);
+
+    if (package->offset == 0)
+    {
+        swDgramPacket *header = (swDgramPacket *) package->str;
+        package->offset = header->length;
+    }
+
+    //one packet
+    if (package->offset == package->length - sizeof(swDgramPacket))
+    {
+        worker->request_count++;
+        worker->request_time = serv->gs->now;
+#ifdef SW_BUFFER_RECV_TIME
+        serv->last_receive_usec = task->info.time;
+#endif
+        sw_atomic_fetch_add(&serv->stats->request_count, 1);
+        serv->onPacket(serv, task);
+        worker->request_time = 0;
+#ifdef SW_BUFFER_RECV_TIME
+        serv->last_receive_usec = 0;
+#endif
+        worker->traced = 0;
+        worker->request_count++;
+        swString_clear(package);
+    }
+}
+
+/**
+ * the datagrams of one recvmmsg, the replies are sent together after the last one
+ */
+static void swWorker_onDgramBatch(swServer *serv, swEventData *task)
+{
+#ifdef HAVE_SENDMMSG
+    static swDgramBatch *batch = NULL;
+    if (batch == NULL)
+    {
+        batch = sw_malloc(sizeof(swDgramBatch));
+        if (batch == NULL)
+        {
+            swWarn("malloc(%ld) failed.", sizeof(swDgramBatch));
+        }
+        else
+        {
+            batch->num = 0;
+            batch->length = 0;
+            batch->gso_disabled = 0;
+        }
+    }
+    SwooleWG.dgram_batch = batch;
+#endif
+
+    uint32_t offset = 0;
+    while (offset + sizeof(swDataHead) <= task->info.len)
+    {
+        swEventData *record = (swEventData *) (task->data + offset);
+        offset += swEventData_batch_size(&record->info);
+        swWorker_onDgram(serv, record);
+    }
+
+#ifdef HAVE_SENDMMSG
+    SwooleWG.dgram_batch = NULL;
+    if (batch && batch->num > 0)
+    {
+        swDgramBatch_flush(batch);
+    }
+#endif
+}
+
 int swWorker_onTask(swFactory *factory, swEventData *task)
 {
     swServer *serv = factory->ptr;
     swString *package = NULL;
-    swDgramPacket *header;
 
 #ifdef SW_USE_OPENSSL
     swConnection *conn;
@@ -292,6 +365,8 @@ int swWorker_onTask(swFactory *factory, swEventData *task)
     swWorker *worker = SwooleWG.worker;
     //worker busy
     worker->status = SW_WORKER_BUSY;
+    //read by the manager for the autoscaling as well
+    uint64_t begin_usec = (serv->dispatch_mode == SW_DISPATCH_EWMA || serv->min_worker_num > 0) ? swoole_monotonic_usec() : 0;
 
     switch (task->info.type)
     {
@@ -323,6 +398,11 @@ int swWorker_onTask(swFactory *factory, swEventData *task)
         {
             package->length = 0;
         }
+        //release the shared memory after onReceive
+        else if (task->info.type == SW_EVENT_PACKAGE)
+        {
+            swReactorThread_free_package(serv, task);
+        }
         break;
 
     //chunk package
@@ -349,33 +429,11 @@ int swWorker_onTask(swFactory *factory, swEventData *task)
     case SW_EVENT_UDP:
     case SW_EVENT_UDP6:
     case SW_EVENT_UNIX_DGRAM:
-        package = swWorker_get_buffer(serv, task->info.from_id);
-        swString_append_ptr(package, task->data, task->info.len);
-
-        if (package->offset == 0)
-        {
-            header = (swDgramPacket *) package->str;
-            package->offset = header->length;
-        }
+        swWorker_onDgram(serv, task);
+        break;
 
-        //one packet
-        if (package->offset == package->length - sizeof(swDgramPacket))
-        {
-            worker->request_count++;
-            worker->request_time = serv->gs->now;
-#ifdef SW_BUFFER_RECV_TIME
-            serv->last_receive_usec = task->info.time;
-#endif
-            sw_atomic_fetch_add(&serv->stats->request_count, 1);
-            serv->onPacket(serv, task);
-            worker->request_time = 0;
-#ifdef SW_BUFFER_RECV_TIME
-            serv->last_receive_usec = 0;
-#endif
-            worker->traced = 0;
-            worker->request_count++;
-            swString_clear(package);
-        }
+    case SW_EVENT_UDP_BATCH:
+        swWorker_onDgramBatch(serv, task);
         break;
 
     case SW_EVENT_CLOSE:
@@ -421,7 +479,7 @@ int swWorker_onTask(swFactory *factory, swEventData *task)
         break;
 
     case SW_EVENT_FINISH:
-        serv->onFinish(serv, task);
+        swTaskWorker_finish_dispatch(serv, task);
         break;
 
     case SW_EVENT_PIPE_MESSAGE:
@@ -436,6 +494,31 @@ int swWorker_onTask(swFactory *factory, swEventData *task)
     //worker idle
     worker->status = SW_WORKER_IDLE;
 
+    //the message was dispatched by a reactor thread
+    if (swServer_dispatch_count_enable(serv) && task->info.type != SW_EVENT_FINISH && task->info.type != SW_EVENT_PIPE_MESSAGE)
+    {
+        if (begin_usec)
+        {
+            int64_t usec = swoole_monotonic_usec() - begin_usec;
+            int64_t average = worker->process_usec;
+            worker->process_usec = average + ((usec - average) >> SW_WORKER_EWMA_SHIFT);
+        }
+        sw_atomic_fetch_add(&worker->finish_count, 1);
+        if (serv->dispatch_mode == SW_DISPATCH_CHASH)
+        {
+            sw_atomic_fetch_add(&serv->gs->finish_count, 1);
+        }
+    }
+    //the connection may move to another reactor thread when nothing is in flight
+    if (serv->enable_reactor_steal && swEventData_is_stream(task->info.type))
+    {
+        swConnection *_conn = swServer_connection_verify_no_ssl(serv, task->info.fd);
+        if (_conn)
+        {
+            swServer_connection_route_release(serv, _conn);
+        }
+    }
+
     //maximum number of requests, process will exit.
     if (!SwooleWG.run_always && worker->request_count >= SwooleWG.max_request)
     {
@@ -585,6 +668,10 @@ static void swWorker_stop()
     {
         swReactor_remove_read_event(SwooleG.main_reactor, worker->pipe_worker);
     }
+    if (serv->ipc_mode == SW_IPC_RING)
+    {
+        SwooleG.main_reactor->del(SwooleG.main_reactor, swDoorbell_getFd(&serv->worker_doorbells[SwooleWG.id]));
+    }
 
     if (serv->stream_fd > 0)
     {
@@ -719,6 +806,22 @@ void swWorker_clean(void)
             }
         }
     }
+
+    if (SwooleWG.ring_buffer)
+    {
+        for (i = 0; i < serv->reactor_num; i++)
+        {
+            if (SwooleWG.ring_buffer[i] == NULL)
+            {
+                continue;
+            }
+            while (swServer_ring_flush(swServer_get_response_ring(serv, SwooleWG.id, i), SwooleWG.ring_buffer[i],
+                    &serv->reactor_doorbells[i]) < 0)
+            {
+                usleep(1000);
+            }
+        }
+    }
 }
 
 /**
@@ -764,6 +867,21 @@ int swWorker_loop(swFactory *factory, int worker_id)
     SwooleG.main_reactor->setHandle(SwooleG.main_reactor, SW_FD_PIPE, swWorker_onPipeReceive);
     SwooleG.main_reactor->setHandle(SwooleG.main_reactor, SW_FD_WRITE, swReactor_onWrite);
 
+    if (serv->ipc_mode == SW_IPC_RING)
+    {
+        SwooleWG.ring_buffer = sw_calloc(serv->reactor_num, sizeof(swBuffer *));
+        if (SwooleWG.ring_buffer == NULL)
+        {
+            swError("[Worker] malloc for ring_buffer failed.");
+            return SW_ERR;
+        }
+        swDoorbell *bell = &serv->worker_doorbells[worker_id];
+        SwooleG.main_reactor->add(SwooleG.main_reactor, swDoorbell_getFd(bell), SW_FD_IPC_RING | SW_EVENT_READ);
+        SwooleG.main_reactor->setHandle(SwooleG.main_reactor, SW_FD_IPC_RING, swWorker_onRingReceive);
+        //the previous worker may exit with the requests in the rings
+        swDoorbell_notify(bell);
+    }
+
     /**
      * set pipe buffer size
      */
@@ -813,8 +931,26 @@ int swWorker_send2reactor(swEventData *ev_data, size_t sendn, int session_id)
 {
     int ret;
     swServer *serv = SwooleG.serv;
-    int _pipe_fd = swWorker_get_send_pipe(serv, session_id, ev_data->info.from_id);
 
+    //only the event workers have their own rings
+    if (SwooleWG.ring_buffer)
+    {
+        int reactor_id = ev_data->info.from_id;
+        swShmRing *ring = swServer_get_response_ring(serv, SwooleWG.id, reactor_id);
+        if (SwooleG.main_reactor)
+        {
+            return swServer_ring_push(ring, &SwooleWG.ring_buffer[reactor_id], &serv->reactor_doorbells[reactor_id], ev_data, sendn);
+        }
+        while (swServer_ring_flush(ring, SwooleWG.ring_buffer[reactor_id], &serv->reactor_doorbells[reactor_id]) < 0
+                || swShmRing_push(ring, ev_data, sendn) < 0)
+        {
+            usleep(1000);
+        }
+        swDoorbell_ring(&serv->reactor_doorbells[reactor_id]);
+        return SW_OK;
+    }
+
+    int _pipe_fd = swWorker_get_send_pipe(serv, session_id, ev_data->info.from_id);
     if (SwooleG.main_reactor)
     {
         ret = SwooleG.main_reactor->write(SwooleG.main_reactor, _pipe_fd, ev_data, sendn);
@@ -863,6 +999,85 @@ static int swWorker_onPipeReceive(swReactor *reactor, swEvent *event)
     return SW_ERR;
 }
 
+static int swWorker_ring_empty(swServer *serv)
+{
+    int i;
+    for (i = 0; i < serv->reactor_num; i++)
+    {
+        if (!swShmRing_empty(swServer_get_request_ring(serv, SwooleWG.id, i)))
+        {
+            return SW_FALSE;
+        }
+    }
+    return SW_TRUE;
+}
+
+/**
+ * SW_IPC_RING: the doorbell of the worker, receive the requests from the rings of all reactor threads
+ */
+int swWorker_onRingReceive(swReactor *reactor, swEvent *event)
+{
+    swServer *serv = reactor->ptr;
+    swFactory *factory = &serv->factory;
+    swDoorbell *bell = &serv->worker_doorbells[SwooleWG.id];
+    swEventData task;
+    swShmRing *ring;
+    int i, n, more;
+
+    swDoorbell_clear(bell);
+
+    while (1)
+    {
+        more = 0;
+        for (i = 0; i < serv->reactor_num; i++)
+        {
+            ring = swServer_get_request_ring(serv, SwooleWG.id, i);
+            //the rest are left to the next worker after swWorker_stop
+            for (n = 0; n < SW_IPC_RING_BATCH && !SwooleWG.wait_exit && reactor->running; n++)
+            {
+                if (swShmRing_pop(ring, &task, sizeof(task)) == 0)
+                {
+                    break;
+                }
+                swWorker_onTask(factory, &task);
+            }
+            if (n > 0)
+            {
+                swServer_ring_release(ring, &serv->reactor_doorbells[i]);
+                if (n == SW_IPC_RING_BATCH)
+                {
+                    more = 1;
+                }
+            }
+            //the responses waiting for the ring of this reactor thread
+            if (!swBuffer_empty(SwooleWG.ring_buffer[i]))
+            {
+                swServer_ring_flush(swServer_get_response_ring(serv, SwooleWG.id, i), SwooleWG.ring_buffer[i], &serv->reactor_doorbells[i]);
+            }
+        }
+        if (SwooleWG.wait_exit || !reactor->running)
+        {
+            return SW_OK;
+        }
+        //give the other events a chance, and come back in the next round
+        if (more)
+        {
+            swDoorbell_notify(bell);
+            return SW_OK;
+        }
+        swDoorbell_sleep(bell);
+        if (swWorker_ring_empty(serv))
+        {
+            return SW_OK;
+        }
+        //a reactor thread has rung the doorbell, the eventfd will fire again
+        if (!swDoorbell_wakeup(bell))
+        {
+            return SW_OK;
+        }
+    }
+}
+
 int swWorker_send2worker(swWorker *dst_worker, void *buf, int n, int flag)
 {
     int pipefd, ret;
@@ -885,7 +1100,17 @@ int swWorker_send2worker(swWorker *dst_worker, void *buf, int n, int flag)
             swEventData buf;
         } msg;
 
-        msg.mtype = dst_worker->id + 1;
+        /**
+         * the task workers pop the lowest type first
+         */
+        if (dst_worker->pool->dispatch_mode == SW_DISPATCH_QUEUE && dst_worker->pool->type == SW_PROCESS_TASKWORKER)
+        {
+            msg.mtype = SW_TASK_PRIORITY_NUM - swTask_priority((swEventData *) buf);
+        }
+        else
+        {
+            msg.mtype = dst_worker->id + 1;
+        }
         memcpy(&msg.buf, buf, n);
 
         return swMsgQueue_push(dst_worker->pool->queue, (swQueue_data *) &msg, n);
@@ -0,0 +1,130 @@
+/*
+ +----------------------------------------------------------------------+
+ | Swoole                                                               |
+ +----------------------------------------------------------------------+
+ | This source file is subject to version 2.0 of the Apache license,    |
+ | that is bundled with this package in the file LICENSE, and is        |
+ | available through the world-wide-web at the following url:           |
+ | http://www.apache.org/licenses/LICENSE-2.0.html                      |
+ | If you did not receive a copy of the Apache2.0 license and are unable|
+ | to obtain it through the world-wide-web, please send a note to       |
+ | license@swoole.com so we can mail you a copy immediately.            |
+ +----------------------------------------------------------------------+
+ | Author: Tianfeng Han  <mikan.tenny@gmail.com>                        |
+ +----------------------------------------------------------------------+
+ */
+
+#include "swoole.h"
+
+/**
+ * record: [uint32_t length][data], 8 bytes aligned.
+ * a record never wraps, the tail of the ring is skipped with a SW_SHM_RING_WRAP header instead.
+ */
+#define SW_SHM_RING_WRAP          0xffffffff
+#define SW_SHM_RING_HEADER        sizeof(uint32_t)
+#define swShmRing_align(n)        (((n) + 7) & ~7)
+
+swShmRing* swShmRing_new(uint32_t size)
+{
+    uint32_t n = SW_CACHELINE_SIZE;
+    while (n < size)
+    {
+        n <<= 1;
+    }
+    swShmRing *ring = sw_shm_malloc(sizeof(swShmRing) + n);
+    if (ring == NULL)
+    {
+        swWarn("sw_shm_malloc(%ld) failed.", sizeof(swShmRing) + n);
+        return NULL;
+    }
+    ring->head = 0;
+    ring->tail = 0;
+    ring->waiting = 0;
+    ring->size = n;
+    return ring;
+}
+
+void swShmRing_free(swShmRing *ring)
+{
+    sw_shm_free(ring);
+}
+
+/**
+ * producer side, SW_ERR if the ring is full
+ */
+int swShmRing_push(swShmRing *ring, void *data, uint32_t length)
+{
+    uint32_t need = swShmRing_align(SW_SHM_RING_HEADER + length);
+    //the skipped tail is shorter than the record, so an empty ring always has room for it
+    if (need > ring->size / 2)
+    {
+        swWarn("data is too large for the ring, length=%d.", length);
+        return SW_ERR;
+    }
+
+    unsigned long tail = ring->tail;
+    unsigned long head = sw_atomic_load_acquire(&ring->head);
+    uint32_t offset = tail & (ring->size - 1);
+    uint32_t contiguous = ring->size - offset;
+    uint32_t skip = need > contiguous ? contiguous : 0;
+
+    if (tail + skip + need - head > ring->size)
+    {
+        return SW_ERR;
+    }
+    if (skip)
+    {
+        *(uint32_t *) (ring->data + offset) = SW_SHM_RING_WRAP;
+        offset = 0;
+    }
+    *(uint32_t *) (ring->data + offset) = length;
+    memcpy(ring->data + offset + SW_SHM_RING_HEADER, data, length);
+    sw_atomic_store_release(&ring->tail, tail + skip + need);
+    return SW_OK;
+}
+
+/**
+ * consumer side, returns the length of the record, 0 if the ring is empty
+ */
+int swShmRing_pop(swShmRing *ring, void *buf, uint32_t size)
+{
+    unsigned long head = ring->head;
+    unsigned long tail = sw_atomic_load_acquire(&ring->tail);
+
+    if (head == tail)
+    {
+        return 0;
+    }
+    uint32_t offset = head & (ring->size - 1);
+    uint32_t length = *(uint32_t *) (ring->data + offset);
+    if (length == SW_SHM_RING_WRAP)
+    {
+        head += ring->size - offset;
+        offset = 0;
+        length = *(uint32_t *) ring->data;
+    }
+    if (length > size)
+    {
+        swWarn("buffer is too small, length=%d, size=%d.", length, size);
+        length = size;
+    }
+    memcpy(buf, ring->data + offset + SW_SHM_RING_HEADER, length);
+    sw_atomic_store_release(&ring->head, head + swShmRing_align(SW_SHM_RING_HEADER + *(uint32_t *) (ring->data + offset)));
+    return length;
+}
+
+int swDoorbell_create(swDoorbell *bell)
+{
+    if (swPipeNotify_auto(&bell->pipe, 0, 0) < 0)
+    {
+        return SW_ERR;
+    }
+    //the first push always rings
+    bell->sleeping = 1;
+    return SW_OK;
+}
+
+void swDoorbell_free(swDoorbell *bell)
+{
+    bell->pipe.close(&bell->pipe);
+}
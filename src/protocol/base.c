@@ -157,6 +157,38 @@ int swProtocol_recv_check_length(swProtocol *protocol, swConnection *conn, swStr
         goto do_get_length;
     }
 
+#ifdef HAVE_IO_URING
+    /**
+     * the complete packages in the registered buffer are dispatched without copying
+     */
+    while (conn->completion && conn->completion_length > 0 && buffer->length == 0 && !conn->recv_wait)
+    {
+        package_length = protocol->get_package_length(protocol, conn, conn->completion_data, conn->completion_length);
+        if (package_length < 0)
+        {
+            return SW_ERR;
+        }
+        else if (package_length == 0 || package_length > conn->completion_length)
+        {
+            break;
+        }
+        else if (package_length > protocol->package_max_length)
+        {
+            swWarn("package is too big, remote_addr=%s:%d, length=%d.", swConnection_get_ip(conn), swConnection_get_port(conn), package_length);
+            return SW_ERR;
+        }
+        if (protocol->onPackage(conn, conn->completion_data, package_length) < 0)
+        {
+            return SW_ERR;
+        }
+        if (conn->removed)
+        {
+            return SW_OK;
+        }
+        swConnection_completion_consume(conn, package_length);
+    }
+#endif
+
     do_recv:
 	if (conn->active == 0)
 	{
@@ -45,6 +45,13 @@ int swReactor_create(swReactor *reactor, int max_event)
     int ret;
     bzero(reactor, sizeof(swReactor));
 
+#ifdef HAVE_IO_URING
+    if (SwooleG.enable_io_uring && swReactorIOUring_create(reactor, max_event) == SW_OK)
+    {
+        ret = SW_OK;
+    }
+    else
+#endif
 #ifdef HAVE_EPOLL
     ret = swReactorEpoll_create(reactor, max_event); //create epoll事件模型
 #elif defined(HAVE_KQUEUE)
@@ -54,7 +61,7 @@ int swReactor_create(swReactor *reactor, int max_event)
 #else
     ret = swReactorSelect_create(reactor);
 #endif
-sizeof(swConnection)
+
     reactor->running = 1; // 为1是事件处理启动，为0的话事件处理停止 epoll wait 循环的判断条件
     //注册回调函数
     reactor->setHandle = swReactor_setHandle;//设定事件回调函数方法
@@ -90,6 +97,22 @@ int swReactor_setHandle(swReactor *reactor, int _fdtype, swReactor_handle handle
     if (swReactor_event_read(_fdtype))//_fdtype  < 256 || fdtype & SW_EVENT_READ 时为read 事件
     {
         reactor->handle[fdtype] = handle;//保存为读handle
+#ifdef SW_REACTOR_FAST_DISPATCH
+        switch (fdtype)
+        {
+        case SW_FD_TCP:
+            reactor->tcp_read_handle = handle;
+            break;
+        case SW_FD_PIPE:
+            reactor->pipe_read_handle = handle;
+            break;
+        case SW_FD_LISTEN:
+            reactor->listen_read_handle = handle;
+            break;
+        default:
+            break;
+        }
+#endif
     }
     else if (swReactor_event_write(_fdtype))//fdtype & SW_EVENT_WRITE （100000000000）
     {
@@ -116,31 +139,101 @@ static void swReactor_defer_timer_callback(swTimer *timer, swTimer_node *tnode)
 }
 
 
-static int swReactor_defer(swReactor *reactor, swCallback callback, void *data)
+static int swReactor_defer_extend(swReactor *reactor)
 {
-    swDefer_callback *cb = sw_malloc(sizeof(swDefer_callback));
-    if (!cb)
+    uint32_t size = reactor->defer_size == 0 ? SW_REACTOR_DEFER_SIZE : reactor->defer_size * 2;
+    swDefer_callback *tasks = sw_malloc(size * sizeof(swDefer_callback));
+    if (!tasks)
     {
-        swWarn("malloc(%ld) failed.", sizeof(swDefer_callback));
+        swWarn("malloc(%ld) failed.", size * sizeof(swDefer_callback));
         return SW_ERR;
     }
-    cb->callback = callback;
-    cb->data = data;
+    //unwrap the ring
+    uint32_t i;
+    for (i = 0; i < reactor->defer_count; i++)
+    {
+        tasks[i] = reactor->defer_tasks[(reactor->defer_head + i) & (reactor->defer_size - 1)];
+    }
+    if (reactor->defer_tasks)
+    {
+        sw_free(reactor->defer_tasks);
+    }
+    reactor->defer_tasks = tasks;
+    reactor->defer_size = size;
+    reactor->defer_head = 0;
+    return SW_OK;
+}
+
+static int swReactor_defer(swReactor *reactor, swCallback callback, void *data)
+{
     if (unlikely(reactor->start == 0))
     {
+        swDefer_callback *cb = sw_malloc(sizeof(swDefer_callback));
+        if (!cb)
+        {
+            swWarn("malloc(%ld) failed.", sizeof(swDefer_callback));
+            return SW_ERR;
+        }
+        cb->callback = callback;
+        cb->data = data;
         if (unlikely(SwooleG.timer.fd == 0))
         {
             swTimer_init(1);
         }
         SwooleG.timer.add(&SwooleG.timer, 1, 0, cb, swReactor_defer_timer_callback);
+        return SW_OK;
     }
-    else
+
+    if (unlikely(reactor->defer_count == reactor->defer_size) && swReactor_defer_extend(reactor) < 0)
+    {
+        return SW_ERR;
+    }
+    swDefer_callback *task = &reactor->defer_tasks[(reactor->defer_head + reactor->defer_count) & (reactor->defer_size - 1)];
+    task->callback = callback;
+    task->data = data;
+    reactor->defer_count++;
+    reactor->defer_total++;
+    if (reactor->defer_count > reactor->defer_max_count)
     {
-        LL_APPEND(reactor->defer_tasks, cb);
+        reactor->defer_max_count = reactor->defer_count;
     }
     return SW_OK;
 }
 
+/**
+ * run the queued tasks in batches, the tasks added by the callbacks run in the next batch
+ */
+static void swReactor_defer_run(swReactor *reactor)
+{
+    swCallback callback;
+    void *data;
+    uint32_t n;
+
+    while (reactor->defer_count > 0)
+    {
+        n = reactor->defer_count;
+        while (n--)
+        {
+            swDefer_callback *task = &reactor->defer_tasks[reactor->defer_head];
+            callback = task->callback;
+            data = task->data;
+            reactor->defer_head = (reactor->defer_head + 1) & (reactor->defer_size - 1);
+            reactor->defer_count--;
+            callback(data);
+        }
+    }
+}
+
+void swReactor_free_defer_tasks(swReactor *reactor)
+{
+    if (reactor->defer_tasks)
+    {
+        sw_free(reactor->defer_tasks);
+        reactor->defer_tasks = NULL;
+    }
+    reactor->defer_size = reactor->defer_head = reactor->defer_count = 0;
+}
+
 int swReactor_empty(swReactor *reactor)
 {
     //timer
@@ -179,20 +272,7 @@ static void swReactor_onTimeout_and_Finish(swReactor *reactor)
         swTimer_select(&SwooleG.timer);
     }
     //defer tasks
-    do
-    {
-        swDefer_callback *defer_tasks = reactor->defer_tasks;
-        swDefer_callback *cb, *tmp;
-        reactor->defer_tasks = NULL;
-        LL_FOREACH(defer_tasks, cb)
-        {
-            cb->callback(cb->data);
-        }
-        LL_FOREACH_SAFE(defer_tasks, cb, tmp)
-        {
-            sw_free(cb);
-        }
-    } while (reactor->defer_tasks);
+    swReactor_defer_run(reactor);
 
     //callback at the end
     if (reactor->idle_task.callback)
@@ -215,10 +295,10 @@ static void swReactor_onTimeout_and_Finish(swReactor *reactor)
     }
 
 #ifdef SW_USE_MALLOC_TRIM
-    if (SwooleG.serv && reactor->last_malloc_trim_time < SwooleG.serv->gs->now - SW_MALLOC_TRIM_INTERVAL)
+    if (SwooleG.serv && reactor->last_malloc_trim_time < swReactor_now(reactor) - SW_MALLOC_TRIM_INTERVAL)
     {
         malloc_trim(SW_MALLOC_TRIM_PAD);
-        reactor->last_malloc_trim_time = SwooleG.serv->gs->now;
+        reactor->last_malloc_trim_time = swReactor_now(reactor);
     }
 #endif
 }
@@ -273,6 +353,12 @@ int swReactor_close(swReactor *reactor, int fd)
     {
         swString_free(socket->websocket_buffer);
     }
+#ifdef HAVE_IO_URING
+    if (socket->completion_stash)
+    {
+        sw_free(socket->completion_stash);
+    }
+#endif
     bzero(socket, sizeof(swConnection));
     socket->removed = 1;
     swTraceLog(SW_TRACE_CLOSE, "fd=%d.", fd);
@@ -38,8 +38,35 @@ static int swReactorEpoll_add(swReactor *reactor, int fd, int fdtype);
 static int swReactorEpoll_set(swReactor *reactor, int fd, int fdtype);
 static int swReactorEpoll_del(swReactor *reactor, int fd);
 static int swReactorEpoll_wait(swReactor *reactor, struct timeval *timeo);
+
 static void swReactorEpoll_free(swReactor *reactor);
 
+/**
+ * read event dispatch, the hottest fd types are checked first and get their own call sites,
+ * so that the indirect branches are predicted apart instead of sharing the handle[] call
+ */
+static sw_inline int swReactorEpoll_dispatch_read(swReactor *reactor, swEvent *event)
+{
+#ifdef SW_REACTOR_FAST_DISPATCH
+    if (likely(reactor->latency == NULL))
+    {
+        if (likely(event->type == SW_FD_TCP && reactor->tcp_read_handle))
+        {
+            return reactor->tcp_read_handle(reactor, event);
+        }
+        else if (event->type == SW_FD_PIPE && reactor->pipe_read_handle)
+        {
+            return reactor->pipe_read_handle(reactor, event);
+        }
+        else if (event->type == SW_FD_LISTEN && reactor->listen_read_handle)
+        {
+            return reactor->listen_read_handle(reactor, event);
+        }
+    }
+#endif
+    return swReactor_call(reactor, swReactor_getHandle(reactor, SW_EVENT_READ, event->type), event);
+}
+
 //根据fdtype，设定flag（epoll 监听读，写），并返回
 static sw_inline int swReactorEpoll_event_set(int fdtype)
 {
@@ -56,6 +83,12 @@ static sw_inline int swReactorEpoll_event_set(int fdtype)
     {
         flag |= EPOLLONESHOT;
     }
+#ifdef EPOLLEXCLUSIVE
+    if (fdtype & SW_EVENT_EXCLUSIVE)
+    {
+        flag |= EPOLLEXCLUSIVE;
+    }
+#endif
     if (swReactor_event_error(fdtype))//event error https://blog.csdn.net/q576709166/article/details/8649911
     {
         //flag |= (EPOLLRDHUP);
@@ -118,6 +151,7 @@ static void swReactorEpoll_free(swReactor *reactor)
     close(object->epfd);
     sw_free(object->events);
     sw_free(object);
+    swReactor_free_defer_tasks(reactor);
 }
 
 //监听事件追加
@@ -219,6 +253,37 @@ static int swReactorEpoll_set(swReactor *reactor, int fd, int fdtype)
 
 //事件等待
 //第二个参数时时间
+/**
+ * spin on epoll_wait(..., 0) before blocking, shrink the budget when nothing arrives
+ */
+static int swReactorEpoll_busy_poll(swReactor *reactor, int epoll_fd, struct epoll_event *events, int max_event_num)
+{
+    int n;
+    uint64_t start = swoole_monotonic_usec(), now;
+
+    do
+    {
+        n = epoll_wait(epoll_fd, events, max_event_num, 0);
+        now = swoole_monotonic_usec();
+    } while (n == 0 && now - start < reactor->busy_poll_budget);
+
+    reactor->spin_time += now - start;
+    if (n > 0)
+    {
+        reactor->spin_hit_count++;
+        reactor->busy_poll_budget = reactor->busy_poll_usec;
+    }
+    else if (n == 0)
+    {
+        reactor->spin_miss_count++;
+        if (reactor->busy_poll_budget > reactor->busy_poll_usec / SW_REACTOR_BUSY_POLL_SHRINK)
+        {
+            reactor->busy_poll_budget >>= 1;
+        }
+    }
+    return n;
+}
+
 static int swReactorEpoll_wait(swReactor *reactor, struct timeval *timeo)
 {
     swEvent event;
@@ -252,7 +317,28 @@ static int swReactorEpoll_wait(swReactor *reactor, struct timeval *timeo)
             reactor->onBegin(reactor); //onBegin = swReactor_onBegin
         }
         msec = reactor->timeout_msec;
-        n = epoll_wait(epoll_fd, events, max_event_num, msec);//wait 事件发生
+        if (reactor->busy_poll_usec > 0 && msec != 0)
+        {
+            uint64_t start = swoole_monotonic_usec();
+            n = swReactorEpoll_busy_poll(reactor, epoll_fd, events, max_event_num);
+            if (n == 0)
+            {
+                //the spin already used part of the timeout
+                if (msec > 0)
+                {
+                    int spin_msec = (swoole_monotonic_usec() - start) / 1000;
+                    msec = spin_msec < msec ? msec - spin_msec : 0;
+                }
+                start = swoole_monotonic_usec();
+                n = epoll_wait(epoll_fd, events, max_event_num, msec);
+                reactor->block_time += swoole_monotonic_usec() - start;
+            }
+        }
+        else
+        {
+            n = epoll_wait(epoll_fd, events, max_event_num, msec);//wait 事件发生
+        }
+        swReactor_update_time(reactor);
         if (n < 0) //有错误发生
         {
             if (swReactor_error(reactor) < 0) //error 错误不是中断引起的话，就调用错误处理函数
@@ -284,9 +370,8 @@ static int swReactorEpoll_wait(swReactor *reactor, struct timeval *timeo)
 
             //read
             if ((events[i].events & EPOLLIN) && !event.socket->removed)
-            {   //取得handle
-                handle = swReactor_getHandle(reactor, SW_EVENT_READ, event.type);
-                ret = handle(reactor, &event);
+            {
+                ret = swReactorEpoll_dispatch_read(reactor, &event);
                 if (ret < 0)
                 {
                     swSysError("EPOLLIN handle failed. fd=%d.", event.fd);
@@ -296,7 +381,7 @@ static int swReactorEpoll_wait(swReactor *reactor, struct timeval *timeo)
             if ((events[i].events & EPOLLOUT) && !event.socket->removed)
             {   //取得写handle
                 handle = swReactor_getHandle(reactor, SW_EVENT_WRITE, event.type);
-                ret = handle(reactor, &event);
+                ret = swReactor_call(reactor, handle, &event);
                 if (ret < 0)
                 {
                     swSysError("EPOLLOUT handle failed. fd=%d.", event.fd);
@@ -311,7 +396,7 @@ static int swReactorEpoll_wait(swReactor *reactor, struct timeval *timeo)
                     continue;
                 }
                 handle = swReactor_getHandle(reactor, SW_EVENT_ERROR, event.type);
-                ret = handle(reactor, &event);
+                ret = swReactor_call(reactor, handle, &event);
                 if (ret < 0)
                 {
                     swSysError("EPOLLERR handle failed. fd=%d.", event.fd);
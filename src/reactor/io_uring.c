@@ -0,0 +1,1246 @@
+/*
+ +----------------------------------------------------------------------+
+ | Swoole                                                               |
+ +----------------------------------------------------------------------+
+ | This source file is subject to version 2.0 of the Apache license,    |
+ | that is bundled with this package in the file LICENSE, and is        |
+ | available through the world-wide-web at the following url:           |
+ | http://www.apache.org/licenses/LICENSE-2.0.html                      |
+ | If you did not receive a copy of the Apache2.0 license and are unable|
+ | to obtain it through the world-wide-web, please send a note to       |
+ | license@swoole.com so we can mail you a copy immediately.            |
+ +----------------------------------------------------------------------+
+ | Author: Tianfeng Han  <mikan.tenny@gmail.com>                        |
+ +----------------------------------------------------------------------+
+ */
+
+#include "swoole.h"
+#include "connection.h"
+
+#ifdef HAVE_IO_URING
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <pthread.h>
+
+#ifndef POLLRDHUP
+#define POLLRDHUP  0x2000
+#endif
+
+/**
+ * provided buffer ring, linux 5.19
+ */
+#ifdef HAVE_IO_URING_PBUF_RING
+#define SW_IOURING_COMPLETION       1
+#endif
+
+/**
+ * user_data layout: fd(32bit) | op(2bit) | fdtype(6bit) | seq(24bit)
+ * completions which do not match the armed request of the fd are stale.
+ */
+#define SW_IOURING_SEQ_MASK         0xffffff
+#define SW_IOURING_IGNORE           ((uint64_t) -1)
+#define SW_IOURING_BUFFER_GROUP     0
+
+enum swIOUring_op
+{
+    SW_IOURING_OP_POLL = 0,
+    SW_IOURING_OP_RECV = 1,
+    SW_IOURING_OP_SEND = 2,
+};
+
+typedef struct swReactorIOUring_s swReactorIOUring;
+
+/**
+ * requests in flight of each fd
+ */
+typedef struct
+{
+    uint64_t poll;
+    uint64_t recv;
+    uint64_t send;
+    uint32_t poll_events;
+    /**
+     * cancelled recv/send may still complete with data, keep it for the same session
+     */
+    uint32_t cancel_session;
+    uint64_t recv_cancelled;
+    uint64_t send_cancelled;
+    uint8_t ready;
+} swIOUring_fd;
+
+static int swReactorIOUring_add(swReactor *reactor, int fd, int fdtype);
+static int swReactorIOUring_set(swReactor *reactor, int fd, int fdtype);
+static int swReactorIOUring_del(swReactor *reactor, int fd);
+static int swReactorIOUring_wait(swReactor *reactor, struct timeval *timeo);
+static void swReactorIOUring_free(swReactor *reactor);
+
+struct swReactorIOUring_s
+{
+    int ring_fd;
+    uint32_t to_submit;
+
+    /**
+     * the main reactor adds connections to the reactor threads,
+     * submission queue and request slots are protected by the lock.
+     */
+    sw_atomic_t lock;
+    pthread_t owner;
+
+    void *sq_ring;
+    size_t sq_ring_size;
+    void *cq_ring;
+    size_t cq_ring_size;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+
+    uint32_t *sq_head;
+    uint32_t *sq_tail;
+    uint32_t *sq_array;
+    uint32_t sq_mask;
+    uint32_t sq_entries;
+
+    uint32_t *cq_head;
+    uint32_t *cq_tail;
+    struct io_uring_cqe *cqes;
+    uint32_t cq_mask;
+
+    swIOUring_fd *fds;
+    uint32_t fds_size;
+    uint32_t seq;
+
+    /**
+     * completion mode: recv into the registered buffer ring, send from out_buffer
+     */
+    uint8_t completion;
+#ifdef SW_IOURING_COMPLETION
+    struct io_uring_buf_ring *buf_ring;
+    size_t buf_ring_size;
+    char *buffers;
+    uint32_t buffer_num;
+    uint32_t buffer_size;
+    uint16_t buffer_tail;
+#endif
+
+    /**
+     * sockets with pending completion data but without new request result
+     */
+    int *ready;
+    uint32_t ready_num;
+    uint32_t ready_size;
+};
+
+static sw_inline int swIOUring_setup(unsigned entries, struct io_uring_params *p)
+{
+    return syscall(__NR_io_uring_setup, entries, p);
+}
+
+static sw_inline int swIOUring_enter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags, void *arg, size_t argsz)
+{
+    return syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, arg, argsz);
+}
+
+static sw_inline int swIOUring_register(int ring_fd, unsigned opcode, void *arg, unsigned nr_args)
+{
+    return syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args);
+}
+
+static sw_inline uint32_t swReactorIOUring_event_set(int fdtype)
+{
+    uint32_t flag = 0;
+    if (swReactor_event_read(fdtype))
+    {
+        flag |= POLLIN;
+    }
+    if (swReactor_event_write(fdtype))
+    {
+        flag |= POLLOUT;
+    }
+    if (swReactor_event_error(fdtype))
+    {
+        flag |= (POLLRDHUP | POLLHUP | POLLERR);
+    }
+    return flag;
+}
+
+static sw_inline uint64_t swReactorIOUring_user_data(swReactorIOUring *object, int fd, int op, int fdtype)
+{
+    if ((++object->seq & SW_IOURING_SEQ_MASK) == 0)
+    {
+        object->seq++;
+    }
+    return (uint64_t) (uint32_t) fd | ((uint64_t) op << 32) | ((uint64_t) (fdtype & 0x3f) << 34)
+            | ((uint64_t) (object->seq & SW_IOURING_SEQ_MASK) << 40);
+}
+
+static int swReactorIOUring_submit(swReactorIOUring *object)
+{
+    if (object->to_submit == 0)
+    {
+        return SW_OK;
+    }
+    int ret = swIOUring_enter(object->ring_fd, object->to_submit, 0, 0, NULL, 0);
+    if (ret < 0)
+    {
+        return SW_ERR;
+    }
+    object->to_submit -= ret;
+    return SW_OK;
+}
+
+static struct io_uring_sqe* swReactorIOUring_get_sqe(swReactorIOUring *object)
+{
+    uint32_t tail = *object->sq_tail;
+    uint32_t head = __atomic_load_n(object->sq_head, __ATOMIC_ACQUIRE);
+
+    if (tail - head >= object->sq_entries)
+    {
+        if (swReactorIOUring_submit(object) < 0)
+        {
+            swSysError("io_uring_enter(submit) failed.");
+            return NULL;
+        }
+        head = __atomic_load_n(object->sq_head, __ATOMIC_ACQUIRE);
+        if (tail - head >= object->sq_entries)
+        {
+            swWarn("io_uring submission queue is full.");
+            return NULL;
+        }
+    }
+
+    uint32_t index = tail & object->sq_mask;
+    struct io_uring_sqe *sqe = &object->sqes[index];
+    bzero(sqe, sizeof(struct io_uring_sqe));
+    object->sq_array[index] = index;
+    return sqe;
+}
+
+static sw_inline void swReactorIOUring_commit_sqe(swReactorIOUring *object)
+{
+    __atomic_store_n(object->sq_tail, *object->sq_tail + 1, __ATOMIC_RELEASE);
+    object->to_submit++;
+}
+
+/**
+ * requests from the reactor's own thread are submitted in batch by wait(),
+ * other threads must submit immediately.
+ */
+static sw_inline void swReactorIOUring_unlock(swReactor *reactor, swReactorIOUring *object)
+{
+    if (reactor->start && !pthread_equal(object->owner, pthread_self()) && swReactorIOUring_submit(object) < 0)
+    {
+        swSysError("io_uring_enter(submit) failed.");
+    }
+    sw_spinlock_release(&object->lock);
+}
+
+static int swReactorIOUring_poll_add(swReactorIOUring *object, int fd, int fdtype, swIOUring_fd *req)
+{
+    struct io_uring_sqe *sqe = swReactorIOUring_get_sqe(object);
+    if (sqe == NULL)
+    {
+        return SW_ERR;
+    }
+    uint32_t events = swReactorIOUring_event_set(fdtype);
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+#if __BYTE_ORDER == __BIG_ENDIAN
+    sqe->poll32_events = (events << 16) | (events >> 16);
+#else
+    sqe->poll32_events = events;
+#endif
+    sqe->user_data = swReactorIOUring_user_data(object, fd, SW_IOURING_OP_POLL, swReactor_fdtype(fdtype));
+    swReactorIOUring_commit_sqe(object);
+    req->poll = sqe->user_data;
+    req->poll_events = events;
+    return SW_OK;
+}
+
+static int swReactorIOUring_cancel(swReactorIOUring *object, uint64_t *request, int op)
+{
+    if (*request == 0)
+    {
+        return SW_OK;
+    }
+    struct io_uring_sqe *sqe = swReactorIOUring_get_sqe(object);
+    if (sqe == NULL)
+    {
+        return SW_ERR;
+    }
+    sqe->opcode = op == SW_IOURING_OP_POLL ? IORING_OP_POLL_REMOVE : IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = *request;
+    sqe->user_data = SW_IOURING_IGNORE;
+    swReactorIOUring_commit_sqe(object);
+    *request = 0;
+    return SW_OK;
+}
+
+static swIOUring_fd* swReactorIOUring_get_fd(swReactorIOUring *object, int fd)
+{
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    if ((uint32_t) fd >= object->fds_size)
+    {
+        uint32_t size = object->fds_size;
+        while (size <= (uint32_t) fd)
+        {
+            size *= 2;
+        }
+        swIOUring_fd *fds = sw_realloc(object->fds, sizeof(swIOUring_fd) * size);
+        if (fds == NULL)
+        {
+            swWarn("realloc(%ld) failed.", sizeof(swIOUring_fd) * size);
+            return NULL;
+        }
+        bzero(fds + object->fds_size, sizeof(swIOUring_fd) * (size - object->fds_size));
+        object->fds = fds;
+        object->fds_size = size;
+    }
+    return &object->fds[fd];
+}
+
+#ifdef SW_IOURING_COMPLETION
+static sw_inline int swReactorIOUring_is_completion(swReactorIOUring *object, swConnection *socket, int fdtype)
+{
+    if (!object->completion || swReactor_fdtype(fdtype) != SW_FD_TCP)
+    {
+        return 0;
+    }
+#ifdef SW_USE_OPENSSL
+    if (socket->ssl)
+    {
+        return 0;
+    }
+#endif
+    return 1;
+}
+
+static sw_inline swBuffer_chunk* swReactorIOUring_send_chunk(swConnection *socket)
+{
+    if (swBuffer_empty(socket->out_buffer))
+    {
+        return NULL;
+    }
+    swBuffer_chunk *chunk = swBuffer_get_chunk(socket->out_buffer);
+    if (chunk->type != SW_CHUNK_DATA || chunk->offset >= chunk->length)
+    {
+        return NULL;
+    }
+    return chunk;
+}
+
+static int swReactorIOUring_recv_add(swReactorIOUring *object, int fd, int fdtype, swIOUring_fd *req)
+{
+    struct io_uring_sqe *sqe = swReactorIOUring_get_sqe(object);
+    if (sqe == NULL)
+    {
+        return SW_ERR;
+    }
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = SW_IOURING_BUFFER_GROUP;
+    sqe->user_data = swReactorIOUring_user_data(object, fd, SW_IOURING_OP_RECV, swReactor_fdtype(fdtype));
+    swReactorIOUring_commit_sqe(object);
+    req->recv = sqe->user_data;
+    return SW_OK;
+}
+
+static int swReactorIOUring_send_add(swReactorIOUring *object, int fd, int fdtype, swIOUring_fd *req, swBuffer_chunk *chunk)
+{
+    struct io_uring_sqe *sqe = swReactorIOUring_get_sqe(object);
+    if (sqe == NULL)
+    {
+        return SW_ERR;
+    }
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t) (uintptr_t) ((char *) chunk->store.ptr + chunk->offset);
+    sqe->len = chunk->length - chunk->offset;
+    sqe->user_data = swReactorIOUring_user_data(object, fd, SW_IOURING_OP_SEND, swReactor_fdtype(fdtype));
+    swReactorIOUring_commit_sqe(object);
+    req->send = sqe->user_data;
+    return SW_OK;
+}
+
+static sw_inline void swReactorIOUring_buffer_recycle(swReactorIOUring *object, uint16_t bid)
+{
+    struct io_uring_buf *buf = &object->buf_ring->bufs[object->buffer_tail & (object->buffer_num - 1)];
+    buf->addr = (uint64_t) (uintptr_t) (object->buffers + (size_t) bid * object->buffer_size);
+    buf->len = object->buffer_size;
+    buf->bid = bid;
+    object->buffer_tail++;
+    __atomic_store_n(&object->buf_ring->tail, object->buffer_tail, __ATOMIC_RELEASE);
+}
+
+static void swReactorIOUring_ready(swReactorIOUring *object, int fd, swIOUring_fd *req)
+{
+    if (req->ready)
+    {
+        return;
+    }
+    if (object->ready_num == object->ready_size)
+    {
+        uint32_t size = object->ready_size == 0 ? 64 : object->ready_size * 2;
+        int *ready = sw_realloc(object->ready, sizeof(int) * size);
+        if (ready == NULL)
+        {
+            swWarn("realloc(%ld) failed.", sizeof(int) * size);
+            return;
+        }
+        object->ready = ready;
+        object->ready_size = size;
+    }
+    object->ready[object->ready_num++] = fd;
+    req->ready = 1;
+}
+#endif
+
+/**
+ * arm the requests of the fd according to the events, keep those already in flight.
+ */
+static int swReactorIOUring_update(swReactor *reactor, swReactorIOUring *object, int fd, int fdtype, swIOUring_fd *req)
+{
+    int poll_type = fdtype;
+
+#ifdef SW_IOURING_COMPLETION
+    swConnection *socket = swReactor_get(reactor, fd);
+    if (swReactorIOUring_is_completion(object, socket, fdtype))
+    {
+        if (swReactor_event_read(fdtype))
+        {
+            if (req->recv == 0)
+            {
+                if (swReactorIOUring_recv_add(object, fd, fdtype, req) < 0)
+                {
+                    return SW_ERR;
+                }
+                socket->completion_recv = 1;
+            }
+            if (socket->completion)
+            {
+                swReactorIOUring_ready(object, fd, req);
+            }
+        }
+        else if (req->recv)
+        {
+            req->recv_cancelled = req->recv;
+            req->cancel_session = socket->session_id;
+            swReactorIOUring_cancel(object, &req->recv, SW_IOURING_OP_RECV);
+            socket->completion_recv = 0;
+        }
+
+        poll_type = 0;
+        if (swReactor_event_write(fdtype))
+        {
+            swBuffer_chunk *chunk = swReactorIOUring_send_chunk(socket);
+            if (req->send == 0 && chunk)
+            {
+                if (swReactorIOUring_send_add(object, fd, fdtype, req, chunk) < 0)
+                {
+                    return SW_ERR;
+                }
+            }
+            else if (req->send == 0)
+            {
+                //nothing to send, wait for writable
+                poll_type = swReactor_fdtype(fdtype) | SW_EVENT_WRITE | (fdtype & SW_EVENT_ERROR);
+            }
+        }
+        else if (req->send)
+        {
+            req->send_cancelled = req->send;
+            req->cancel_session = socket->session_id;
+            swReactorIOUring_cancel(object, &req->send, SW_IOURING_OP_SEND);
+        }
+
+        if (poll_type == 0)
+        {
+            return swReactorIOUring_cancel(object, &req->poll, SW_IOURING_OP_POLL);
+        }
+    }
+#endif
+
+    if (req->poll && req->poll_events == swReactorIOUring_event_set(poll_type))
+    {
+        return SW_OK;
+    }
+    if (swReactorIOUring_cancel(object, &req->poll, SW_IOURING_OP_POLL) < 0)
+    {
+        return SW_ERR;
+    }
+    return swReactorIOUring_poll_add(object, fd, poll_type, req);
+}
+
+int swReactorIOUring_create(swReactor *reactor, int max_event_num)
+{
+    struct io_uring_params params;
+    swReactorIOUring *reactor_object = sw_malloc(sizeof(swReactorIOUring));
+    if (reactor_object == NULL)
+    {
+        swWarn("malloc[0] failed.");
+        return SW_ERR;
+    }
+    bzero(reactor_object, sizeof(swReactorIOUring));
+
+    bzero(&params, sizeof(params));
+    reactor_object->ring_fd = swIOUring_setup(max_event_num, &params);
+    if (reactor_object->ring_fd < 0)
+    {
+        swWarn("io_uring_setup failed. Error: %s[%d]", strerror(errno), errno);
+        sw_free(reactor_object);
+        return SW_ERR;
+    }
+    /**
+     * timeout of io_uring_enter and lossless completion queue are required
+     */
+    if (!(params.features & IORING_FEAT_EXT_ARG) || !(params.features & IORING_FEAT_NODROP))
+    {
+        swWarn("io_uring reactor requires linux kernel version 5.11 or later.");
+        close(reactor_object->ring_fd);
+        sw_free(reactor_object);
+        return SW_ERR;
+    }
+
+    reactor_object->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    reactor_object->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    reactor_object->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        if (reactor_object->cq_ring_size > reactor_object->sq_ring_size)
+        {
+            reactor_object->sq_ring_size = reactor_object->cq_ring_size;
+        }
+        reactor_object->cq_ring_size = reactor_object->sq_ring_size;
+    }
+
+    reactor_object->sq_ring = mmap(NULL, reactor_object->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+            reactor_object->ring_fd, IORING_OFF_SQ_RING);
+    if (reactor_object->sq_ring == MAP_FAILED)
+    {
+        swSysError("mmap(IORING_OFF_SQ_RING) failed.");
+        goto _fail;
+    }
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        reactor_object->cq_ring = reactor_object->sq_ring;
+    }
+    else
+    {
+        reactor_object->cq_ring = mmap(NULL, reactor_object->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                reactor_object->ring_fd, IORING_OFF_CQ_RING);
+        if (reactor_object->cq_ring == MAP_FAILED)
+        {
+            swSysError("mmap(IORING_OFF_CQ_RING) failed.");
+            reactor_object->cq_ring = NULL;
+            goto _fail;
+        }
+    }
+    reactor_object->sqes = mmap(NULL, reactor_object->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+            reactor_object->ring_fd, IORING_OFF_SQES);
+    if (reactor_object->sqes == MAP_FAILED)
+    {
+        swSysError("mmap(IORING_OFF_SQES) failed.");
+        reactor_object->sqes = NULL;
+        goto _fail;
+    }
+
+    char *sq = (char *) reactor_object->sq_ring;
+    reactor_object->sq_head = (uint32_t *) (sq + params.sq_off.head);
+    reactor_object->sq_tail = (uint32_t *) (sq + params.sq_off.tail);
+    reactor_object->sq_array = (uint32_t *) (sq + params.sq_off.array);
+    reactor_object->sq_mask = *(uint32_t *) (sq + params.sq_off.ring_mask);
+    reactor_object->sq_entries = *(uint32_t *) (sq + params.sq_off.ring_entries);
+
+    char *cq = (char *) reactor_object->cq_ring;
+    reactor_object->cq_head = (uint32_t *) (cq + params.cq_off.head);
+    reactor_object->cq_tail = (uint32_t *) (cq + params.cq_off.tail);
+    reactor_object->cqes = (struct io_uring_cqe *) (cq + params.cq_off.cqes);
+    reactor_object->cq_mask = *(uint32_t *) (cq + params.cq_off.ring_mask);
+
+    reactor_object->fds_size = 1024;
+    reactor_object->fds = sw_calloc(reactor_object->fds_size, sizeof(swIOUring_fd));
+    if (reactor_object->fds == NULL)
+    {
+        swWarn("malloc[1] failed.");
+        goto _fail;
+    }
+
+    reactor->object = reactor_object;
+    reactor->max_event_num = max_event_num;
+
+    //binding method
+    reactor->add = swReactorIOUring_add;
+    reactor->set = swReactorIOUring_set;
+    reactor->del = swReactorIOUring_del;
+    reactor->wait = swReactorIOUring_wait;
+    reactor->free = swReactorIOUring_free;
+
+    return SW_OK;
+
+    _fail:
+    if (reactor_object->sqes)
+    {
+        munmap(reactor_object->sqes, reactor_object->sqes_size);
+    }
+    if (reactor_object->cq_ring && reactor_object->cq_ring != reactor_object->sq_ring)
+    {
+        munmap(reactor_object->cq_ring, reactor_object->cq_ring_size);
+    }
+    if (reactor_object->sq_ring && reactor_object->sq_ring != MAP_FAILED)
+    {
+        munmap(reactor_object->sq_ring, reactor_object->sq_ring_size);
+    }
+    close(reactor_object->ring_fd);
+    sw_free(reactor_object);
+    return SW_ERR;
+}
+
+#ifdef SW_IOURING_COMPLETION
+/**
+ * completion mode for connections of reactor thread
+ */
+int swReactorIOUring_enable_completion(swReactor *reactor, uint32_t buffer_num, uint32_t buffer_size)
+{
+    struct io_uring_buf_reg reg;
+
+    if (reactor->wait != swReactorIOUring_wait)
+    {
+        swWarn("completion mode requires the io_uring reactor.");
+        return SW_ERR;
+    }
+    swReactorIOUring *object = reactor->object;
+    if (object->completion)
+    {
+        return SW_OK;
+    }
+    if (buffer_num == 0 || (buffer_num & (buffer_num - 1)) != 0 || buffer_num > 32768)
+    {
+        swWarn("the number of registered buffers must be a power of 2 and not more than 32768.");
+        return SW_ERR;
+    }
+
+    object->buf_ring_size = sizeof(struct io_uring_buf) * buffer_num;
+    object->buf_ring = mmap(NULL, object->buf_ring_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if (object->buf_ring == MAP_FAILED)
+    {
+        swSysError("mmap(%ld) failed.", object->buf_ring_size);
+        object->buf_ring = NULL;
+        return SW_ERR;
+    }
+    object->buffers = sw_malloc((size_t) buffer_num * buffer_size);
+    if (object->buffers == NULL)
+    {
+        swWarn("malloc(%ld) failed.", (size_t) buffer_num * buffer_size);
+        goto _fail;
+    }
+
+    bzero(&reg, sizeof(reg));
+    reg.ring_addr = (uint64_t) (uintptr_t) object->buf_ring;
+    reg.ring_entries = buffer_num;
+    reg.bgid = SW_IOURING_BUFFER_GROUP;
+    if (swIOUring_register(object->ring_fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+    {
+        swWarn("io_uring_register(IORING_REGISTER_PBUF_RING) failed, requires linux kernel version 5.19 or later. Error: %s[%d]",
+                strerror(errno), errno);
+        goto _fail;
+    }
+
+    object->buffer_num = buffer_num;
+    object->buffer_size = buffer_size;
+    object->buffer_tail = 0;
+
+    uint32_t i;
+    for (i = 0; i < buffer_num; i++)
+    {
+        swReactorIOUring_buffer_recycle(object, i);
+    }
+    object->completion = 1;
+    return SW_OK;
+
+    _fail:
+    if (object->buffers)
+    {
+        sw_free(object->buffers);
+        object->buffers = NULL;
+    }
+    munmap(object->buf_ring, object->buf_ring_size);
+    object->buf_ring = NULL;
+    return SW_ERR;
+}
+#else
+int swReactorIOUring_enable_completion(swReactor *reactor, uint32_t buffer_num, uint32_t buffer_size)
+{
+    swWarn("completion mode is not supported, requires linux kernel headers 5.19 or later.");
+    return SW_ERR;
+}
+#endif
+
+static void swReactorIOUring_free(swReactor *reactor)
+{
+    swReactorIOUring *object = reactor->object;
+#ifdef SW_IOURING_COMPLETION
+    if (object->completion)
+    {
+        struct io_uring_buf_reg reg;
+        bzero(&reg, sizeof(reg));
+        reg.bgid = SW_IOURING_BUFFER_GROUP;
+        swIOUring_register(object->ring_fd, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+        munmap(object->buf_ring, object->buf_ring_size);
+        sw_free(object->buffers);
+    }
+#endif
+    munmap(object->sqes, object->sqes_size);
+    if (object->cq_ring != object->sq_ring)
+    {
+        munmap(object->cq_ring, object->cq_ring_size);
+    }
+    munmap(object->sq_ring, object->sq_ring_size);
+    close(object->ring_fd);
+    if (object->ready)
+    {
+        sw_free(object->ready);
+    }
+    sw_free(object->fds);
+    sw_free(object);
+    swReactor_free_defer_tasks(reactor);
+}
+
+static int swReactorIOUring_add(swReactor *reactor, int fd, int fdtype)
+{
+    swReactorIOUring *object = reactor->object;
+
+    sw_spinlock(&object->lock);
+    swIOUring_fd *req = swReactorIOUring_get_fd(object, fd);
+    if (req == NULL)
+    {
+        sw_spinlock_release(&object->lock);
+        return SW_ERR;
+    }
+
+    swReactor_add(reactor, fd, fdtype);
+
+    if (swReactorIOUring_update(reactor, object, fd, fdtype, req) < 0)
+    {
+        sw_spinlock_release(&object->lock);
+        swWarn("add events[fd=%d#%d, type=%d] failed.", fd, reactor->id, swReactor_fdtype(fdtype));
+        swReactor_del(reactor, fd);
+        return SW_ERR;
+    }
+    swReactorIOUring_unlock(reactor, object);
+
+    swTraceLog(SW_TRACE_EVENT, "add event[reactor_id=%d, fd=%d, events=%d]", reactor->id, fd, swReactor_events(fdtype));
+    reactor->event_num++;
+
+    return SW_OK;
+}
+
+static int swReactorIOUring_del(swReactor *reactor, int fd)
+{
+    swReactorIOUring *object = reactor->object;
+
+    sw_spinlock(&object->lock);
+    swIOUring_fd *req = swReactorIOUring_get_fd(object, fd);
+    if (req == NULL || swReactorIOUring_cancel(object, &req->poll, SW_IOURING_OP_POLL) < 0)
+    {
+        sw_spinlock_release(&object->lock);
+        swWarn("io_uring remove fd[%d#%d] failed.", fd, reactor->id);
+        return SW_ERR;
+    }
+    if (req->recv || req->send)
+    {
+        swConnection *socket = swReactor_get(reactor, fd);
+        req->cancel_session = socket->session_id;
+        req->recv_cancelled = req->recv;
+        req->send_cancelled = req->send;
+        swReactorIOUring_cancel(object, &req->recv, SW_IOURING_OP_RECV);
+        swReactorIOUring_cancel(object, &req->send, SW_IOURING_OP_SEND);
+        socket->completion_recv = 0;
+    }
+    /**
+     * the kernel holds a reference of the file until the requests are removed,
+     * submit now because the fd is usually closed right after del().
+     */
+    if (swReactorIOUring_submit(object) < 0)
+    {
+        swSysError("io_uring_enter(submit) failed.");
+    }
+    sw_spinlock_release(&object->lock);
+
+    swTraceLog(SW_TRACE_REACTOR, "remove event[reactor_id=%d|fd=%d]", reactor->id, fd);
+    reactor->event_num = reactor->event_num <= 0 ? 0 : reactor->event_num - 1;
+    swReactor_del(reactor, fd);
+
+    return SW_OK;
+}
+
+static int swReactorIOUring_set(swReactor *reactor, int fd, int fdtype)
+{
+    swReactorIOUring *object = reactor->object;
+
+    if (swReactor_event_write(fdtype))
+    {
+        assert(fd > 2);
+    }
+
+    sw_spinlock(&object->lock);
+    swIOUring_fd *req = swReactorIOUring_get_fd(object, fd);
+    if (req == NULL || swReactorIOUring_update(reactor, object, fd, fdtype, req) < 0)
+    {
+        sw_spinlock_release(&object->lock);
+        swWarn("reactor#%d->set(fd=%d|type=%d) failed.", reactor->id, fd, swReactor_fdtype(fdtype));
+        return SW_ERR;
+    }
+    swReactorIOUring_unlock(reactor, object);
+
+    swTraceLog(SW_TRACE_EVENT, "set event[reactor_id=%d, fd=%d, events=%d]", reactor->id, fd, swReactor_events(fdtype));
+    //execute parent method
+    swReactor_set(reactor, fd, fdtype);
+    return SW_OK;
+}
+
+/**
+ * arm the requests again after the handlers, they are all oneshot
+ */
+static void swReactorIOUring_rearm(swReactor *reactor, swReactorIOUring *object, swEvent *event)
+{
+    if (event->socket->removed)
+    {
+        return;
+    }
+    sw_spinlock(&object->lock);
+    swReactorIOUring_update(reactor, object, event->fd, event->type | event->socket->events, &object->fds[event->fd]);
+    sw_spinlock_release(&object->lock);
+}
+
+static void swReactorIOUring_onPoll(swReactor *reactor, swReactorIOUring *object, swEvent *event, uint32_t revents)
+{
+    swReactor_handle handle;
+
+    //read
+    if ((revents & POLLIN) && !event->socket->removed)
+    {
+        handle = swReactor_getHandle(reactor, SW_EVENT_READ, event->type);
+        if (swReactor_call(reactor, handle, event) < 0)
+        {
+            swSysError("POLLIN handle failed. fd=%d.", event->fd);
+        }
+    }
+    //write
+    if ((revents & POLLOUT) && !event->socket->removed)
+    {
+        handle = swReactor_getHandle(reactor, SW_EVENT_WRITE, event->type);
+        if (swReactor_call(reactor, handle, event) < 0)
+        {
+            swSysError("POLLOUT handle failed. fd=%d.", event->fd);
+        }
+    }
+    //error
+    if ((revents & (POLLRDHUP | POLLERR | POLLHUP)) && !event->socket->removed && !(revents & (POLLIN | POLLOUT)))
+    {
+        handle = swReactor_getHandle(reactor, SW_EVENT_ERROR, event->type);
+        if (swReactor_call(reactor, handle, event) < 0)
+        {
+            swSysError("POLLERR handle failed. fd=%d.", event->fd);
+        }
+    }
+    if (!event->socket->removed && (event->socket->events & SW_EVENT_ONCE))
+    {
+        reactor->event_num = reactor->event_num <= 0 ? 0 : reactor->event_num - 1;
+        swReactor_del(reactor, event->fd);
+        return;
+    }
+    swReactorIOUring_rearm(reactor, object, event);
+}
+
+#ifdef SW_IOURING_COMPLETION
+/**
+ * keep the data which is not consumed by the protocol
+ */
+static void swReactorIOUring_stash(swConnection *socket, char *data, int length)
+{
+    int remain = socket->completion ? socket->completion_length : 0;
+    if (remain < 0)
+    {
+        remain = 0;
+    }
+    char *stash = sw_malloc(remain + length);
+    if (stash == NULL)
+    {
+        swWarn("malloc(%d) failed.", remain + length);
+        return;
+    }
+    if (remain > 0)
+    {
+        memcpy(stash, socket->completion_data, remain);
+    }
+    memcpy(stash + remain, data, length);
+    if (socket->completion_stash)
+    {
+        sw_free(socket->completion_stash);
+    }
+    socket->completion = 1;
+    socket->completion_stash = stash;
+    socket->completion_data = stash;
+    socket->completion_length = remain + length;
+}
+
+/**
+ * the protocol handler consumes the data through swConnection_recv()
+ */
+static void swReactorIOUring_consume(swReactor *reactor, swEvent *event)
+{
+    swReactor_handle handle = swReactor_getHandle(reactor, SW_EVENT_READ, event->type);
+    swConnection *socket = event->socket;
+    int length;
+
+    while (socket->completion && !socket->removed)
+    {
+        length = socket->completion_length;
+        if (swReactor_call(reactor, handle, event) < 0)
+        {
+            swSysError("recv handle failed. fd=%d.", event->fd);
+        }
+        if (socket->completion && socket->completion_length == length)
+        {
+            break;
+        }
+    }
+}
+
+static void swReactorIOUring_onRecv(swReactor *reactor, swReactorIOUring *object, swEvent *event, int32_t res, uint32_t flags)
+{
+    swConnection *socket = event->socket;
+    char *data = NULL;
+
+    socket->completion_recv = 0;
+
+    /**
+     * the buffer ring is exhausted, receive it by the handler itself
+     */
+    if (res == -ENOBUFS)
+    {
+        swReactor_handle handle = swReactor_getHandle(reactor, SW_EVENT_READ, event->type);
+        if (swReactor_call(reactor, handle, event) < 0)
+        {
+            swSysError("recv handle failed. fd=%d.", event->fd);
+        }
+        swReactorIOUring_rearm(reactor, object, event);
+        return;
+    }
+
+    if (flags & IORING_CQE_F_BUFFER)
+    {
+        data = object->buffers + (size_t) (flags >> IORING_CQE_BUFFER_SHIFT) * object->buffer_size;
+    }
+    if (socket->completion && res > 0)
+    {
+        swReactorIOUring_stash(socket, data, res);
+    }
+    else if (!socket->completion)
+    {
+        socket->completion = 1;
+        socket->completion_data = data;
+        socket->completion_length = res;
+    }
+
+    swReactorIOUring_consume(reactor, event);
+
+    if (data)
+    {
+        if (socket->completion && socket->completion_length > 0 && socket->completion_stash == NULL)
+        {
+            swReactorIOUring_stash(socket, socket->completion_data, 0);
+        }
+        swReactorIOUring_buffer_recycle(object, flags >> IORING_CQE_BUFFER_SHIFT);
+    }
+    swReactorIOUring_rearm(reactor, object, event);
+}
+
+static void swReactorIOUring_onSend(swReactor *reactor, swReactorIOUring *object, swEvent *event, int32_t res)
+{
+    swConnection *socket = event->socket;
+    swBuffer_chunk *chunk;
+
+    if (res > 0 && !swBuffer_empty(socket->out_buffer))
+    {
+        chunk = swBuffer_get_chunk(socket->out_buffer);
+        chunk->offset += res;
+        if (chunk->offset >= chunk->length)
+        {
+            swBuffer_pop_chunk(socket->out_buffer, chunk);
+        }
+#ifdef SW_DEBUG
+        socket->total_send_bytes += res;
+#endif
+    }
+    /**
+     * errors, close chunk, sendfile chunk and empty buffer are handled by the write handler
+     */
+    if (res < 0 || swReactorIOUring_send_chunk(socket) == NULL)
+    {
+        errno = -res;
+        swReactor_handle handle = swReactor_getHandle(reactor, SW_EVENT_WRITE, event->type);
+        if (swReactor_call(reactor, handle, event) < 0)
+        {
+            swSysError("send handle failed. fd=%d.", event->fd);
+        }
+    }
+    swReactorIOUring_rearm(reactor, object, event);
+}
+
+/**
+ * cancelled requests may have been completed, their data belongs to the connection if it is still alive.
+ * called with object->lock held, another thread may grow object->fds in reactor->add()
+ */
+static void swReactorIOUring_onCancelled(swReactor *reactor, swReactorIOUring *object, int fd, uint64_t user_data,
+        int32_t res, uint32_t flags)
+{
+    swConnection *socket = swReactor_get(reactor, fd);
+    swIOUring_fd *req = &object->fds[fd];
+    int op = (user_data >> 32) & 0x3;
+    int alive = socket->active && socket->session_id == req->cancel_session;
+
+    if (op == SW_IOURING_OP_RECV && user_data == req->recv_cancelled)
+    {
+        req->recv_cancelled = 0;
+        if (alive && res > 0 && (flags & IORING_CQE_F_BUFFER))
+        {
+            swReactorIOUring_stash(socket, object->buffers + (size_t) (flags >> IORING_CQE_BUFFER_SHIFT) * object->buffer_size, res);
+        }
+    }
+    else if (op == SW_IOURING_OP_SEND && user_data == req->send_cancelled)
+    {
+        req->send_cancelled = 0;
+        if (alive && res > 0 && !swBuffer_empty(socket->out_buffer))
+        {
+            swBuffer_chunk *chunk = swBuffer_get_chunk(socket->out_buffer);
+            chunk->offset += res;
+            if (chunk->offset >= chunk->length)
+            {
+                swBuffer_pop_chunk(socket->out_buffer, chunk);
+            }
+        }
+    }
+    if (op == SW_IOURING_OP_RECV && (flags & IORING_CQE_F_BUFFER))
+    {
+        swReactorIOUring_buffer_recycle(object, flags >> IORING_CQE_BUFFER_SHIFT);
+    }
+}
+
+static void swReactorIOUring_onReady(swReactor *reactor, swReactorIOUring *object)
+{
+    swEvent event;
+    uint32_t i;
+    int fd;
+
+    sw_spinlock(&object->lock);
+    uint32_t ready_num = object->ready_num;
+    int ready[ready_num];
+    memcpy(ready, object->ready, sizeof(int) * ready_num);
+    for (i = 0; i < ready_num; i++)
+    {
+        object->fds[ready[i]].ready = 0;
+    }
+    object->ready_num = 0;
+    sw_spinlock_release(&object->lock);
+
+    for (i = 0; i < ready_num; i++)
+    {
+        fd = ready[i];
+        event.fd = fd;
+        event.from_id = reactor->id;
+        event.socket = swReactor_get(reactor, fd);
+        event.type = event.socket->fdtype;
+        swReactorIOUring_consume(reactor, &event);
+    }
+}
+#endif
+
+static int swReactorIOUring_wait(swReactor *reactor, struct timeval *timeo)
+{
+    swEvent event;
+    swReactorIOUring *object = reactor->object;
+    struct io_uring_cqe *cqe;
+    struct io_uring_getevents_arg arg;
+    struct __kernel_timespec ts;
+    uint32_t head, tail, flags, to_submit;
+    uint64_t user_data;
+    int32_t res;
+    int n, ret, msec, op, timed_out;
+    int64_t timeout_deadline = -1;
+
+    int reactor_id = reactor->id;
+
+    if (reactor->timeout_msec == 0)
+    {
+        if (timeo == NULL)
+        {
+            reactor->timeout_msec = -1;
+        }
+        else
+        {
+            reactor->timeout_msec = timeo->tv_sec * 1000 + timeo->tv_usec / 1000;
+        }
+    }
+
+    object->owner = pthread_self();
+    reactor->start = 1;
+
+    while (reactor->running > 0)
+    {
+        if (reactor->onBegin != NULL)
+        {
+            reactor->onBegin(reactor);
+        }
+        msec = object->ready_num > 0 ? 0 : reactor->timeout_msec;
+        //woken up by the stale completions, wait for the rest of the timeout
+        if (msec > 0)
+        {
+            if (timeout_deadline < 0)
+            {
+                timeout_deadline = swReactor_now_msec(reactor) + msec;
+            }
+            else
+            {
+                msec = timeout_deadline - swReactor_now_msec(reactor);
+                msec = msec < 0 ? 0 : msec;
+            }
+        }
+
+        bzero(&arg, sizeof(arg));
+        if (msec >= 0)
+        {
+            ts.tv_sec = msec / 1000;
+            ts.tv_nsec = (msec % 1000) * 1000 * 1000;
+            arg.ts = (uint64_t) (uintptr_t) &ts;
+        }
+
+        sw_spinlock(&object->lock);
+        to_submit = object->to_submit;
+        object->to_submit = 0;
+        sw_spinlock_release(&object->lock);
+
+        ret = swIOUring_enter(object->ring_fd, to_submit, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+        timed_out = ret < 0 && errno == ETIME;
+        swReactor_update_time(reactor);
+        if (ret < (int) to_submit)
+        {
+            sw_spinlock(&object->lock);
+            object->to_submit += to_submit - (ret < 0 ? 0 : ret);
+            sw_spinlock_release(&object->lock);
+        }
+        if (ret < 0 && errno != ETIME && swReactor_error(reactor) < 0)
+        {
+            swWarn("[Reactor#%d] io_uring_enter failed. Error: %s[%d]", reactor_id, strerror(errno), errno);
+            return SW_ERR;
+        }
+
+        n = 0;
+#ifdef SW_IOURING_COMPLETION
+        if (object->ready_num > 0)
+        {
+            n++;
+            swReactorIOUring_onReady(reactor, object);
+        }
+#endif
+        head = *object->cq_head;
+        tail = __atomic_load_n(object->cq_tail, __ATOMIC_ACQUIRE);
+
+        for (; head != tail; head++)
+        {
+            cqe = &object->cqes[head & object->cq_mask];
+            user_data = cqe->user_data;
+            res = cqe->res;
+            flags = cqe->flags;
+            /**
+             * release the slot before calling the handler, it may submit new requests
+             */
+            __atomic_store_n(object->cq_head, head + 1, __ATOMIC_RELEASE);
+
+            if (user_data == SW_IOURING_IGNORE)
+            {
+                continue;
+            }
+
+            event.fd = (uint32_t) user_data;
+            op = (user_data >> 32) & 0x3;
+
+            sw_spinlock(&object->lock);
+            swIOUring_fd *req = event.fd < object->fds_size ? &object->fds[event.fd] : NULL;
+            uint64_t *request = req == NULL ? NULL :
+                    (op == SW_IOURING_OP_POLL ? &req->poll : (op == SW_IOURING_OP_RECV ? &req->recv : &req->send));
+            if (request == NULL || *request != user_data)
+            {
+#ifdef SW_IOURING_COMPLETION
+                if (req && op != SW_IOURING_OP_POLL)
+                {
+                    swReactorIOUring_onCancelled(reactor, object, event.fd, user_data, res, flags);
+                }
+#endif
+                sw_spinlock_release(&object->lock);
+                continue;
+            }
+            //the oneshot request is consumed
+            *request = 0;
+            sw_spinlock_release(&object->lock);
+
+            event.type = (user_data >> 34) & 0x3f;
+            event.from_id = reactor_id;
+            event.socket = swReactor_get(reactor, event.fd);
+            n++;
+
+#ifdef SW_IOURING_COMPLETION
+            if (op == SW_IOURING_OP_RECV)
+            {
+                swReactorIOUring_onRecv(reactor, object, &event, res, flags);
+                continue;
+            }
+            else if (op == SW_IOURING_OP_SEND)
+            {
+                swReactorIOUring_onSend(reactor, object, &event, res);
+                continue;
+            }
+#endif
+            if (res < 0)
+            {
+                swReactorIOUring_rearm(reactor, object, &event);
+                continue;
+            }
+            swReactorIOUring_onPoll(reactor, object, &event, res);
+        }
+
+        if (n == 0)
+        {
+            //the cancelled and ignored completions are not events
+            if (!timed_out && (timeout_deadline < 0 || swReactor_now_msec(reactor) < timeout_deadline))
+            {
+                continue;
+            }
+            timeout_deadline = -1;
+            if (reactor->onTimeout != NULL)
+            {
+                reactor->onTimeout(reactor);
+            }
+            continue;
+        }
+        timeout_deadline = -1;
+
+        if (reactor->onFinish != NULL)
+        {
+            reactor->onFinish(reactor);
+        }
+        if (reactor->once)
+        {
+            break;
+        }
+    }
+    return 0;
+}
+
+#endif
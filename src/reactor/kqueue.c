@@ -104,6 +104,7 @@ static void swReactorKqueue_free(swReactor *reactor)
     close(this->epfd);
     sw_free(this->events);
     sw_free(this);
+    swReactor_free_defer_tasks(reactor);
 }
 
 static int swReactorKqueue_add(swReactor *reactor, int fd, int fdtype)
@@ -300,6 +301,7 @@ static int swReactorKqueue_wait(swReactor *reactor, struct timeval *timeo)
         }
 
         n = kevent(object->epfd, NULL, 0, object->events, object->event_max, t_ptr);
+        swReactor_update_time(reactor);
         if (n < 0)
         {
             swTrace("kqueue error.EP=%d | Errno=%d\n", object->epfd, errno);
@@ -336,7 +338,7 @@ static int swReactorKqueue_wait(swReactor *reactor, struct timeval *timeo)
                         continue;
                     }
                     handle = swReactor_getHandle(reactor, SW_EVENT_READ, event.type);
-                    ret = handle(reactor, &event);
+                    ret = swReactor_call(reactor, handle, &event);
                     if (ret < 0)
                     {
                         swSysError("kqueue event read socket#%d handler failed.", event.fd);
@@ -351,7 +353,7 @@ static int swReactorKqueue_wait(swReactor *reactor, struct timeval *timeo)
                         continue;
                     }
                     handle = swReactor_getHandle(reactor, SW_EVENT_WRITE, event.type);
-                    ret = handle(reactor, &event);
+                    ret = swReactor_call(reactor, handle, &event);
                     if (ret < 0)
                     {
                         swSysError("kqueue event write socket#%d handler failed.", event.fd);
@@ -80,6 +80,7 @@ static void swReactorPoll_free(swReactor *reactor)
     swReactorPoll *object = reactor->object;
     sw_free(object->fds);
     sw_free(reactor->object);
+    swReactor_free_defer_tasks(reactor);
 }
 
 static int swReactorPoll_add(swReactor *reactor, int fd, int fdtype)
@@ -216,6 +217,7 @@ static int swReactorPoll_wait(swReactor *reactor, struct timeval *timeo)
         }
         msec = reactor->timeout_msec;
         ret = poll(object->events, reactor->event_num, msec);
+        swReactor_update_time(reactor);
         if (ret < 0)
         {
             if (swReactor_error(reactor) < 0)
@@ -246,7 +248,7 @@ static int swReactorPoll_wait(swReactor *reactor, struct timeval *timeo)
                 if ((object->events[i].revents & POLLIN) && !event.socket->removed)
                 {
                     handle = swReactor_getHandle(reactor, SW_EVENT_READ, event.type);
-                    ret = handle(reactor, &event);
+                    ret = swReactor_call(reactor, handle, &event);
                     if (ret < 0)
                     {
                         swWarn("poll[POLLIN] handler failed. fd=%d. Error: %s[%d]", event.fd, strerror(errno), errno);
@@ -256,7 +258,7 @@ static int swReactorPoll_wait(swReactor *reactor, struct timeval *timeo)
                 if ((object->events[i].revents & POLLOUT) && !event.socket->removed)
                 {
                     handle = swReactor_getHandle(reactor, SW_EVENT_WRITE, event.type);
-                    ret = handle(reactor, &event);
+                    ret = swReactor_call(reactor, handle, &event);
                     if (ret < 0)
                     {
                         swWarn("poll[POLLOUT] handler failed. fd=%d. Error: %s[%d]", event.fd, strerror(errno), errno);
@@ -271,7 +273,7 @@ static int swReactorPoll_wait(swReactor *reactor, struct timeval *timeo)
                         continue;
                     }
                     handle = swReactor_getHandle(reactor, SW_EVENT_ERROR, event.type);
-                    ret = handle(reactor, &event);
+                    ret = swReactor_call(reactor, handle, &event);
                     if (ret < 0)
                     {
                         swWarn("poll[POLLERR] handler failed. fd=%d. Error: %s[%d]", event.fd, strerror(errno), errno);
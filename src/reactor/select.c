@@ -79,6 +79,7 @@ void swReactorSelect_free(swReactor *reactor)
         sw_free(ev);
     }
     sw_free(reactor->object);
+    swReactor_free_defer_tasks(reactor);
 }
 
 int swReactorSelect_add(swReactor *reactor, int fd, int fdtype)
@@ -216,6 +217,7 @@ int swReactorSelect_wait(swReactor *reactor, struct timeval *timeo)
         }
 
         ret = select(object->maxfd + 1, &(object->rfds), &(object->wfds), &(object->efds), &timeout);
+        swReactor_update_time(reactor);
         if (ret < 0)
         {
             if (swReactor_error(reactor) < 0)
@@ -245,7 +247,7 @@ int swReactorSelect_wait(swReactor *reactor, struct timeval *timeo)
                 if (SW_FD_ISSET(event.fd, &(object->rfds)) && !event.socket->removed)
                 {
                     handle = swReactor_getHandle(reactor, SW_EVENT_READ, event.type);
-                    ret = handle(reactor, &event);
+                    ret = swReactor_call(reactor, handle, &event);
                     if (ret < 0)
                     {
                         swSysError("[Reactor#%d] select event[type=READ, fd=%d] handler fail.", reactor->id, event.fd);
@@ -255,7 +257,7 @@ int swReactorSelect_wait(swReactor *reactor, struct timeval *timeo)
                 if (SW_FD_ISSET(event.fd, &(object->wfds)) && !event.socket->removed)
                 {
                     handle = swReactor_getHandle(reactor, SW_EVENT_WRITE, event.type);
-                    ret = handle(reactor, &event);
+                    ret = swReactor_call(reactor, handle, &event);
                     if (ret < 0)
                     {
                         swSysError("[Reactor#%d] select event[type=WRITE, fd=%d] handler fail.", reactor->id, event.fd);
@@ -265,7 +267,7 @@ int swReactorSelect_wait(swReactor *reactor, struct timeval *timeo)
                 if (SW_FD_ISSET(event.fd, &(object->efds)) && !event.socket->removed)
                 {
                     handle = swReactor_getHandle(reactor, SW_EVENT_ERROR, event.type);
-                    ret = handle(reactor, &event);
+                    ret = swReactor_call(reactor, handle, &event);
                     if (ret < 0)
                     {
                         swSysError("[Reactor#%d] select event[type=ERROR, fd=%d] handler fail.", reactor->id, event.fd);
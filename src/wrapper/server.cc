@@ -133,12 +133,20 @@ namespace swoole
         int ret;
         if (!swIsWorker())
         {
-            swWorker *worker = swServer_get_worker(&serv, conn->fd % serv.worker_num);
+            swWorker *worker = swServer_get_worker(&serv, conn->fd % swServer_run_worker_num(&serv));
             swDataHead ev;
             ev.type = SW_EVENT_CLOSE;
             ev.fd = fd;
             ev.from_id = conn->from_id;
+            if (serv.enable_reactor_steal)
+            {
+                sw_atomic_fetch_add(&conn->route, 1);
+            }
             ret = swWorker_send2worker(worker, &ev, sizeof(ev), SW_PIPE_MASTER);
+            if (ret < 0)
+            {
+                swServer_connection_route_release(&serv, conn);
+            }
         }
         else
         {
@@ -183,6 +191,13 @@ namespace swoole
             swPackage_task _pkg;
             memcpy(&_pkg, task_result->data, sizeof(_pkg));
 
+            if (_pkg.data)
+            {
+                retval.copy(_pkg.data, (size_t) _pkg.length);
+                SwooleG.serv->task_pool->free(SwooleG.serv->task_pool, _pkg.data);
+                return retval;
+            }
+
             int tmp_file_fd = open(_pkg.tmpfile, O_RDONLY);
             if (tmp_file_fd < 0)
             {
@@ -212,7 +227,6 @@ namespace swoole
         int data_len;
         DataBuffer retval;
 
-#ifdef SW_USE_RINGBUFFER
         swPackage package;
         if (req->info.type == SW_EVENT_PACKAGE)
         {
@@ -220,14 +234,12 @@ namespace swoole
             data_ptr = (char *) package.data;
             data_len = package.length;
         }
-#else
-        if (req->info.type == SW_EVENT_PACKAGE_END)
+        else if (req->info.type == SW_EVENT_PACKAGE_END)
         {
             swString *worker_buffer = swWorker_get_buffer(SwooleG.serv, req->info.from_id);
             data_ptr = worker_buffer->str;
             data_len = worker_buffer->length;
         }
-#endif
         else
         {
             data_ptr = req->data;
@@ -247,14 +259,6 @@ namespace swoole
         {
             memcpy(header, data_ptr, header_length);
         }
-
-#ifdef SW_USE_RINGBUFFER
-        if (req->info.type == SW_EVENT_PACKAGE)
-        {
-            swReactorThread *thread = swServer_get_thread(SwooleG.serv, req->info.from_id);
-            thread->buffer_input->free(thread->buffer_input, data_ptr);
-        }
-#endif
         return retval;
     }
 
@@ -414,6 +418,12 @@ namespace swoole
             return false;
         }
 
+        if (!swServer_worker_is_running(&serv, worker_id))
+        {
+            swWarn("worker_id[%d] is stopped by the autoscaling.", worker_id);
+            return false;
+        }
+
         if (serv.onPipeMessage == NULL)
         {
             swWarn("onPipeMessage is null, cannot use sendMessage.");
@@ -132,12 +132,15 @@ ZEND_BEGIN_ARG_INFO_EX(arginfo_swoole_server_task, 0, 0, 1)
     ZEND_ARG_INFO(0, data)
     ZEND_ARG_INFO(0, worker_id)
     ZEND_ARG_INFO(0, finish_callback)
+    ZEND_ARG_INFO(0, priority)
+    ZEND_ARG_INFO(0, timeout)
 ZEND_END_ARG_INFO()
 
 ZEND_BEGIN_ARG_INFO_EX(arginfo_swoole_server_taskwait, 0, 0, 1)
     ZEND_ARG_INFO(0, data)
     ZEND_ARG_INFO(0, timeout)
     ZEND_ARG_INFO(0, worker_id)
+    ZEND_ARG_INFO(0, priority)
 ZEND_END_ARG_INFO()
 
 #ifdef SW_COROUTINE
@@ -152,6 +155,12 @@ ZEND_BEGIN_ARG_INFO_EX(arginfo_swoole_server_taskWaitMulti_oo, 0, 0, 1)
     ZEND_ARG_INFO(0, timeout)
 ZEND_END_ARG_INFO()
 
+ZEND_BEGIN_ARG_INFO_EX(arginfo_swoole_server_taskBatch, 0, 0, 1)
+    ZEND_ARG_ARRAY_INFO(0, tasks, 0)
+    ZEND_ARG_INFO(0, worker_id)
+    ZEND_ARG_INFO(0, finish_callback)
+ZEND_END_ARG_INFO()
+
 ZEND_BEGIN_ARG_INFO_EX(arginfo_swoole_server_finish_oo, 0, 0, 1)
     ZEND_ARG_INFO(0, data)
 ZEND_END_ARG_INFO()
@@ -440,6 +449,7 @@ static zend_function_entry swoole_server_methods[] = {
     PHP_ME(swoole_server, task, arginfo_swoole_server_task, ZEND_ACC_PUBLIC)
     PHP_ME(swoole_server, taskwait, arginfo_swoole_server_taskwait, ZEND_ACC_PUBLIC)
     PHP_ME(swoole_server, taskWaitMulti, arginfo_swoole_server_taskWaitMulti_oo, ZEND_ACC_PUBLIC)
+    PHP_ME(swoole_server, taskBatch, arginfo_swoole_server_taskBatch, ZEND_ACC_PUBLIC)
 #ifdef SW_COROUTINE
     PHP_ME(swoole_server, taskCo, arginfo_swoole_server_taskCo, ZEND_ACC_PUBLIC)
 #endif
@@ -902,6 +912,13 @@ PHP_MINIT_FUNCTION(swoole)
     REGISTER_LONG_CONSTANT("SWOOLE_IPC_MSGQUEUE", SW_TASK_IPC_MSGQUEUE, CONST_CS | CONST_PERSISTENT);
     REGISTER_LONG_CONSTANT("SWOOLE_IPC_PREEMPTIVE", SW_TASK_IPC_PREEMPTIVE, CONST_CS | CONST_PERSISTENT);
 
+    /**
+     * accept mode
+     */
+    REGISTER_LONG_CONSTANT("SWOOLE_ACCEPT_MASTER", SW_ACCEPT_MASTER, CONST_CS | CONST_PERSISTENT);
+    REGISTER_LONG_CONSTANT("SWOOLE_ACCEPT_REUSEPORT", SW_ACCEPT_REUSEPORT, CONST_CS | CONST_PERSISTENT);
+    REGISTER_LONG_CONSTANT("SWOOLE_ACCEPT_EXCLUSIVE", SW_ACCEPT_EXCLUSIVE, CONST_CS | CONST_PERSISTENT);
+
     /**
      * socket type
      */
@@ -1070,6 +1087,7 @@ PHP_MINIT_FUNCTION(swoole)
     SWOOLE_DEFINE(IPC_NONE);
     SWOOLE_DEFINE(IPC_UNIXSOCK);
     SWOOLE_DEFINE(IPC_SOCKET);
+    SWOOLE_DEFINE(IPC_RING);
 
     //swoole_server 定义
     //SWOOLE_INIT_CLASS_ENTRY 宏展开是
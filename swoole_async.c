@@ -875,6 +875,18 @@ PHP_FUNCTION(swoole_async_set)
         convert_to_boolean(v);
         SwooleG.enable_signalfd = Z_BVAL_P(v);
     }
+    if (php_swoole_array_get_value(vht, "timer_wheel", v))
+    {
+        convert_to_boolean(v);
+        if (SwooleG.timer.fd != 0)
+        {
+            swoole_php_fatal_error(E_WARNING, "the timer is already initialized, timer_wheel is ignored.");
+        }
+        else
+        {
+            SwooleG.enable_timer_wheel = Z_BVAL_P(v);
+        }
+    }
     if (php_swoole_array_get_value(vht, "dns_cache_refresh_time", v))
     {
           convert_to_double(v);
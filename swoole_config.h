@@ -98,6 +98,14 @@
 #define SW_SENDFILE_CHUNK_SIZE     65536
 
 #define SW_SENDFILE_MAXLEN         4194304
+/**
+ * the output buffer is flushed with writev, the max number of chunks of one syscall
+ */
+#if defined(IOV_MAX) && IOV_MAX < 1024
+#define SW_IOV_MAX                 IOV_MAX
+#else
+#define SW_IOV_MAX                 1024
+#endif
 
 #define SW_HASHMAP_KEY_MAXLEN      256
 #define SW_HASHMAP_INIT_BUCKET_N   32  //hashmap初始化时创建32大小的桶
@@ -106,6 +114,15 @@
 #define SW_DATA_EOF_MAXLEN         8
 
 #define SW_TASKWAIT_TIMEOUT        0.5
+#define SW_TASK_PRIORITY_NUM       8    //task_ipc_mode=3, the larger priority is popped first, 16 at most
+#define SW_TASK_MAX_CONCURRENCY    64   //task_enable_coroutine, the tasks running at the same time in a task worker
+
+#define SW_AUTOSCALE_INTERVAL      1    //seconds, the manager samples the load of the workers
+#define SW_AUTOSCALE_UP_TICKS      2    //busy samples in a row to start more workers
+#define SW_AUTOSCALE_DOWN_TICKS    30   //idle samples in a row to stop a worker
+#define SW_AUTOSCALE_IDLE_LOW      10   //percent of idle workers, busy below it if messages are waiting
+#define SW_AUTOSCALE_IDLE_HIGH     50   //percent of idle workers, idle above it if no message is waiting
+#define SW_AUTOSCALE_DELAY_HIGH    20000   //usec, the expected waiting time of a new message, busy above it
 
 #define SW_AIO_THREAD_NUM_DEFAULT        2
 #define SW_AIO_THREAD_NUM_MAX            32
@@ -129,9 +146,29 @@
 #define SW_WORKER_MAX_WAIT_TIME          30           //最大等待时间
 
 //#define SW_WORKER_SEND_CHUNK
+#define SW_WORKER_EWMA_SHIFT             3      //dispatch_mode=9, the weight of a new sample is 1/8
+#define SW_WORKER_HASH_VNODES            160    //dispatch_mode=10, virtual nodes per worker
+#define SW_WORKER_HASH_LOAD_FACTOR       125    //dispatch_mode=10, a worker takes at most 125% of the average load
 
 #define SW_REACTOR_SCHEDULE              2
 #define SW_REACTOR_MAXEVENTS             4096
+#define SW_REACTOR_BUSY_POLL_SHRINK      16     //busy poll budget shrinks to 1/16 at least
+#define SW_REACTOR_FAST_DISPATCH                //separate call sites for the read handlers of SW_FD_TCP/SW_FD_PIPE/SW_FD_LISTEN
+#define SW_REACTOR_DEFER_SIZE            1024   //initial size of the defer ring, must be a power of 2
+#define SW_IOURING_RECV_BUFFER_NUM       256    //must be a power of 2
+#define SW_IOURING_RECV_BUFFER_SIZE      16384
+#define SW_REACTOR_STEAL_INTERVAL        1000   //ms, enable_reactor_steal
+#define SW_REACTOR_STEAL_FACTOR          125    //a reactor thread above 125% of the average load gives away connections
+#define SW_REACTOR_STEAL_MIN_EVENTS      1000   //read events per interval, below this nothing is moved
+#define SW_ZEROCOPY_MIN_SIZE             10240  //MSG_ZEROCOPY is slower than copying for the small sends
+#define SW_ZEROCOPY_LINGER_TIME          10     //seconds, the chunks of a closed connection may still be sent by the kernel
+#define SW_ZEROCOPY_LINGER_CHECK_INTERVAL 1000  //ms, the lingering chunks are released after SW_ZEROCOPY_LINGER_TIME
+#define SW_OUTPUT_MEMORY_LOW_WATERMARK   75     //percent of output_memory_high_watermark, the default low watermark
+#define SW_OUTPUT_MEMORY_CHECK_INTERVAL  100    //ms, the paused connections are resumed below the low watermark
+#define SW_UDP_BATCH_SIZE                16     //enable_udp_batch, datagrams received by one recvmmsg
+#define SW_UDP_SEND_BATCH_SIZE           64     //replies queued by a worker, UDP_MAX_SEGMENTS of one GSO message
+#define SW_UDP_SEND_BATCH_BUFFER         65536
+#define SW_UDP_GSO_MAX_SIZE              65000  //payload of one GSO message, below the 64K limit of an IP packet
 #define SW_REACTOR_USE_SESSION
 #define SW_SESSION_LIST_SIZE             (1024*1024)
 
@@ -163,6 +200,10 @@
 #define SW_BUFFER_INPUT_SIZE             (1024*1024*2)
 #define SW_BUFFER_MIN_SIZE               65536
 #define SW_PIPE_BUFFER_SIZE              (1024*1024*32)
+#define SW_IPC_RING_SIZE                 (1024*128)   //shared memory ring per reactor thread and worker, SW_IPC_RING
+#define SW_IPC_RING_BATCH                64           //records popped from one ring before the other events get a chance
+#define SW_CACHELINE_SIZE                64
+#define SW_PACKAGE_POOL_PAGE_SIZE        16384        //page of the shared memory pool for the large packages
 
 #define SW_BACKLOG                       512
 
@@ -184,6 +225,7 @@
 
 #define SW_TASK_TMP_FILE                 "/tmp/swoole.task.XXXXXX"
 #define SW_TASK_TMPDIR_SIZE              128
+#define SW_TASK_POOL_PAGE_SIZE           16384        //page of the shared memory pool for the large task payloads
 
 #define SW_FILE_CHUNK_SIZE               65536
 
@@ -261,6 +303,7 @@
 #define SW_PGSQL_CONNECT_TIMEOUT         3.0
 
 #define SW_TIMER_MAX_VALUE               86400000
+#define SW_TIMER_NODE_POOL_SIZE          8192   //max number of the cached free timer nodes
 
 /**
  * Coroutine
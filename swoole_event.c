@@ -232,7 +232,8 @@ void php_swoole_check_reactor()
         return;
     }
 
-    if (swIsTaskWorker())
+    //task_enable_coroutine, the task worker runs on a reactor
+    if (swIsTaskWorker() && SwooleG.main_reactor == NULL)
     {
         swoole_php_fatal_error(E_ERROR, "can't use async-io in task process.");
         return;
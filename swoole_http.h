@@ -166,6 +166,7 @@ void swoole_websocket_onRequest(http_context *);
  */
 http_context* swoole_http_context_new(swoole_http_client* client TSRMLS_DC);
 void swoole_http_context_free(http_context *ctx TSRMLS_DC);
+char* swoole_http_get_date(TSRMLS_D);
 int swoole_http_parse_form_data(http_context *ctx, const char *boundary_str, int boundary_len TSRMLS_DC);
 
 #define swoole_http_server_array_init(name, class)    SW_MAKE_STD_ZVAL(z##name);\
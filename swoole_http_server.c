@@ -1862,12 +1862,29 @@ static http_context* http_get_context(zval *object, int check_end TSRMLS_DC)
     return ctx;
 }
 
+/**
+ * the Date header, formatted at most once per second with the cached clock of the reactor
+ */
+char* swoole_http_get_date(TSRMLS_D)
+{
+    static char date[64];
+    static time_t date_time = 0;
+
+    time_t now = swReactor_now(SwooleG.main_reactor);
+    if (now != date_time)
+    {
+        char *date_str = sw_php_format_date(ZEND_STRL(SW_HTTP_DATE_FORMAT), now, 0 TSRMLS_CC);
+        snprintf(date, sizeof(date), "%s", date_str);
+        efree(date_str);
+        date_time = now;
+    }
+    return date;
+}
+
 static void http_build_header(http_context *ctx, zval *object, swString *response, int body_length TSRMLS_DC)
 {
     assert(ctx->send_header == 0);
 
-    swServer *serv = SwooleG.serv;
-
     char *buf = SwooleTG.buffer_stack->str;
     size_t l_buf = SwooleTG.buffer_stack->size;
     int n;
@@ -1948,10 +1965,9 @@ static void http_build_header(http_context *ctx, zval *object, swString *respons
         }
         if (!(flag & HTTP_RESPONSE_DATE))
         {
-            date_str = sw_php_format_date(ZEND_STRL(SW_HTTP_DATE_FORMAT), serv->gs->now, 0 TSRMLS_CC);
+            date_str = swoole_http_get_date(TSRMLS_C);
             n = snprintf(buf, l_buf, "Date: %s\r\n", date_str);
             swString_append_ptr(response, buf, n);
-            efree(date_str);
         }
     }
     else
@@ -1967,9 +1983,8 @@ static void http_build_header(http_context *ctx, zval *object, swString *respons
             swString_append_ptr(response, ZEND_STRL("Connection: close\r\n"));
         }
         //Date
-        date_str = sw_php_format_date(ZEND_STRL(SW_HTTP_DATE_FORMAT), serv->gs->now, 0 TSRMLS_CC);
+        date_str = swoole_http_get_date(TSRMLS_C);
         n = snprintf(buf, l_buf, "Date: %s\r\n", date_str);
-        efree(date_str);
         swString_append_ptr(response, buf, n);
     }
     /**
@@ -146,8 +146,6 @@ static int http2_build_header(http_context *ctx, uchar *buffer, int body_length
 {
     assert(ctx->send_header == 0);
 
-    swServer *serv = SwooleG.serv;
-
     char *date_str = NULL;
     char intbuf[2][16];
 
@@ -226,7 +224,7 @@ static int http2_build_header(http_context *ctx, uchar *buffer, int body_length
         }
         if (!(flag & HTTP_RESPONSE_DATE))
         {
-            date_str = sw_php_format_date(ZEND_STRL(SW_HTTP_DATE_FORMAT), serv->gs->now, 0 TSRMLS_CC);
+            date_str = swoole_http_get_date(TSRMLS_C);
             http2_add_header(&nv[index++], ZEND_STRL("date"), date_str, strlen(date_str));
         }
         if (!(flag & HTTP_RESPONSE_CONTENT_TYPE))
@@ -239,7 +237,7 @@ static int http2_build_header(http_context *ctx, uchar *buffer, int body_length
         http2_add_header(&nv[index++], ZEND_STRL("server"), ZEND_STRL(SW_HTTP_SERVER_SOFTWARE));
         http2_add_header(&nv[index++], ZEND_STRL("content-type"), ZEND_STRL("text/html"));
 
-        date_str = sw_php_format_date(ZEND_STRL(SW_HTTP_DATE_FORMAT), serv->gs->now, 0 TSRMLS_CC);
+        date_str = swoole_http_get_date(TSRMLS_C);
         http2_add_header(&nv[index++], ZEND_STRL("date"), date_str, strlen(date_str));
 
 #ifdef SW_HAVE_ZLIB
@@ -301,11 +299,6 @@ static int http2_build_header(http_context *ctx, uchar *buffer, int body_length
         return SW_ERR;
     }
 
-    if (date_str)
-    {
-        efree(date_str);
-    }
-
     nghttp2_hd_deflate_del(deflater);
 
     return rv;
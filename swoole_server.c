@@ -69,11 +69,23 @@ typedef struct
     zval *result;
     swTimer_node *timer;
 } swTaskCo;
+
+/**
+ * task_enable_coroutine, the header of the task is kept until the coroutine of onTask ends
+ */
+typedef struct
+{
+    swDataHead info;
+    zval retval;
+} swTaskCoContext;
+
+static swHashMap *task_context_map = NULL;
+static swTaskCoContext *task_pending_context = NULL;
 #endif
 
 zval _php_sw_server_callbacks[PHP_SERVER_CALLBACK_NUM];
 
-static int php_swoole_task_finish(swServer *serv, zval *data TSRMLS_DC);
+static int php_swoole_task_finish(swServer *serv, zval *data, swDataHead *info TSRMLS_DC);
 static void php_swoole_onPipeMessage(swServer *serv, swEventData *req);
 static void php_swoole_onStart(swServer *);
 static void php_swoole_onShutdown(swServer *);
@@ -92,6 +104,8 @@ static void php_swoole_onConnect_finish(void *param);
 static void php_swoole_onSendTimeout(swTimer *timer, swTimer_node *tnode);
 static void php_swoole_server_send_resume(swServer *serv, php_context *context, int fd);
 static void php_swoole_task_onTimeout(swTimer *timer, swTimer_node *tnode);
+static void php_swoole_task_onCoroStart(void *data);
+static void php_swoole_task_onCoroStop(void *data);
 #endif
 
 static zval* php_swoole_server_add_port(swServer *serv, swListenPort *port TSRMLS_DC);
@@ -207,7 +221,8 @@ int php_swoole_task_pack(swEventData *task, zval *data TSRMLS_DC)
         task_data_len = Z_STRLEN_P(data);
     }
 
-    if (task_data_len >= SW_IPC_MAX_SIZE - sizeof(task->info))
+    //leave room for the deadline
+    if (task_data_len >= SW_IPC_MAX_SIZE - sizeof(task->info) - sizeof(int64_t))
     {
         if (swTaskWorker_large_pack(task, task_data_str, task_data_len) < 0) //数据量超過8k大的话就写入临时文件
         {
@@ -238,8 +253,8 @@ void php_swoole_get_recv_data(zval *zdata, swEventData *req, char *header, uint3
     char *data_ptr = NULL;
     int data_len;
 
-#ifdef SW_USE_RINGBUFFER
     swPackage package;
+    //shared memory package, released by the worker after onReceive
     if (req->info.type == SW_EVENT_PACKAGE)
     {
         memcpy(&package, req->data, sizeof (package));
@@ -247,14 +262,12 @@ void php_swoole_get_recv_data(zval *zdata, swEventData *req, char *header, uint3
         data_ptr = package.data;
         data_len = package.length;
     }
-#else
-    if (req->info.type == SW_EVENT_PACKAGE_END)
+    else if (req->info.type == SW_EVENT_PACKAGE_END)
     {
         swString *worker_buffer = swWorker_get_buffer(SwooleG.serv, req->info.from_id);
         data_ptr = worker_buffer->str;
         data_len = worker_buffer->length;
     }
-#endif
     else
     {
         data_ptr = req->data;
@@ -274,14 +287,6 @@ void php_swoole_get_recv_data(zval *zdata, swEventData *req, char *header, uint3
     {
         memcpy(header, data_ptr, header_length);
     }
-
-#ifdef SW_USE_RINGBUFFER
-    if (req->info.type == SW_EVENT_PACKAGE)
-    {
-        swReactorThread *thread = swServer_get_thread(SwooleG.serv, req->info.from_id);
-        thread->buffer_input->free(thread->buffer_input, data_ptr);
-    }
-#endif
 }
 
 int php_swoole_get_send_data(zval *zdata, char **str TSRMLS_DC)
@@ -314,6 +319,51 @@ int php_swoole_get_send_data(zval *zdata, char **str TSRMLS_DC)
     return length;
 }
 
+/**
+ * [0, 2, 4] or a single cpu
+ */
+static int php_swoole_server_parse_cpu_set(zval *zset, int **cpu_set, int *cpu_set_num TSRMLS_DC)
+{
+    int n = Z_TYPE_P(zset) == IS_ARRAY ? zend_hash_num_elements(Z_ARRVAL_P(zset)) : 1;
+    if (n < 1)
+    {
+        swoole_php_fatal_error(E_WARNING, "cpu set is empty.");
+        return SW_ERR;
+    }
+    int *cpus = (int *) sw_malloc(sizeof(int) * n);
+    int i = 0;
+    zval *zcpu = NULL;
+
+    if (Z_TYPE_P(zset) == IS_ARRAY)
+    {
+        SW_HASHTABLE_FOREACH_START(Z_ARRVAL_P(zset), zcpu)
+            convert_to_long(zcpu);
+            cpus[i++] = (int) Z_LVAL_P(zcpu);
+        SW_HASHTABLE_FOREACH_END();
+    }
+    else
+    {
+        convert_to_long(zset);
+        cpus[i++] = (int) Z_LVAL_P(zset);
+    }
+    for (i = 0; i < n; i++)
+    {
+        if (cpus[i] < 0 || cpus[i] >= SW_CPU_NUM)
+        {
+            swoole_php_fatal_error(E_WARNING, "cpu#%d does not exist, cpu num is %d.", cpus[i], SW_CPU_NUM);
+            sw_free(cpus);
+            return SW_ERR;
+        }
+    }
+    if (*cpu_set)
+    {
+        sw_free(*cpu_set);
+    }
+    *cpu_set = cpus;
+    *cpu_set_num = n;
+    return SW_OK;
+}
+
 static sw_inline int php_swoole_check_task_param(swServer *serv, int dst_worker_id TSRMLS_DC)
 {
     if (serv->task_worker_num < 1)
@@ -337,6 +387,27 @@ static sw_inline int php_swoole_check_task_param(swServer *serv, int dst_worker_
     return SW_OK;
 }
 
+static sw_inline int php_swoole_check_task_priority(zend_long priority TSRMLS_DC)
+{
+    if (priority < 0 || priority >= SW_TASK_PRIORITY_NUM)
+    {
+        swoole_php_fatal_error(E_WARNING, "priority must be between 0 and %d.", SW_TASK_PRIORITY_NUM - 1);
+        return SW_ERR;
+    }
+    return SW_OK;
+}
+
+/**
+ * the task worker drops the task if it is still queued after the timeout
+ */
+static sw_inline void php_swoole_task_set_timeout(swEventData *task, double timeout)
+{
+    if (timeout > 0 && task->info.fd >= 0)
+    {
+        swTask_set_deadline(task, swoole_monotonic_usec() + (int64_t) (timeout * 1000000));
+    }
+}
+
 zval* php_swoole_task_unpack(swEventData *task_result TSRMLS_DC)
 {
     zval *result_data, *result_unserialized_data;
@@ -552,6 +623,16 @@ void php_swoole_server_before_start(swServer *serv, zval *zobject TSRMLS_DC)
             serv->onClose = php_swoole_onClose;
         }
     }
+    if (serv->task_enable_coroutine)
+    {
+        task_context_map = swHashMap_new(SW_HASHMAP_INIT_BUCKET_N, NULL);
+        if (task_context_map == NULL)
+        {
+            swoole_php_fatal_error(E_ERROR, "failed to create task_context_map. Error: %s", sw_error);
+        }
+        swoole_add_hook(SW_GLOBAL_HOOK_ON_CORO_START, php_swoole_task_onCoroStart, 1);
+        swoole_add_hook(SW_GLOBAL_HOOK_ON_CORO_STOP, php_swoole_task_onCoroStop, 1);
+    }
 #endif
 
     /**
@@ -689,7 +770,7 @@ void php_swoole_register_callback(swServer *serv)
     }
 }
 
-static int php_swoole_task_finish(swServer *serv, zval *data TSRMLS_DC)
+static int php_swoole_task_finish(swServer *serv, zval *data, swDataHead *info TSRMLS_DC)
 {
     int flags = 0;
     smart_str serialized_data = {0};
@@ -726,7 +807,14 @@ static int php_swoole_task_finish(swServer *serv, zval *data TSRMLS_DC)
         data_len = Z_STRLEN_P(data);
     }
 
-    ret = swTaskWorker_finish(serv, data_str, data_len, flags);
+    if (info)
+    {
+        ret = swTaskWorker_finish_task(serv, (swEventData *) info, data_str, data_len, flags);
+    }
+    else
+    {
+        ret = swTaskWorker_finish(serv, data_str, data_len, flags);
+    }
     if (SWOOLE_G(fast_serialize) && serialized_string)
     {
         zend_string_release(serialized_string);
@@ -1051,9 +1139,45 @@ static int php_swoole_onTask(swServer *serv, swEventData *req)
     zval *zdata = php_swoole_task_unpack(req TSRMLS_CC);
     if (zdata == NULL)
     {
+        sw_zval_ptr_dtor(&zfd);
+        sw_zval_ptr_dtor(&zfrom_id);
         return SW_ERR;
     }
 
+#ifdef SW_COROUTINE
+    if (serv->task_enable_coroutine)
+    {
+        zval *args[4];
+        args[0] = zserv;
+        args[1] = zfd;
+        args[2] = zfrom_id;
+        args[3] = zdata;
+
+        swTaskCoContext *context = emalloc(sizeof(swTaskCoContext));
+        context->info = req->info;
+        ZVAL_UNDEF(&context->retval);
+        retval = &context->retval;
+        task_pending_context = context;
+
+        zend_fcall_info_cache *cache = php_sw_server_caches[SW_SERVER_CB_onTask];
+        if (coro_create(cache, args, 4, &retval, NULL, NULL) < 0)
+        {
+            task_pending_context = NULL;
+            efree(context);
+            swTaskWorker_done(serv);
+            swWarn("Failed to handle onTask. Coroutine limited.");
+        }
+        if (EG(exception))
+        {
+            zend_exception_error(EG(exception), E_ERROR TSRMLS_CC);
+        }
+        sw_zval_ptr_dtor(&zfd);
+        sw_zval_ptr_dtor(&zfrom_id);
+        sw_zval_free(zdata);
+        return SW_OK;
+    }
+#endif
+
     args[0] = &zserv;
     args[1] = &zfd;
     args[2] = &zfrom_id;
@@ -1078,7 +1202,7 @@ static int php_swoole_onTask(swServer *serv, swEventData *req)
     {
         if (SW_Z_TYPE_P(retval) != IS_NULL)
         {
-            php_swoole_task_finish(serv, retval TSRMLS_CC);
+            php_swoole_task_finish(serv, retval, NULL TSRMLS_CC);
         }
         sw_zval_ptr_dtor(&retval);
     }
@@ -1086,6 +1210,45 @@ static int php_swoole_onTask(swServer *serv, swEventData *req)
     return SW_OK;
 }
 
+#ifdef SW_COROUTINE
+static void php_swoole_task_onCoroStart(void *data)
+{
+    coro_task *task = (coro_task *) data;
+    //the first coroutine created is the one of onTask
+    if (task_pending_context)
+    {
+        swHashMap_add_int(task_context_map, task->cid, task_pending_context);
+        task_pending_context = NULL;
+    }
+}
+
+static void php_swoole_task_onCoroEnd(void *data)
+{
+    swTaskCoContext *context = (swTaskCoContext *) data;
+    swServer *serv = SwooleG.serv;
+
+    if (Z_TYPE(context->retval) != IS_UNDEF && Z_TYPE(context->retval) != IS_NULL)
+    {
+        php_swoole_task_finish(serv, &context->retval, &context->info TSRMLS_CC);
+    }
+    zval_ptr_dtor(&context->retval);
+    efree(context);
+    swTaskWorker_done(serv);
+}
+
+static void php_swoole_task_onCoroStop(void *data)
+{
+    coro_task *task = (coro_task *) data;
+    swTaskCoContext *context = swHashMap_find_int(task_context_map, task->cid);
+    if (context)
+    {
+        swHashMap_del_int(task_context_map, task->cid);
+        //the return value is sent after the coroutine is closed
+        SwooleG.main_reactor->defer(SwooleG.main_reactor, php_swoole_task_onCoroEnd, context);
+    }
+}
+#endif
+
 static int php_swoole_onFinish(swServer *serv, swEventData *req)
 {
     zval *zserv = (zval *) serv->ptr2;
@@ -1095,6 +1258,17 @@ static int php_swoole_onFinish(swServer *serv, swEventData *req)
     zval *zdata;
     zval *retval = NULL;
 
+    //dropped by the task worker after the deadline, only the callback is released
+    if (swTask_type(req) & SW_TASK_EXPIRED)
+    {
+        zval *callback = (swTask_type(req) & SW_TASK_CALLBACK) ? swHashMap_find_int(task_callbacks, req->info.fd) : NULL;
+        if (callback)
+        {
+            swHashMap_del_int(task_callbacks, req->info.fd);
+            sw_zval_free(callback);
+        }
+        return SW_OK;
+    }
 
     SW_MAKE_STD_ZVAL(ztask_id);
     ZVAL_LONG(ztask_id, (long) req->info.fd);
@@ -1421,7 +1595,7 @@ static void php_swoole_onWorkerStart(swServer *serv, int worker_id)
         return;
     }
 
-    if (SwooleG.enable_coroutine && worker_id < serv->worker_num)
+    if ((SwooleG.enable_coroutine && worker_id < serv->worker_num) || (serv->task_enable_coroutine && worker_id >= serv->worker_num))
     {
         php_swoole_onWorkerStart_coroutine(zserv, zworker_id);
     }
@@ -2178,6 +2352,42 @@ PHP_METHOD(swoole_server, set)
             serv->worker_num = SwooleG.cpu_num;
         }
     }
+    //min_worker_num, the workers between it and worker_num are started by the load
+    if (php_swoole_array_get_value(vht, "min_worker_num", v))
+    {
+        convert_to_long(v);
+        serv->min_worker_num = Z_LVAL_P(v) > 0 ? (uint16_t) Z_LVAL_P(v) : 0;
+    }
+    //io_uring reactor
+    if (php_swoole_array_get_value(vht, "enable_io_uring", v))
+    {
+        convert_to_boolean(v);
+#ifdef HAVE_IO_URING
+        SwooleG.enable_io_uring = Z_BVAL_P(v);
+#else
+        if (Z_BVAL_P(v))
+        {
+            swoole_php_fatal_error(E_WARNING, "io_uring is not supported, use the default reactor.");
+        }
+#endif
+    }
+    if (php_swoole_array_get_value(vht, "io_uring_completion", v))
+    {
+        convert_to_boolean(v);
+        serv->io_uring_completion = Z_BVAL_P(v);
+    }
+    //spin before blocking in the reactor
+    if (php_swoole_array_get_value(vht, "busy_poll_usec", v))
+    {
+        convert_to_long(v);
+        serv->busy_poll_usec = Z_LVAL_P(v) > 0 ? (uint32_t) Z_LVAL_P(v) : 0;
+    }
+    //reactor callback latency and timer lag histograms
+    if (php_swoole_array_get_value(vht, "latency_stats", v))
+    {
+        convert_to_boolean(v);
+        SwooleG.enable_latency_stats = Z_BVAL_P(v);
+    }
     //max wait time
     if (php_swoole_array_get_value(vht, "max_wait_time", v))
     {
@@ -2203,6 +2413,21 @@ PHP_METHOD(swoole_server, set)
             COROG.max_coro_num = SW_MAX_CORO_NUM_LIMIT;
         }
     }
+    if (php_swoole_array_get_value(vht, "task_enable_coroutine", v))
+    {
+        convert_to_boolean(v);
+        serv->task_enable_coroutine = Z_BVAL_P(v);
+    }
+    if (php_swoole_array_get_value(vht, "task_max_concurrency", v))
+    {
+        convert_to_long(v);
+        serv->task_max_concurrency = (uint32_t) Z_LVAL_P(v);
+    }
+    if (php_swoole_array_get_value(vht, "task_min_worker_num", v))
+    {
+        convert_to_long(v);
+        serv->task_min_worker_num = Z_LVAL_P(v) > 0 ? (uint16_t) Z_LVAL_P(v) : 0;
+    }
     if (php_swoole_array_get_value(vht, "send_yield", v))
     {
         convert_to_boolean(v);
@@ -2220,6 +2445,55 @@ PHP_METHOD(swoole_server, set)
         convert_to_long(v);
         serv->dispatch_mode = (int) Z_LVAL_P(v);
     }
+    //accept_mode
+    if (php_swoole_array_get_value(vht, "accept_mode", v))
+    {
+        convert_to_long(v);
+        if (Z_LVAL_P(v) < SW_ACCEPT_MASTER || Z_LVAL_P(v) > SW_ACCEPT_EXCLUSIVE)
+        {
+            swoole_php_fatal_error(E_WARNING, "invalid accept_mode %ld.", Z_LVAL_P(v));
+        }
+        else
+        {
+            serv->accept_mode = (int) Z_LVAL_P(v);
+        }
+    }
+    //reactor thread <-> worker ipc
+    if (php_swoole_array_get_value(vht, "ipc_mode", v))
+    {
+        convert_to_long(v);
+        if (Z_LVAL_P(v) != SW_IPC_UNIXSOCK && Z_LVAL_P(v) != SW_IPC_RING)
+        {
+            swoole_php_fatal_error(E_WARNING, "invalid ipc_mode %ld.", Z_LVAL_P(v));
+        }
+        else
+        {
+            serv->ipc_mode = (int) Z_LVAL_P(v);
+        }
+    }
+    if (php_swoole_array_get_value(vht, "ipc_ring_size", v))
+    {
+        convert_to_long(v);
+        serv->ipc_ring_size = (int) Z_LVAL_P(v);
+    }
+    //shared memory for the large packages
+    if (php_swoole_array_get_value(vht, "package_pool_size", v))
+    {
+        convert_to_long(v);
+        serv->package_pool_size = (int) Z_LVAL_P(v);
+    }
+    //shared memory for the large task payloads
+    if (php_swoole_array_get_value(vht, "task_pool_size", v))
+    {
+        convert_to_long(v);
+        serv->task_pool_size = (int) Z_LVAL_P(v);
+    }
+    //send the large responses with MSG_ZEROCOPY
+    if (php_swoole_array_get_value(vht, "zerocopy_threshold", v))
+    {
+        convert_to_long(v);
+        serv->zerocopy_threshold = (int) Z_LVAL_P(v);
+    }
     //dispatch function
     if (php_swoole_array_get_value(vht, "dispatch_func", v))
     {
@@ -2268,7 +2542,7 @@ PHP_METHOD(swoole_server, set)
         SwooleG.log_level = (int) Z_LVAL_P(v);
     }
     /**
-     * for dispatch_mode = 1/3
+     * for dispatch_mode = 1/3/8/9
      */
     if (php_swoole_array_get_value(vht, "discard_timeout_request", v))
     {
@@ -2281,6 +2555,18 @@ PHP_METHOD(swoole_server, set)
         convert_to_boolean(v);
         serv->enable_unsafe_event = Z_BVAL_P(v);
     }
+    //move the connections between the reactor threads
+    if (php_swoole_array_get_value(vht, "enable_reactor_steal", v))
+    {
+        convert_to_boolean(v);
+        serv->enable_reactor_steal = Z_BVAL_P(v);
+    }
+    //recvmmsg/sendmmsg
+    if (php_swoole_array_get_value(vht, "enable_udp_batch", v))
+    {
+        convert_to_boolean(v);
+        serv->enable_udp_batch = Z_BVAL_P(v);
+    }
     //delay receive
     if (php_swoole_array_get_value(vht, "enable_delay_receive", v))
     {
@@ -2438,6 +2724,28 @@ PHP_METHOD(swoole_server, set)
         serv->cpu_affinity_available_num = available_num;
         serv->cpu_affinity_available = available_cpu;
     }
+    //explicit cpus of the threads and processes
+    if (php_swoole_array_get_value(vht, "reactor_cpu_set", v))
+    {
+        if (php_swoole_server_parse_cpu_set(v, &serv->reactor_cpu_set, &serv->reactor_cpu_set_num TSRMLS_CC) < 0)
+        {
+            RETURN_FALSE;
+        }
+    }
+    if (php_swoole_array_get_value(vht, "worker_cpu_set", v))
+    {
+        if (php_swoole_server_parse_cpu_set(v, &serv->worker_cpu_set, &serv->worker_cpu_set_num TSRMLS_CC) < 0)
+        {
+            RETURN_FALSE;
+        }
+    }
+    if (php_swoole_array_get_value(vht, "task_worker_cpu_set", v))
+    {
+        if (php_swoole_server_parse_cpu_set(v, &serv->task_worker_cpu_set, &serv->task_worker_cpu_set_num TSRMLS_CC) < 0)
+        {
+            RETURN_FALSE;
+        }
+    }
     //paser x-www-form-urlencoded form data
     if (php_swoole_array_get_value(vht, "http_parse_post", v))
     {
@@ -2526,6 +2834,17 @@ PHP_METHOD(swoole_server, set)
         convert_to_long(v);
         serv->buffer_output_size = (int) Z_LVAL_P(v);
     }
+    //output buffers of all the connections
+    if (php_swoole_array_get_value(vht, "output_memory_high_watermark", v))
+    {
+        convert_to_long(v);
+        serv->output_memory_high_watermark = (size_t) Z_LVAL_P(v);
+    }
+    if (php_swoole_array_get_value(vht, "output_memory_low_watermark", v))
+    {
+        convert_to_long(v);
+        serv->output_memory_low_watermark = (size_t) Z_LVAL_P(v);
+    }
     //message queue key
     if (php_swoole_array_get_value(vht, "message_queue_key", v))
     {
@@ -3065,6 +3384,21 @@ PHP_METHOD(swoole_server, resume)
     SW_CHECK_RETURN(swServer_tcp_feedback(serv, fd, SW_EVENT_RESUME_RECV));
 }
 
+/**
+ * the values are in microseconds
+ */
+static void php_swoole_server_add_histogram(zval *zhist, swHistogram *hist)
+{
+    array_init(zhist);
+    add_assoc_long(zhist, "count", hist->count);
+    add_assoc_long(zhist, "avg", hist->count > 0 ? hist->sum / hist->count : 0);
+    add_assoc_long(zhist, "p50", swHistogram_percentile(hist, 50));
+    add_assoc_long(zhist, "p90", swHistogram_percentile(hist, 90));
+    add_assoc_long(zhist, "p99", swHistogram_percentile(hist, 99));
+    add_assoc_long(zhist, "p999", swHistogram_percentile(hist, 99.9));
+    add_assoc_long(zhist, "max", hist->max);
+}
+
 PHP_METHOD(swoole_server, stats)
 {
     swServer *serv = swoole_get_object(getThis());
@@ -3089,6 +3423,12 @@ PHP_METHOD(swoole_server, stats)
     }
     sw_add_assoc_long_ex(return_value, ZEND_STRS("tasking_num"), tasking_num);
     sw_add_assoc_long_ex(return_value, ZEND_STRS("request_count"), serv->stats->request_count);
+    sw_add_assoc_long_ex(return_value, ZEND_STRS("output_buffer_memory"), serv->stats->output_buffer_memory);
+    sw_add_assoc_long_ex(return_value, ZEND_STRS("task_expired_count"), serv->stats->task_expired_count);
+    sw_add_assoc_long_ex(return_value, ZEND_STRS("task_running_num"), serv->stats->task_running_num);
+    //the running workers, changed by min_worker_num and task_min_worker_num
+    sw_add_assoc_long_ex(return_value, ZEND_STRS("worker_num"), serv->min_worker_num > 0 ? serv->gs->event_workers.run_worker_num : serv->worker_num);
+    sw_add_assoc_long_ex(return_value, ZEND_STRS("task_worker_num"), serv->task_min_worker_num > 0 ? serv->gs->task_workers.run_worker_num : serv->task_worker_num);
     if (SwooleWG.worker)
     {
         sw_add_assoc_long_ex(return_value, ZEND_STRS("worker_request_count"), SwooleWG.worker->request_count);
@@ -3108,6 +3448,101 @@ PHP_METHOD(swoole_server, stats)
 #ifdef SW_COROUTINE
     sw_add_assoc_long_ex(return_value, ZEND_STRS("coroutine_num"), COROG.coro_num);
 #endif
+
+    //accept stats of each port
+    zval *zports;
+    SW_MAKE_STD_ZVAL(zports);
+    array_init(zports);
+    swListenPort *ls;
+    LL_FOREACH(serv->listen_list, ls)
+    {
+        if (swSocket_is_dgram(ls->type))
+        {
+            continue;
+        }
+        zval *zport;
+        SW_MAKE_STD_ZVAL(zport);
+        array_init(zport);
+        sw_add_assoc_string(zport, "host", ls->host, 1);
+        add_assoc_long(zport, "port", ls->port);
+        add_assoc_long(zport, "connection_num", ls->connection_num);
+        add_assoc_long(zport, "accept_count", ls->accept_count);
+        add_assoc_long(zport, "reject_count", ls->reject_count);
+        add_assoc_long(zport, "emfile_count", ls->emfile_count);
+        add_next_index_zval(zports, zport);
+    }
+    add_assoc_zval(return_value, "ports", zports);
+
+    //busy poll stats of the reactors
+    if (serv->busy_poll_usec > 0)
+    {
+        zval *zreactors;
+        SW_MAKE_STD_ZVAL(zreactors);
+        array_init(zreactors);
+        int i;
+        int reactor_num = serv->factory_mode == SW_MODE_PROCESS ? serv->reactor_num : 1;
+        for (i = 0; i < reactor_num; i++)
+        {
+            swReactor *reactor = serv->factory_mode == SW_MODE_PROCESS ? &serv->reactor_threads[i].reactor : SwooleG.main_reactor;
+            if (reactor == NULL)
+            {
+                break;
+            }
+            zval *zreactor;
+            SW_MAKE_STD_ZVAL(zreactor);
+            array_init(zreactor);
+            add_assoc_long(zreactor, "spin_time", reactor->spin_time);
+            add_assoc_long(zreactor, "block_time", reactor->block_time);
+            add_assoc_long(zreactor, "spin_hit_count", reactor->spin_hit_count);
+            add_assoc_long(zreactor, "spin_miss_count", reactor->spin_miss_count);
+            add_next_index_zval(zreactors, zreactor);
+        }
+        add_assoc_zval(return_value, "busy_poll", zreactors);
+    }
+    //event loop latency of the reactors and timer lag of the current process
+    if (SwooleG.enable_latency_stats)
+    {
+        zval *zreactors;
+        SW_MAKE_STD_ZVAL(zreactors);
+        array_init(zreactors);
+        int i;
+        int reactor_num = serv->factory_mode == SW_MODE_PROCESS ? serv->reactor_num : 1;
+        for (i = 0; i < reactor_num; i++)
+        {
+            swReactor *reactor = serv->factory_mode == SW_MODE_PROCESS ? &serv->reactor_threads[i].reactor : SwooleG.main_reactor;
+            swHistogram *hist = serv->factory_mode == SW_MODE_PROCESS ? serv->reactor_threads[i].latency : (reactor ? reactor->latency : NULL);
+            if (hist == NULL)
+            {
+                break;
+            }
+            zval *zreactor;
+            SW_MAKE_STD_ZVAL(zreactor);
+            php_swoole_server_add_histogram(zreactor, hist);
+            add_assoc_long(zreactor, "max_fdtype", reactor->latency_max_fdtype);
+            add_next_index_zval(zreactors, zreactor);
+        }
+        add_assoc_zval(return_value, "latency", zreactors);
+
+        if (SwooleG.timer.lag)
+        {
+            zval *zlag;
+            SW_MAKE_STD_ZVAL(zlag);
+            php_swoole_server_add_histogram(zlag, SwooleG.timer.lag);
+            add_assoc_zval(return_value, "timer_lag", zlag);
+        }
+    }
+    //defer queue of the current process
+    if (SwooleG.main_reactor)
+    {
+        zval *zdefer;
+        SW_MAKE_STD_ZVAL(zdefer);
+        array_init(zdefer);
+        add_assoc_long(zdefer, "depth", SwooleG.main_reactor->defer_count);
+        add_assoc_long(zdefer, "max_depth", SwooleG.main_reactor->defer_max_count);
+        add_assoc_long(zdefer, "size", SwooleG.main_reactor->defer_size);
+        add_assoc_long(zdefer, "total", SwooleG.main_reactor->defer_total);
+        add_assoc_zval(return_value, "defer_queue", zdefer);
+    }
 }
 
 PHP_METHOD(swoole_server, reload)
@@ -3196,6 +3631,7 @@ PHP_METHOD(swoole_server, taskwait)
 
     double timeout = SW_TASKWAIT_TIMEOUT;
     long dst_worker_id = -1;
+    zend_long priority = 0;
 
     swServer *serv = swoole_get_object(getThis());
     if (serv->gs->start == 0)
@@ -3204,12 +3640,12 @@ PHP_METHOD(swoole_server, taskwait)
         RETURN_FALSE;
     }
 
-    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "z|dl", &data, &timeout, &dst_worker_id) == FAILURE)
+    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "z|dll", &data, &timeout, &dst_worker_id, &priority) == FAILURE)
     {
         return;
     }
 
-    if (php_swoole_check_task_param(serv, dst_worker_id TSRMLS_CC) < 0)
+    if (php_swoole_check_task_param(serv, dst_worker_id TSRMLS_CC) < 0 || php_swoole_check_task_priority(priority TSRMLS_CC) < 0)
     {
         RETURN_FALSE;
     }
@@ -3218,6 +3654,8 @@ PHP_METHOD(swoole_server, taskwait)
     {
         RETURN_FALSE;
     }
+    swTask_type(&buf) |= priority << SW_TASK_PRIORITY_SHIFT;
+    php_swoole_task_set_timeout(&buf, timeout);
 
     int _dst_worker_id = (int) dst_worker_id;
 
@@ -3345,6 +3783,7 @@ PHP_METHOD(swoole_server, taskWaitMulti)
             goto fail;
         }
         swTask_type(&buf) |= SW_TASK_WAITALL;
+        php_swoole_task_set_timeout(&buf, timeout);
         dst_worker_id = -1;
         sw_atomic_fetch_add(&serv->stats->tasking_num, 1);
         if (swProcessPool_dispatch_blocking(&serv->gs->task_workers, &buf, &dst_worker_id) < 0)
@@ -3485,6 +3924,7 @@ PHP_METHOD(swoole_server, taskCo)
             goto fail;
         }
         swTask_type(&buf) |= (SW_TASK_NONBLOCK | SW_TASK_COROUTINE);
+        php_swoole_task_set_timeout(&buf, timeout);
         dst_worker_id = -1;
         sw_atomic_fetch_add(&serv->stats->tasking_num, 1);
         if (swProcessPool_dispatch(&serv->gs->task_workers, &buf, &dst_worker_id) < 0)
@@ -3535,6 +3975,8 @@ PHP_METHOD(swoole_server, task)
     zval *callback = NULL;
 
     zend_long dst_worker_id = -1;
+    zend_long priority = 0;
+    double timeout = 0;
 
     swServer *serv = swoole_get_object(getThis());
     if (serv->gs->start == 0)
@@ -3544,20 +3986,22 @@ PHP_METHOD(swoole_server, task)
     }
 
 #ifdef FAST_ZPP
-    ZEND_PARSE_PARAMETERS_START(1, 3)
+    ZEND_PARSE_PARAMETERS_START(1, 5)
         Z_PARAM_ZVAL(data)
         Z_PARAM_OPTIONAL
         Z_PARAM_LONG(dst_worker_id)
         Z_PARAM_ZVAL(callback)
+        Z_PARAM_LONG(priority)
+        Z_PARAM_DOUBLE(timeout)
     ZEND_PARSE_PARAMETERS_END();
 #else
-    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "z|lz", &data, &dst_worker_id, &callback) == FAILURE)
+    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "z|lzld", &data, &dst_worker_id, &callback, &priority, &timeout) == FAILURE)
     {
         return;
     }
 #endif
 
-    if (php_swoole_check_task_param(serv, dst_worker_id TSRMLS_CC) < 0)
+    if (php_swoole_check_task_param(serv, dst_worker_id TSRMLS_CC) < 0 || php_swoole_check_task_priority(priority TSRMLS_CC) < 0)
     {
         RETURN_FALSE;
     }
@@ -3566,6 +4010,8 @@ PHP_METHOD(swoole_server, task)
     {
         RETURN_FALSE;
     }
+    swTask_type(&buf) |= priority << SW_TASK_PRIORITY_SHIFT;
+    php_swoole_task_set_timeout(&buf, timeout);
 
     if (callback && !ZVAL_IS_NULL(callback))
     {
@@ -3600,6 +4046,154 @@ PHP_METHOD(swoole_server, task)
     }
 }
 
+static int php_swoole_task_batch_dispatch(swServer *serv, swEventData *batch, int count, int dst_worker_id)
+{
+    sw_atomic_fetch_add(&serv->stats->tasking_num, count);
+    if (swProcessPool_dispatch(&serv->gs->task_workers, batch, &dst_worker_id) < 0)
+    {
+        sw_atomic_fetch_sub(&serv->stats->tasking_num, count);
+        return SW_ERR;
+    }
+    return SW_OK;
+}
+
+/**
+ * the tasks of a batch that failed to dispatch, their indices are not consecutive after a failed pack
+ */
+static void php_swoole_task_batch_fail(zval *return_value, int *index, int *task_id, int count)
+{
+    int j;
+    zval *callback;
+    for (j = 0; j < count; j++)
+    {
+        add_index_bool(return_value, index[j], 0);
+        callback = swHashMap_find_int(task_callbacks, task_id[j]);
+        if (callback)
+        {
+            swHashMap_del_int(task_callbacks, task_id[j]);
+            sw_zval_free(callback);
+        }
+    }
+}
+
+PHP_METHOD(swoole_server, taskBatch)
+{
+    swEventData buf;
+    swEventData batch;
+    zval *tasks;
+    zval *task;
+    zval *callback = NULL;
+
+    zend_long dst_worker_id = -1;
+
+    swServer *serv = swoole_get_object(getThis());
+    if (serv->gs->start == 0)
+    {
+        swoole_php_fatal_error(E_WARNING, "server is not running.");
+        RETURN_FALSE;
+    }
+
+    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "a|lz", &tasks, &dst_worker_id, &callback) == FAILURE)
+    {
+        return;
+    }
+
+    if (php_swoole_check_task_param(serv, dst_worker_id TSRMLS_CC) < 0)
+    {
+        RETURN_FALSE;
+    }
+
+    if (callback && ZVAL_IS_NULL(callback))
+    {
+        callback = NULL;
+    }
+#ifdef PHP_SWOOLE_CHECK_CALLBACK
+    if (callback)
+    {
+        char *func_name = NULL;
+        if (!sw_zend_is_callable(callback, 0, &func_name TSRMLS_CC))
+        {
+            swoole_php_fatal_error(E_WARNING, "function '%s' is not callable", func_name);
+            efree(func_name);
+            return;
+        }
+        efree(func_name);
+    }
+#endif
+
+    array_init(return_value);
+
+    /**
+     * the tasks are packed into one message until it is full, the stream mode sends them one by one
+     */
+    uint8_t enable_batch = !serv->gs->task_workers.use_socket;
+    batch.info.type = SW_EVENT_TASK;
+    batch.info.from_id = SwooleWG.id;
+    batch.info.len = 0;
+    swTask_type(&batch) = SW_TASK_BATCH | SW_TASK_NONBLOCK;
+
+    int i = 0, count = 0;
+    //a packed task takes its header at least
+    int batch_index[SW_BUFFER_SIZE / sizeof(swDataHead)];
+    int batch_task_id[SW_BUFFER_SIZE / sizeof(swDataHead)];
+
+    SW_HASHTABLE_FOREACH_START(Z_ARRVAL_P(tasks), task)
+        if (php_swoole_task_pack(&buf, task TSRMLS_CC) < 0)
+        {
+            add_index_bool(return_value, i, 0);
+            goto next;
+        }
+        swTask_type(&buf) |= SW_TASK_NONBLOCK;
+        if (callback)
+        {
+            swTask_type(&buf) |= SW_TASK_CALLBACK;
+            sw_zval_add_ref(&callback);
+            swHashMap_add_int(task_callbacks, buf.info.fd, sw_zval_dup(callback));
+        }
+        add_index_long(return_value, i, buf.info.fd);
+
+        if (enable_batch && swTaskWorker_batch_append(&batch, &buf) == SW_OK)
+        {
+            if (count == 0)
+            {
+                batch.info.fd = buf.info.fd;
+            }
+            batch_index[count] = i;
+            batch_task_id[count] = buf.info.fd;
+            count++;
+            goto next;
+        }
+        //full
+        if (count > 0)
+        {
+            if (php_swoole_task_batch_dispatch(serv, &batch, count, dst_worker_id) < 0)
+            {
+                php_swoole_task_batch_fail(return_value, batch_index, batch_task_id, count);
+            }
+            batch.info.len = 0;
+            count = 0;
+        }
+        if (enable_batch && swTaskWorker_batch_append(&batch, &buf) == SW_OK)
+        {
+            batch.info.fd = buf.info.fd;
+            batch_index[0] = i;
+            batch_task_id[0] = buf.info.fd;
+            count = 1;
+        }
+        //too large for a batch
+        else if (php_swoole_task_batch_dispatch(serv, &buf, 1, dst_worker_id) < 0)
+        {
+            php_swoole_task_batch_fail(return_value, &i, &buf.info.fd, 1);
+        }
+        next: i++;
+    SW_HASHTABLE_FOREACH_END();
+
+    if (count > 0 && php_swoole_task_batch_dispatch(serv, &batch, count, dst_worker_id) < 0)
+    {
+        php_swoole_task_batch_fail(return_value, batch_index, batch_task_id, count);
+    }
+}
+
 PHP_METHOD(swoole_server, sendMessage)
 {
     swEventData buf;
@@ -3631,6 +4225,12 @@ PHP_METHOD(swoole_server, sendMessage)
         RETURN_FALSE;
     }
 
+    if (!swServer_worker_is_running(serv, worker_id))
+    {
+        swoole_php_fatal_error(E_WARNING, "worker_id[%d] is stopped by the autoscaling.", (int) worker_id);
+        RETURN_FALSE;
+    }
+
     if (!serv->onPipeMessage)
     {
         swoole_php_fatal_error(E_WARNING, "onPipeMessage is null, can't use sendMessage.");
@@ -3671,7 +4271,19 @@ PHP_METHOD(swoole_server, finish)
     }
 #endif
 
-    SW_CHECK_RETURN(php_swoole_task_finish(serv, data TSRMLS_CC));
+    swDataHead *info = NULL;
+#ifdef SW_COROUTINE
+    //the result of the task which runs in the current coroutine
+    if (serv->task_enable_coroutine)
+    {
+        swTaskCoContext *context = swHashMap_find_int(task_context_map, sw_get_current_cid());
+        if (context)
+        {
+            info = &context->info;
+        }
+    }
+#endif
+    SW_CHECK_RETURN(php_swoole_task_finish(serv, data, info TSRMLS_CC));
 }
 
 PHP_METHOD(swoole_server, bind)
@@ -3828,7 +4440,7 @@ PHP_METHOD(swoole_server, connection_info)
     {
         array_init(return_value);
 
-        if (conn->uid > 0 || serv->dispatch_mode == SW_DISPATCH_UIDMOD)
+        if (conn->uid > 0 || serv->dispatch_mode == SW_DISPATCH_UIDMOD || serv->dispatch_mode == SW_DISPATCH_CHASH)
         {
             add_assoc_long(return_value, "uid", conn->uid);
         }
@@ -153,6 +153,12 @@ static PHP_METHOD(swoole_server_port, set)
         convert_to_long(v);
         port->backlog = (int) Z_LVAL_P(v);
     }
+    //max number of accept() on each wakeup
+    if (php_swoole_array_get_value(vht, "accept_batch", v))
+    {
+        convert_to_long(v);
+        port->accept_batch = Z_LVAL_P(v) > 0 ? (uint32_t) Z_LVAL_P(v) : 1;
+    }
     if (php_swoole_array_get_value(vht, "socket_buffer_size", v))
     {
         convert_to_long(v);
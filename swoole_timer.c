@@ -92,7 +92,7 @@ long php_swoole_add_timer(int ms, zval *callback, zval *param, int persistent TS
     }
     efree(func_name);
 
-    if (!swIsTaskWorker())//非task 进程 创建reator 事件loop
+    if (!swIsTaskWorker() || SwooleG.main_reactor)//非task 进程 创建reator 事件loop
     {
         php_swoole_check_reactor();
     }